@@ -1,7 +1,7 @@
 #!/bin/sh
 
 build() {
-	zig cc -fsanitize=undefined -Os -g -std=c99 -Wall -Wextra -o tzc src/main.c src/os.c
+	zig cc -fsanitize=undefined -Os -g -std=c99 -pthread -Wall -Wextra -o tzc src/main.c src/os.c
 }
 
 case "$1" in
@@ -19,12 +19,30 @@ case "$1" in
 		done
 	;;
 
+	first) set -x;
+		zig cc -std=c99 -o gen_first tools/gen_first.c src/os.c
+		./gen_first src/grammar.peg > src/ParserFirst.h
+		rm -f gen_first
+	;;
+
+	keywords) set -x;
+		zig cc -std=c99 -o gen_keywords tools/gen_keywords.c src/os.c
+		./gen_keywords > src/TokenizerKeywords.h
+		rm -f gen_keywords
+	;;
+
+	bench) set -x;
+		zig cc -std=c99 -O2 -o bench_keywords tools/bench_keywords.c src/os.c
+		./bench_keywords
+		rm -f bench_keywords
+	;;
+
 	clean) set -x;
 		rm -f tzc
 		find test -type f -name '*.zig.c' -delete
 	;;
 
 	*)
-		echo "usage: ./build.sh [build|clean]"
+		echo "usage: ./build.sh [build|test|first|keywords|bench|clean]"
 	;;
 esac
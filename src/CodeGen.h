@@ -6,7 +6,8 @@ typedef struct {
     Ctx *ctx;
 
     char *zig_h;
-    long zig_h_len;
+    size_t zig_h_len;
+    TraceBuffer *trace;
 } CodeGen;
 
 static void CodeGen_init(CodeGen *cg, Ctx *ctx, const char *output_filename, const char *zig_lib_dir)
@@ -14,6 +15,7 @@ static void CodeGen_init(CodeGen *cg, Ctx *ctx, const char *output_filename, con
     cg->ctx = ctx;
     cg->out = std_createFile(output_filename);
     cg->indent = 0;
+    cg->trace = NULL;
     if (!cg->out) std_panic(NULL, "failed to fopen output\n");
 
     size_t zig_lib_dir_len = std_strlen(zig_lib_dir);
@@ -24,10 +26,11 @@ static void CodeGen_init(CodeGen *cg, Ctx *ctx, const char *output_filename, con
     size_t len = zig_lib_dir_len;
     joined[len++] = '/';
     std_memcpy(joined + len, "zig.h", 5);
+    len += 5;
     joined[len] = 0;
 
-    cg->zig_h = std_readFile(joined, &cg->zig_h_len);
-    if (!cg->zig_h) std_panic(NULL, "failed to open %s\n", joined);
+    cg->zig_h = std_mapFile(joined, &cg->zig_h_len);
+    if (!cg->zig_h) std_panic("failed to open %s\n", joined);
 }
 
 __attribute__((format(printf, 2, 3)))
@@ -200,19 +203,28 @@ static void CodeGen_emitInst(CodeGen *cg, IrFunc *func, IrInst inst)
 
     switch (inst.op) {
         case ir_op_call:
+        {
+            uint32_t args_len;
+            const IrTempId *args = IrFunc_callArgs(func, inst, &args_len);
             CodeGen_emitType(cg, dst.type);
-            CodeGen_emit(cg, " t%d = "PRIb"(", inst.dst, Ctx_Buffer(cg->ctx, inst.data.call.fn.data.sym));
-            for (uint8_t i = 0; i < inst.data.call.args_len; i++) {
-                CodeGen_emit(cg, "t%d", inst.data.call.args[i]);
-                if (i + 1 < inst.data.call.args_len) CodeGen_emit(cg, ",");
+            CodeGen_emit(cg, " t%d = "PRIb"(", inst.dst, Ctx_Buffer(cg->ctx, inst.data.call.fn));
+            for (uint32_t i = 0; i < args_len; i++) {
+                CodeGen_emit(cg, "t%d", args[i]);
+                if (i + 1 < args_len) CodeGen_emit(cg, ",");
             }
             CodeGen_emit(cg, ");\n");
+        }
             break;
 
         case ir_op_copy:
             CodeGen_emit(cg, "t%d = t%d;\n", inst.dst, inst.data.unary.lhs);
             break;
 
+        case ir_op_cast:
+            CodeGen_emitType(cg, dst.type);
+            CodeGen_emit(cg, " t%d = t%d;\n", inst.dst, inst.data.unary.lhs);
+            break;
+
         case ir_op_negate:
             CodeGen_emitType(cg, dst.type);
             CodeGen_emit(cg, " t%d = -t%d;\n", inst.dst, inst.data.unary.lhs);
@@ -325,20 +337,25 @@ static void CodeGen_emitInst(CodeGen *cg, IrFunc *func, IrInst inst)
 
 static void CodeGen_emitTerm(CodeGen *cg, IrTerm term)
 {
-    CodeGen_indent(cg);
     switch (term.tag) {
         case ir_term_br:
+            CodeGen_indent(cg);
             CodeGen_emit(cg, "if (t%d) { goto b%d; } else { goto b%d; }\n",
                 term.data.br.cond, term.data.br.t, term.data.br.f);
             break;
 
         case ir_term_jmp:
+            CodeGen_indent(cg);
             CodeGen_emit(cg, "goto b%d;\n", term.data.jmp.target);
             break;
 
         case ir_term_ret:
+            CodeGen_indent(cg);
             CodeGen_emit(cg, "return t%d;\n", term.data.ret.value);
+            break;
+
         case ir_term_next:
+            // falls through to the next label, nothing to emit
             break;
     }
 }
@@ -347,14 +364,16 @@ static void CodeGen_emitBlock(CodeGen *cg, IrFunc *func, IrBlockId id, IrBlock *
 {
     // jump targets can be empty, hence emit an empty statement unconditionally
     CodeGen_emit(cg, "b%d:;\n", id);
-    for (uint32_t i = 0; i < block->insts.len; i++) {
-        CodeGen_emitInst(cg, func, block->insts.data[i]);
+    const IrInst *insts = IrFunc_blockInsts(func, block);
+    for (uint32_t i = 0; i < block->len; i++) {
+        CodeGen_emitInst(cg, func, insts[i]);
     }
     CodeGen_emitTerm(cg, block->term);
 }
 
 static void CodeGen_emitFuncDef(CodeGen *cg, IrFunc *func)
 {
+    uint64_t trace_start = Trace_begin(cg->trace);
     CodeGen_emitFuncDecl(cg, func);
     CodeGen_emit(cg, "\n{\n");
 
@@ -369,10 +388,11 @@ static void CodeGen_emitFuncDef(CodeGen *cg, IrFunc *func)
     }
 
     for (uint32_t i = 0; i < func->blocks.len; i++) {
-        CodeGen_emitBlock(cg, func, i, func->blocks.data[i]);
+        CodeGen_emitBlock(cg, func, i, &func->blocks.data[i]);
     }
 
     CodeGen_emit(cg, "}\n\n");
+    Trace_end(cg->trace, trace_start, "emit fn", trace_arg_intern, func->name, 0);
 }
 
 static void CodeGen_emitModule(CodeGen *cg, IrProgram *ir)
@@ -397,4 +417,12 @@ static void CodeGen_emitModule(CodeGen *cg, IrProgram *ir)
 static void CodeGen_gen(CodeGen *cg, IrProgram *ir)
 {
     CodeGen_emitModule(cg, ir);
+    std_unmapFile(cg->zig_h, cg->zig_h_len);
+}
+
+// Flush and close the output file.
+static void CodeGen_finish(CodeGen *cg)
+{
+    std_closeFile(cg->out);
+    cg->out = NULL;
 }
\ No newline at end of file
@@ -8,7 +8,10 @@ typedef struct Ctx Ctx;
 
 // String Interner.
 //
-// This is implemented as a simplistic hash-based linear scan.
+// Entries are stored densely and indexed by sInternId. Lookups go through an
+// open-addressing (linear probe) table of ids which is kept at most half full
+// and doubled on growth. Id 0 is reserved for the empty buffer and doubles as
+// the empty slot marker.
 
 typedef uint32_t sInternId;
 typedef uint32_t tInternId;
@@ -24,6 +27,13 @@ DEFINE_ARRAY(sInternEntry);
 
 typedef struct {
     sInternEntryArray entries;
+    sInternId *slots;
+    uint32_t slots_cap;         // power of two
+
+    // statistics, reported under -report
+    uint64_t lookups;
+    uint64_t probes;
+    uint32_t max_probe;
 } sIntern;
 
 // Type Interner.
@@ -67,6 +77,9 @@ typedef enum {
     ty_complex,
 } tTypeTag;
 
+// primitive tags are registered first at Ctx_init so their tInternId equals their tag
+#define ty_primitive_count (ty_f128 + 1)
+
 const char* tTypeTag_Name(tTypeTag tag)
 {
     switch (tag) {
@@ -168,63 +181,48 @@ typedef struct {
     bool is_signed;
 } tTypeInfo;
 
-static tTypeInfo tType_info(tType type)
+// Info for each primitive tag. Primitive tags double as their tInternId, see Ctx_init.
+static const tTypeInfo tTypeInfo_primitives[ty_primitive_count] = {
+    [ty_anyopaque]      = { .class = class_other },
+    [ty_bool]           = { .class = class_other },
+    [ty_u8]             = { .class = class_int, .bits = 8, .is_signed = false },
+    [ty_i8]             = { .class = class_int, .bits = 8, .is_signed = true },
+    [ty_u16]            = { .class = class_int, .bits = 16, .is_signed = false },
+    [ty_i16]            = { .class = class_int, .bits = 16, .is_signed = true },
+    [ty_u32]            = { .class = class_int, .bits = 32, .is_signed = false },
+    [ty_i32]            = { .class = class_int, .bits = 32, .is_signed = true },
+    [ty_usize]          = { .class = class_int, .bits = 64, .is_signed = false }, // platform-specific
+    [ty_isize]          = { .class = class_int, .bits = 64, .is_signed = true }, // platform-specific
+    [ty_u64]            = { .class = class_int, .bits = 64, .is_signed = false },
+    [ty_i64]            = { .class = class_int, .bits = 64, .is_signed = true },
+    [ty_u128]           = { .class = class_int, .bits = 128, .is_signed = false },
+    [ty_i128]           = { .class = class_int, .bits = 128, .is_signed = true },
+    [ty_c_char]         = { .class = class_int, .bits = 8, .is_signed = false }, // platform-specific
+    [ty_c_short]        = { .class = class_int, .bits = 16, .is_signed = true }, // platform-specific
+    [ty_c_ushort]       = { .class = class_int, .bits = 16, .is_signed = false }, // platform-specific
+    [ty_c_int]          = { .class = class_int, .bits = 32, .is_signed = true }, // platform-specific
+    [ty_c_uint]         = { .class = class_int, .bits = 32, .is_signed = false }, // platform-specific
+    [ty_c_long]         = { .class = class_int, .bits = 64, .is_signed = true }, // platform-specific
+    [ty_c_ulong]        = { .class = class_int, .bits = 64, .is_signed = false }, // platform-specific
+    [ty_c_longlong]     = { .class = class_int, .bits = 64, .is_signed = true }, // platform-specific
+    [ty_c_ulonglong]    = { .class = class_int, .bits = 64, .is_signed = false }, // platform-specific
+    [ty_f16]            = { .class = class_float, .bits = 16 },
+    [ty_f32]            = { .class = class_float, .bits = 32 },
+    [ty_f64]            = { .class = class_float, .bits = 64 },
+    [ty_f80]            = { .class = class_float, .bits = 80 },
+    [ty_c_longdouble]   = { .class = class_float, .bits = 80 }, // platform-specific
+    [ty_f128]           = { .class = class_float, .bits = 128 },
+};
+
+// Only called once per unique type, lookups go through Ctx_getTypeInfo.
+static tTypeInfo tType_computeInfo(tType type)
 {
+    if (type.tag < ty_primitive_count) return tTypeInfo_primitives[type.tag];
+
     switch (type.tag) {
-        case ty_u8:
-            return (tTypeInfo){ .class = class_int, .bits = 8, .is_signed = false };
-        case ty_u16:
-            return (tTypeInfo){ .class = class_int, .bits = 16, .is_signed = false };
-        case ty_u32:
-            return (tTypeInfo){ .class = class_int, .bits = 32, .is_signed = false };
-        case ty_u64:
-            return (tTypeInfo){ .class = class_int, .bits = 64, .is_signed = false };
-        case ty_u128:
-            return (tTypeInfo){ .class = class_int, .bits = 128, .is_signed = false };
-        case ty_i8:
-            return (tTypeInfo){ .class = class_int, .bits = 8, .is_signed = true };
-        case ty_i16:
-            return (tTypeInfo){ .class = class_int, .bits = 16, .is_signed = true };
-        case ty_i32:
-            return (tTypeInfo){ .class = class_int, .bits = 32, .is_signed = true };
-        case ty_i64:
-            return (tTypeInfo){ .class = class_int, .bits = 64, .is_signed = true };
-        case ty_i128:
-            return (tTypeInfo){ .class = class_int, .bits = 128, .is_signed = true };
-        case ty_isize:
-            return (tTypeInfo){ .class = class_int, .bits = 64, .is_signed = true }; // platform-specific
-        case ty_usize:
-            return (tTypeInfo){ .class = class_int, .bits = 64, .is_signed = false }; // platform-specific
-        case ty_c_char:
-            return (tTypeInfo){ .class = class_int, .bits = 8, .is_signed = false }; // platform-specific
-        case ty_c_short:
-            return (tTypeInfo){ .class = class_int, .bits = 16, .is_signed = true }; // platform-specific
-        case ty_c_ushort:
-            return (tTypeInfo){ .class = class_int, .bits = 16, .is_signed = false }; // platform-specific
-        case ty_c_int:
-            return (tTypeInfo){ .class = class_int, .bits = 32, .is_signed = true }; // platform-specific
-        case ty_c_uint:
-            return (tTypeInfo){ .class = class_int, .bits = 32, .is_signed = false }; // platform-specific
-        case ty_c_long:
-            return (tTypeInfo){ .class = class_int, .bits = 64, .is_signed = true }; // platform-specific
-        case ty_c_ulong:
-            return (tTypeInfo){ .class = class_int, .bits = 64, .is_signed = false }; // platform-specific
         case ty_int:
             return (tTypeInfo){ .class = class_int, .bits = type.data.int_.bits, .is_signed = type.data.int_.is_signed };
 
-        case ty_c_longdouble:
-            return (tTypeInfo){ .class = class_float, .bits = 80, .is_signed = false }; // platform-specific
-        case ty_f16:
-            return (tTypeInfo){ .class = class_float, .bits = 16, .is_signed = false };
-        case ty_f32:
-            return (tTypeInfo){ .class = class_float, .bits = 32, .is_signed = false };
-        case ty_f64:
-            return (tTypeInfo){ .class = class_float, .bits = 64, .is_signed = false };
-        case ty_f80:
-            return (tTypeInfo){ .class = class_float, .bits = 80, .is_signed = false };
-        case ty_f128:
-            return (tTypeInfo){ .class = class_float, .bits = 128, .is_signed = false };
-
         case ty_ptr_one:
         case ty_ptr_two:
             return (tTypeInfo){ .class = class_ptr };
@@ -283,9 +281,15 @@ typedef struct {
 } tInternEntry;
 
 DEFINE_ARRAY(tInternEntry);
+DEFINE_ARRAY(tTypeInfo);
 
+// Hash-consed like the string interner, with ty_invalid_id marking empty slots
+// since primitives occupy ids from 0.
 typedef struct {
     tInternEntryArray entries;
+    tTypeInfoArray infos;       // parallel to entries
+    tInternId *slots;
+    uint32_t slots_cap;         // power of two
 } tIntern;
 
 struct Ctx {
@@ -304,17 +308,57 @@ static uint64_t Ctx_hashString(Buffer b)
     return h;
 }
 
+static void Ctx_growStrings(Ctx *ctx)
+{
+    sIntern *s = &ctx->strings;
+    uint32_t cap = s->slots_cap * 2;
+    sInternId *slots = std_malloc(sizeof(sInternId) * cap);
+    if (!slots) std_panic("oom");
+    for (uint32_t i = 0; i < cap; i++) slots[i] = 0;
+
+    // ids are unique so reinsertion never needs to compare buffers
+    for (uint32_t i = 0; i < s->slots_cap; i++) {
+        sInternId id = s->slots[i];
+        if (id == 0) continue;
+        uint32_t j = (uint32_t)s->entries.data[id].hash & (cap - 1);
+        while (slots[j] != 0) j = (j + 1) & (cap - 1);
+        slots[j] = id;
+    }
+
+    std_free(s->slots);
+    s->slots = slots;
+    s->slots_cap = cap;
+}
+
 static sInternId Ctx_putString(Ctx *ctx, Buffer buffer)
 {
+    if (buffer.len == 0) return 0;
+
+    sIntern *s = &ctx->strings;
     uint64_t hash = Ctx_hashString(buffer);
-    for (uint32_t i = 0 ; i < ctx->strings.entries.len; i++) {
-        sInternEntry e = ctx->strings.entries.data[i];
-        if (e.hash != hash) continue;
-        if (Buffer_eqlBuffer(e.buffer, buffer)) return (sInternId)i;
+    uint32_t mask = s->slots_cap - 1;
+    uint32_t i = (uint32_t)hash & mask;
+    uint32_t probe = 1;
+
+    s->lookups++;
+    for (;; i = (i + 1) & mask, probe++) {
+        sInternId id = s->slots[i];
+        if (id == 0) break;
+        sInternEntry e = s->entries.data[id];
+        if (e.hash == hash && Buffer_eqlBuffer(e.buffer, buffer)) {
+            s->probes += probe;
+            if (probe > s->max_probe) s->max_probe = probe;
+            return id;
+        }
     }
+    s->probes += probe;
+    if (probe > s->max_probe) s->max_probe = probe;
 
     sInternEntry en = { .buffer = buffer, .hash = hash };
-    return (sInternId)sInternEntryArray_append(&ctx->strings.entries, en);
+    sInternId id = (sInternId)sInternEntryArray_append(&s->entries, en);
+    s->slots[i] = id;
+    if (2 * (s->entries.len - 1) > s->slots_cap) Ctx_growStrings(ctx);
+    return id;
 }
 
 // e.g. printf("buffer: "PRIb, Ctx_Buffer(r->ctx, id))
@@ -377,17 +421,52 @@ static uint64_t Ctx_hashType(tType ty)
     return hash;
 }
 
+static uint32_t Ctx_typeSlot(uint64_t hash, uint32_t cap)
+{
+    // Ctx_hashType packs fields without mixing, so spread them before masking
+    return (uint32_t)((hash * 0x9e3779b97f4a7c15ull) >> 32) & (cap - 1);
+}
+
+static void Ctx_growTypes(Ctx *ctx)
+{
+    tIntern *t = &ctx->types;
+    uint32_t cap = t->slots_cap * 2;
+    tInternId *slots = std_malloc(sizeof(tInternId) * cap);
+    if (!slots) std_panic("oom");
+    for (uint32_t i = 0; i < cap; i++) slots[i] = ty_invalid_id;
+
+    for (uint32_t i = 0; i < t->slots_cap; i++) {
+        tInternId id = t->slots[i];
+        if (id == ty_invalid_id) continue;
+        uint32_t j = Ctx_typeSlot(t->entries.data[id].hash, cap);
+        while (slots[j] != ty_invalid_id) j = (j + 1) & (cap - 1);
+        slots[j] = id;
+    }
+
+    std_free(t->slots);
+    t->slots = slots;
+    t->slots_cap = cap;
+}
+
 static tInternId Ctx_putType(Ctx *ctx, tType ty)
 {
+    if (ty.tag < ty_primitive_count) return (tInternId)ty.tag;
+
+    tIntern *t = &ctx->types;
     uint64_t hash = Ctx_hashType(ty);
-    for (uint32_t i = 0 ; i < ctx->types.entries.len; i++) {
-        tInternEntry e = ctx->types.entries.data[i];
-        if (e.hash != hash) continue;
-        if (tType_eql(e.ty, ty)) return (tInternId)i;
+    uint32_t mask = t->slots_cap - 1;
+    uint32_t i = Ctx_typeSlot(hash, t->slots_cap);
+    for (; t->slots[i] != ty_invalid_id; i = (i + 1) & mask) {
+        tInternEntry e = t->entries.data[t->slots[i]];
+        if (e.hash == hash && tType_eql(e.ty, ty)) return t->slots[i];
     }
 
     tInternEntry en = { .ty = ty, .hash = hash };
-    return (tInternId)tInternEntryArray_append(&ctx->types.entries, en);
+    tInternId id = (tInternId)tInternEntryArray_append(&t->entries, en);
+    tTypeInfoArray_append(&t->infos, tType_computeInfo(ty));
+    t->slots[i] = id;
+    if (2 * t->entries.len > t->slots_cap) Ctx_growTypes(ctx);
+    return id;
 }
 
 static tType Ctx_getType(Ctx *ctx, tInternId id)
@@ -395,12 +474,38 @@ static tType Ctx_getType(Ctx *ctx, tInternId id)
     return ctx->types.entries.data[id].ty;
 }
 
+static tTypeInfo Ctx_getTypeInfo(Ctx *ctx, tInternId id)
+{
+    return ctx->types.infos.data[id];
+}
+
 // Compile context.
 
 static void Ctx_init(Ctx *ctx)
 {
-    sInternEntryArray_init(&ctx->strings.entries);
-    Ctx_putString(ctx, Buffer_empty()); // reserve empty buffer as id 0
-
-    tInternEntryArray_init(&ctx->types.entries);
+    sIntern *s = &ctx->strings;
+    sInternEntryArray_init(&s->entries);
+    sInternEntryArray_append(&s->entries, (sInternEntry){ .buffer = Buffer_empty(), .hash = 0 }); // reserve empty buffer as id 0
+    s->slots_cap = 64;
+    s->slots = std_malloc(sizeof(sInternId) * s->slots_cap);
+    if (!s->slots) std_panic("oom");
+    for (uint32_t i = 0; i < s->slots_cap; i++) s->slots[i] = 0;
+    s->lookups = 0;
+    s->probes = 0;
+    s->max_probe = 0;
+
+    tIntern *t = &ctx->types;
+    tInternEntryArray_init(&t->entries);
+    tTypeInfoArray_init(&t->infos);
+    t->slots_cap = 64;
+    t->slots = std_malloc(sizeof(tInternId) * t->slots_cap);
+    if (!t->slots) std_panic("oom");
+    for (uint32_t i = 0; i < t->slots_cap; i++) t->slots[i] = ty_invalid_id;
+
+    // primitives are never hashed, Ctx_putType maps them directly to these ids
+    for (uint32_t tag = 0; tag < ty_primitive_count; tag++) {
+        tType ty = { .tag = (tTypeTag)tag };
+        tInternEntryArray_append(&t->entries, (tInternEntry){ .ty = ty, .hash = Ctx_hashType(ty) });
+        tTypeInfoArray_append(&t->infos, tTypeInfo_primitives[tag]);
+    }
 }
\ No newline at end of file
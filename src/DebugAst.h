@@ -1,11 +1,11 @@
 typedef struct DebugAst {
-    const Parser *p;
+    const Ast *ast;
     int indent;
 } DebugAst;
 
-static void DebugAst_init(DebugAst *r, Parser *p)
+static void DebugAst_init(DebugAst *r, const Ast *ast)
 {
-    r->p = p;
+    r->ast = ast;
     r->indent = 0;
 }
 
@@ -31,26 +31,27 @@ static void DebugAst_endSection(DebugAst *r)
     r->indent--;
 }
 
-static void DebugAst_render(DebugAst *r, Node *n)
+static void DebugAst_render(DebugAst *r, NodeIndex index)
 {
-    if (!n) return;
+    if (!index) return;
+    const Node *n = Ast_node(r->ast, index);
 
     switch (n->tag)
     {
         case node_container_members:
             DebugAst_beginSection(r, "node_container_members");
             for (uint32_t i = 0; i < n->data.container_members.decls_len; i++) {
-                DebugAst_render(r, n->data.container_members.decls[i]);
+                DebugAst_render(r, Ast_list(r->ast, n->data.container_members.decls)[i]);
             }
             for (uint32_t i = 0; i < n->data.container_members.fields_len; i++) {
-                DebugAst_render(r, n->data.container_members.fields[i]);
+                DebugAst_render(r, Ast_list(r->ast, n->data.container_members.fields)[i]);
             }
             DebugAst_endSection(r);
             break;
 
         case node_container_field:
             DebugAst_beginSection(r, "node_container_field");
-            DebugAst_p(r, "name: "PRIb, Buffer(n->data.container_field.name));
+            DebugAst_p(r, "name: "PRIb, Buffer(Ast_tokenSlice(r->ast, n->data.container_field.name)));
             DebugAst_p(r, "is_comptime: %d", n->data.container_field.is_comptime);
             DebugAst_render(r, n->data.container_field.expr);
             DebugAst_render(r, n->data.container_field.type_expr);
@@ -59,7 +60,7 @@ static void DebugAst_render(DebugAst *r, Node *n)
 
         case node_test_decl:
             DebugAst_beginSection(r, "test_decl");
-            DebugAst_p(r, "name: "PRIb, Buffer(n->data.test_decl.name));
+            DebugAst_p(r, "name: "PRIb, Buffer(Ast_tokenSlice(r->ast, n->data.test_decl.name)));
             DebugAst_p(r, "is_ident: %d", n->data.test_decl.is_ident);
             DebugAst_render(r, n->data.test_decl.block);
             DebugAst_endSection(r);
@@ -73,7 +74,7 @@ static void DebugAst_render(DebugAst *r, Node *n)
 
         case node_var_decl_proto:
             DebugAst_beginSection(r, "var_decl_proto");
-            DebugAst_p(r, "name: "PRIb, Buffer(n->data.var_decl_proto.name));
+            DebugAst_p(r, "name: "PRIb, Buffer(Ast_tokenSlice(r->ast, n->data.var_decl_proto.name)));
             DebugAst_p(r, "is_const: %d", n->data.var_decl_proto.is_const);
             DebugAst_render(r, n->data.var_decl_proto.type);
             DebugAst_endSection(r);
@@ -102,14 +103,20 @@ static void DebugAst_render(DebugAst *r, Node *n)
         case node_block:
             DebugAst_beginSection(r, "block");
             for (uint32_t i = 0; i < n->data.block.statements_len; i++) {
-                DebugAst_render(r, n->data.block.statements[i]);
+                DebugAst_render(r, Ast_list(r->ast, n->data.block.statements)[i]);
             }
             DebugAst_endSection(r);
             break;
 
+        case node_lazy_block:
+            DebugAst_beginSection(r, "lazy_block");
+            DebugAst_p(r, "tokens: %u..%u", n->data.lazy_block.l_brace, n->data.lazy_block.r_brace);
+            DebugAst_endSection(r);
+            break;
+
         case node_fn_proto:
             DebugAst_beginSection(r, "fn_proto");
-            DebugAst_p(r, "name: "PRIb, Buffer(n->data.fn_proto.name));
+            DebugAst_p(r, "name: "PRIb, Buffer(Ast_tokenSlice(r->ast, n->data.fn_proto.name)));
             DebugAst_render(r, n->data.fn_proto.params);
             DebugAst_render(r, n->data.fn_proto.return_type);
             DebugAst_endSection(r);
@@ -121,14 +128,14 @@ static void DebugAst_render(DebugAst *r, Node *n)
         case node_param_decl_list:
             DebugAst_beginSection(r, "param_decl_list");
             for (uint32_t i = 0; i < n->data.param_decl_list.params_len; i++) {
-                DebugAst_render(r, n->data.param_decl_list.params[i]);
+                DebugAst_render(r, Ast_list(r->ast, n->data.param_decl_list.params)[i]);
             }
             DebugAst_endSection(r);
             break;
 
         case node_param_decl:
             DebugAst_beginSection(r, "param_decl");
-            DebugAst_p(r, "name: "PRIb, Buffer(n->data.param_decl.identifier));
+            DebugAst_p(r, "name: "PRIb, Buffer(Ast_tokenSlice(r->ast, n->data.param_decl.identifier)));
             DebugAst_p(r, "is_varargs: %d", n->data.param_decl.is_varargs);
             if (n->data.param_decl.modifier != token_invalid) {
                 DebugAst_p(r, "modifier: %s", TokenTag_name(n->data.param_decl.modifier));
@@ -141,13 +148,13 @@ static void DebugAst_render(DebugAst *r, Node *n)
             DebugAst_beginSection(r, "type_expr");
             DebugAst_render(r, n->data.type_expr.type_expr);
             for (uint32_t i = 0; i < n->data.type_expr.prefix_type_ops_len; i++) {
-                DebugAst_render(r, n->data.type_expr.prefix_type_ops[i]);
+                DebugAst_render(r, Ast_list(r->ast, n->data.type_expr.prefix_type_ops)[i]);
             }
             DebugAst_endSection(r);
             break;
 
         case node_error_union_expr:
-            if (n->data.error_union_expr.error_type_expr == NULL) {
+            if (n->data.error_union_expr.error_type_expr == NODE_NONE) {
                 DebugAst_render(r, n->data.error_union_expr.suffix_expr);
                 return;
             }
@@ -167,7 +174,7 @@ static void DebugAst_render(DebugAst *r, Node *n)
             DebugAst_beginSection(r, "suffix_expr");
             DebugAst_render(r, n->data.suffix_expr.expr);
             for (uint32_t i = 0; i < n->data.suffix_expr.suffixes_len; i++) {
-                DebugAst_render(r, n->data.suffix_expr.suffixes[i]);
+                DebugAst_render(r, Ast_list(r->ast, n->data.suffix_expr.suffixes)[i]);
             }
             DebugAst_endSection(r);
             break;
@@ -198,7 +205,7 @@ static void DebugAst_render(DebugAst *r, Node *n)
 
         case node_errdefer_statement:
             DebugAst_beginSection(r, "errdefer_statement");
-            DebugAst_p(r, "payload: "PRIb, Buffer(n->data.errdefer_statement.payload_name));
+            DebugAst_p(r, "payload: "PRIb, Buffer(Ast_tokenSlice(r->ast, n->data.errdefer_statement.payload_name)));
             DebugAst_render(r, n->data.errdefer_statement.block_expr);
             DebugAst_endSection(r);
             break;
@@ -213,7 +220,7 @@ static void DebugAst_render(DebugAst *r, Node *n)
             if (n->data.unary_expr.ops_len > 0) {
                 DebugAst_beginSection(r, "ops");
                 for (uint32_t i = 0; i < n->data.unary_expr.ops_len; i++) {
-                    DebugAst_p(r, "%d", n->data.unary_expr.ops[i]);
+                    DebugAst_p(r, "%d", Ast_list(r->ast, n->data.unary_expr.ops)[i]);
                 }
                 DebugAst_endSection(r);
             }
@@ -264,12 +271,12 @@ static void DebugAst_render(DebugAst *r, Node *n)
             DebugAst_beginSection(r, "primary_type_expr");
             switch (n->data.primary_type_expr.tag) {
                 case node_primary_type_builtin:
-                    DebugAst_p(r, "builtin: "PRIb, Buffer(n->data.primary_type_expr.data.raw));
-                    DebugAst_render(r, n->data.primary_type_expr.data.node);
+                    DebugAst_p(r, "builtin: "PRIb, Buffer(Ast_tokenSlice(r->ast, n->data.primary_type_expr.data.builtin.name)));
+                    DebugAst_render(r, n->data.primary_type_expr.data.builtin.args);
                     break;
 
                 case node_primary_type_identifier:
-                    DebugAst_p(r, "identifier: "PRIb, Buffer(n->data.primary_type_expr.data.raw));
+                    DebugAst_p(r, "identifier: "PRIb, Buffer(Ast_tokenSlice(r->ast, n->data.primary_type_expr.data.raw)));
                     break;
 
                 case node_primary_type_char_literal:
@@ -277,7 +284,7 @@ static void DebugAst_render(DebugAst *r, Node *n)
                 case node_primary_type_number_literal:
                 case node_primary_type_error:
                 case node_primary_type_string_literal:
-                    DebugAst_p(r, "literal: "PRIb, Buffer(n->data.primary_type_expr.data.raw));
+                    DebugAst_p(r, "literal: "PRIb, Buffer(Ast_tokenSlice(r->ast, n->data.primary_type_expr.data.raw)));
                     break;
 
                 case node_primary_type_container_decl:
@@ -324,14 +331,14 @@ static void DebugAst_render(DebugAst *r, Node *n)
         case node_for_args:
             DebugAst_beginSection(r, "for_args");
             for (uint32_t i = 0; i < n->data.for_args.args_len; i++) {
-                DebugAst_render(r, n->data.for_args.args[i]);
+                DebugAst_render(r, Ast_list(r->ast, n->data.for_args.args)[i]);
             }
             DebugAst_endSection(r);
             break;
 
         case node_field_init:
             DebugAst_beginSection(r, "field_init");
-            DebugAst_p(r, "name: "PRIb, Buffer(n->data.field_init.name));
+            DebugAst_p(r, "name: "PRIb, Buffer(Ast_tokenSlice(r->ast, n->data.field_init.name)));
             DebugAst_render(r, n->data.field_init.expr);
             DebugAst_endSection(r);
             break;
@@ -385,8 +392,8 @@ static void DebugAst_render(DebugAst *r, Node *n)
             DebugAst_beginSection(r, "while_statement");
             DebugAst_render(r, n->data.while_statement.condition);
             DebugAst_render(r, n->data.while_statement.block);
-            if (n->data.while_statement.else_payload_name.len != 0) {
-                DebugAst_p(r, "else_payload_name: "PRIb, Buffer(n->data.while_statement.else_payload_name));
+            if (n->data.while_statement.else_payload_name != TOKEN_NONE) {
+                DebugAst_p(r, "else_payload_name: "PRIb, Buffer(Ast_tokenSlice(r->ast, n->data.while_statement.else_payload_name)));
             }
             DebugAst_render(r, n->data.while_statement.else_statement);
             DebugAst_endSection(r);
@@ -405,21 +412,21 @@ static void DebugAst_render(DebugAst *r, Node *n)
             DebugAst_beginSection(r, "if_statement");
             DebugAst_render(r, n->data.if_statement.condition);
             DebugAst_render(r, n->data.if_statement.block);
-            if (n->data.if_statement.else_payload_name.len != 0) {
-                DebugAst_p(r, "else_payload_name: "PRIb, Buffer(n->data.if_statement.else_payload_name));
+            if (n->data.if_statement.else_payload_name != TOKEN_NONE) {
+                DebugAst_p(r, "else_payload_name: "PRIb, Buffer(Ast_tokenSlice(r->ast, n->data.if_statement.else_payload_name)));
             }
             DebugAst_render(r, n->data.if_statement.else_statement);
             DebugAst_endSection(r);
             break;
 
         case node_labeled_statement:
-            if (n->data.labeled_statement.label.len == 0) {
+            if (n->data.labeled_statement.label == TOKEN_NONE) {
                 DebugAst_render(r, n->data.labeled_statement.statement);
                 return;
             }
 
             DebugAst_beginSection(r, "labeled_statement");
-            DebugAst_p(r, "label: "PRIb, Buffer(n->data.labeled_statement.label));
+            DebugAst_p(r, "label: "PRIb, Buffer(Ast_tokenSlice(r->ast, n->data.labeled_statement.label)));
             DebugAst_render(r, n->data.labeled_statement.statement);
             DebugAst_endSection(r);
             break;
@@ -428,8 +435,8 @@ static void DebugAst_render(DebugAst *r, Node *n)
             DebugAst_beginSection(r, "if_expr");
             DebugAst_render(r, n->data.if_expr.condition);
             DebugAst_render(r, n->data.if_expr.expr);
-            if (n->data.if_expr.else_payload_name.len != 0) {
-                DebugAst_p(r, "else_payload_name: "PRIb, Buffer(n->data.if_expr.else_payload_name));
+            if (n->data.if_expr.else_payload_name != TOKEN_NONE) {
+                DebugAst_p(r, "else_payload_name: "PRIb, Buffer(Ast_tokenSlice(r->ast, n->data.if_expr.else_payload_name)));
             }
             DebugAst_render(r, n->data.if_expr.else_payload_expr);
             DebugAst_endSection(r);
@@ -440,7 +447,7 @@ static void DebugAst_render(DebugAst *r, Node *n)
             DebugAst_render(r, n->data.var_decl_statement.var_decl);
             DebugAst_render(r, n->data.var_decl_statement.expr);
             for (uint32_t i = 0; i < n->data.var_decl_statement.var_decl_additional_len; i++) {
-                DebugAst_render(r, n->data.var_decl_statement.var_decl_additional[i]);
+                DebugAst_render(r, Ast_list(r->ast, n->data.var_decl_statement.var_decl_additional)[i]);
             }
             DebugAst_endSection(r);
             break;
@@ -565,7 +572,7 @@ static void DebugAst_render(DebugAst *r, Node *n)
 
         case node_suffix_type_op_named_access:
             DebugAst_beginSection(r, "suffix_member");
-            DebugAst_p(r, "."PRIb, Buffer(n->data.suffix_type_op_named_access.name));
+            DebugAst_p(r, "."PRIb, Buffer(Ast_tokenSlice(r->ast, n->data.suffix_type_op_named_access.name)));
             DebugAst_endSection(r);
             break;
 
@@ -586,7 +593,7 @@ static void DebugAst_render(DebugAst *r, Node *n)
 
             DebugAst_beginSection(r, "fn_call_arguments");
             for (uint32_t i = 0; i < n->data.fn_call_arguments.exprs_len; i++) {
-                DebugAst_render(r, n->data.fn_call_arguments.exprs[i]);
+                DebugAst_render(r, Ast_list(r->ast, n->data.fn_call_arguments.exprs)[i]);
             }
             DebugAst_endSection(r);
             break;
@@ -615,7 +622,7 @@ static void DebugAst_render(DebugAst *r, Node *n)
 
         case node_payload:
             DebugAst_beginSection(r, "payload");
-            DebugAst_p(r, "name: %s"PRIb, n->data.payload.is_pointer ? "*" : "", Buffer(n->data.payload.name));
+            DebugAst_p(r, "name: %s"PRIb, n->data.payload.is_pointer ? "*" : "", Buffer(Ast_tokenSlice(r->ast, n->data.payload.name)));
             DebugAst_endSection(r);
             break;
 
@@ -627,7 +634,7 @@ static void DebugAst_render(DebugAst *r, Node *n)
         case node_payload_list:
             DebugAst_beginSection(r, "payload_list");
             for (uint32_t i = 0; i < n->data.payload_list.payloads_len; i++) {
-                DebugAst_render(r, n->data.payload_list.payloads[i]);
+                DebugAst_render(r, Ast_list(r->ast, n->data.payload_list.payloads)[i]);
             }
             DebugAst_endSection(r);
             break;
@@ -680,7 +687,7 @@ static void DebugAst_render(DebugAst *r, Node *n)
 
             DebugAst_beginSection(r, "node_init_list_field");
             for (uint32_t i = 0; i < n->data.init_list_field.nodes_len; i++) {
-                DebugAst_render(r, n->data.init_list_field.nodes[i]);
+                DebugAst_render(r, Ast_list(r->ast, n->data.init_list_field.nodes)[i]);
             }
             DebugAst_endSection(r);
             break;
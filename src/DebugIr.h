@@ -38,11 +38,27 @@ static void DebugIr_renderInst(DebugIr *r, IrFunc *func, IrInst inst)
 
     switch (inst.op) {
         case ir_op_call:
-            DebugIr_p(r, "%s %d "PRIb, IrOp_name(inst.op), inst.dst, Ctx_Buffer(r->ctx, inst.data.call.fn.data.sym));
-            for (uint8_t i = 0; i < inst.data.call.args_len; i++) {
-                DebugIr_p(r, " %d", inst.data.call.args[i]);
+        {
+            uint32_t args_len;
+            const IrTempId *args = IrFunc_callArgs(func, inst, &args_len);
+            DebugIr_p(r, "%s %d "PRIb, IrOp_name(inst.op), inst.dst, Ctx_Buffer(r->ctx, inst.data.call.fn));
+            for (uint32_t i = 0; i < args_len; i++) {
+                DebugIr_p(r, " %d", args[i]);
             }
             DebugIr_p(r, "\n");
+        }
+            break;
+
+        case ir_op_phi:
+        {
+            uint32_t len = func->extra.data[inst.data.phi.args];
+            const uint32_t *args = &func->extra.data[inst.data.phi.args + 1];
+            DebugIr_p(r, "%s %d v%d", IrOp_name(inst.op), inst.dst, inst.data.phi.var);
+            for (uint32_t i = 0; i < len; i++) {
+                DebugIr_p(r, " [b%d %d]", args[2 * i], args[2 * i + 1]);
+            }
+            DebugIr_p(r, "\n");
+        }
             break;
 
         case ir_op_invalid:
@@ -50,6 +66,7 @@ static void DebugIr_renderInst(DebugIr *r, IrFunc *func, IrInst inst)
             DebugIr_p(r, "%s\n", IrOp_name(inst.op));
             break;
 
+        case ir_op_cast:
         case ir_op_negate:
         case ir_op_bw_not:
         case ir_op_bw_and:
@@ -123,8 +140,9 @@ static void DebugIr_renderBlock(DebugIr *r, IrFunc *func, IrBlockId id, IrBlock
     DebugIr_indent(r);
     DebugIr_p(r, "b%d:\n", id);
     r->indent++;
-    for (uint32_t i = 0; i < block->insts.len; i++) {
-        DebugIr_renderInst(r, func, block->insts.data[i]);
+    const IrInst *insts = IrFunc_blockInsts(func, block);
+    for (uint32_t i = 0; i < block->len; i++) {
+        DebugIr_renderInst(r, func, insts[i]);
     }
     DebugIr_renderTerm(r, block->term);
     r->indent--;
@@ -135,7 +153,7 @@ static void DebugIr_renderFunc(DebugIr *r, IrFunc *func)
     DebugIr_p(r, PRIb":\n", Ctx_Buffer(r->ctx, func->name));
     r->indent++;
     for (uint32_t i = 0; i < func->blocks.len; i++) {
-        DebugIr_renderBlock(r, func, i, func->blocks.data[i]);
+        DebugIr_renderBlock(r, func, i, &func->blocks.data[i]);
     }
     DebugIr_p(r, "\n");
     r->indent--;
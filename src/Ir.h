@@ -17,23 +17,6 @@ typedef struct {
 
 #define ir_invalid_id (~(uint32_t)0)
 
-typedef enum {
-    ir_val_tmp,
-    ir_val_imm64,
-    ir_val_sym,
-} IrValueTag;
-
-typedef union {
-    IrTempId tmp;
-    uint64_t val_imm64;
-    sInternId sym;
-} IrValueData;
-
-typedef struct {
-    IrValueTag tag;
-    IrValueData data;
-} IrValue;
-
 typedef struct {
     tInternId type;
 } IrTemp;
@@ -41,6 +24,7 @@ typedef struct {
 typedef enum {
     // array
     ir_op_call,
+    ir_op_phi,
     // i64
     ir_op_const_num,
     ir_op_const_char,
@@ -52,6 +36,7 @@ typedef enum {
     ir_op_load_var,
     ir_op_store_var,
     // unary
+    ir_op_cast,
     ir_op_negate,
     ir_op_bw_not,
     ir_op_bw_and,
@@ -96,6 +81,8 @@ static const char* IrOp_name(IrOp op)
     switch (op) {
         case ir_op_call:
             return "call";
+        case ir_op_phi:
+            return "phi";
         case ir_op_const_num:
             return "load_num";
         case ir_op_const_bytes:
@@ -108,6 +95,8 @@ static const char* IrOp_name(IrOp op)
             return "load_var";
         case ir_op_store_var:
             return "store_var";
+        case ir_op_cast:
+            return "cast";
         case ir_op_negate:
             return "negate";
         case ir_op_bw_not:
@@ -201,8 +190,11 @@ static IrOp IrOp_FromBinOp(BinOp op)
     }
 }
 
+// Payloads are at most 8 bytes so that an instruction is 16 bytes. Anything variable-length is
+// stored in IrFunc.extra and referenced by index.
 typedef union {
-    struct { IrValue fn; IrTempId args[16]; uint8_t args_len; } call;
+    struct { sInternId fn; uint32_t args; } call; // extra[args] is the count, followed by the temps
+    struct { IrVarId var; uint32_t args; } phi;   // extra[args] is the count, followed by (block, temp) pairs
     struct { IrTempId lhs; IrTempId rhs; } binary;
     struct { IrTempId lhs; } unary;
     struct { IrVarId id; IrTempId value; } var;
@@ -216,7 +208,7 @@ typedef struct {
     IrOpData data;
 } IrInst;
 
-DEFINE_ARRAY(IrInst);
+DEFINE_ARENA_ARRAY(IrInst);
 
 typedef enum {
     ir_term_jmp,
@@ -236,45 +228,129 @@ typedef struct {
     IrTermData data;
 } IrTerm;
 
+// A block is a range of IrFunc.insts. Blocks are filled one at a time, so the range is contiguous.
 typedef struct {
-    IrInstArray insts;
+    uint32_t start;
+    uint32_t len;
     IrTerm term;
 } IrBlock;
 
-void IrBlock_init(IrBlock *block)
-{
-    IrInstArray_init(&block->insts);
-    block->term.tag = ir_term_next;
-}
-
 typedef struct {
     sInternId name;
     tInternId type;
     sInternId init_name;
 } IrVar;
 
-DEFINE_ARRAY(IrNamedType);
-DEFINE_ARRAY(IrVar);
-DEFINE_ARRAY(IrTemp);
-DEFINE_ARRAY_NAMED(IrBlock*, IrBlock);
+DEFINE_ARENA_ARRAY(IrNamedType);
+DEFINE_ARENA_ARRAY(IrVar);
+DEFINE_ARENA_ARRAY(IrTemp);
+DEFINE_ARENA_ARRAY(IrBlock);
+DEFINE_ARENA_ARRAY_NAMED(uint32_t, IrExtra);
 
+// All of a function is allocated from its arena, including the IrFunc itself.
 typedef struct {
     sInternId name;
     bool is_static;
     tInternId ret_ty;
+    IrInstArray insts;
     IrBlockArray blocks;
     IrNamedTypeArray call_args;
     IrTempArray temps;
     IrVarArray vars;
+    IrExtraArray extra;
     DeclModifiers modifiers;
+    Arena arena;
 } IrFunc;
 
-void IrFunc_Init(IrFunc *func)
+static IrFunc* IrFunc_create(void)
+{
+    Arena arena;
+    Arena_init(&arena);
+    IrFunc *func = Arena_alloc(&arena, sizeof(IrFunc));
+    func->arena = arena;
+    IrInstArray_init(&func->insts, &func->arena);
+    IrBlockArray_init(&func->blocks, &func->arena);
+    IrNamedTypeArray_init(&func->call_args, &func->arena);
+    IrVarArray_init(&func->vars, &func->arena);
+    IrTempArray_init(&func->temps, &func->arena);
+    IrExtraArray_init(&func->extra, &func->arena);
+    return func;
+}
+
+__attribute__((unused))
+static void IrFunc_destroy(IrFunc *func)
 {
-    IrBlockArray_init(&func->blocks);
-    IrNamedTypeArray_init(&func->call_args);
-    IrVarArray_init(&func->vars);
-    IrTempArray_init(&func->temps);
+    Arena arena = func->arena;
+    Arena_deinit(&arena);
+}
+
+static IrTempId IrFunc_newTemp(IrFunc *func, tInternId ty)
+{
+    return IrTempArray_append(&func->temps, (IrTemp){ .type = ty });
+}
+
+static IrVarId IrFunc_newVar(IrFunc *func, IrVar var)
+{
+    return IrVarArray_append(&func->vars, var);
+}
+
+static const IrInst* IrFunc_blockInsts(const IrFunc *func, const IrBlock *block)
+{
+    return &func->insts.data[block->start];
+}
+
+static const IrTempId* IrFunc_callArgs(const IrFunc *func, IrInst inst, uint32_t *len)
+{
+    *len = func->extra.data[inst.data.call.args];
+    return &func->extra.data[inst.data.call.args + 1];
+}
+
+// The temps read by an instruction, every stride'th element of data.
+typedef struct {
+    IrTempId *data;
+    uint32_t len;
+    uint32_t stride;
+} IrOperands;
+
+static IrOperands IrFunc_operands(IrFunc *func, IrInst *inst)
+{
+    switch (inst->op) {
+        case ir_op_call:
+            return (IrOperands){ &func->extra.data[inst->data.call.args + 1], func->extra.data[inst->data.call.args], 1 };
+        case ir_op_phi:
+            return (IrOperands){ &func->extra.data[inst->data.phi.args + 2], func->extra.data[inst->data.phi.args], 2 };
+        case ir_op_copy:
+        case ir_op_cast:
+        case ir_op_negate:
+        case ir_op_bw_not:
+        case ir_op_bw_and:
+        case ir_op_not:
+            return (IrOperands){ &inst->data.unary.lhs, 1, 1 };
+        case ir_op_store_var:
+            return (IrOperands){ &inst->data.var.value, 1, 1 };
+        case ir_op_const_num:
+        case ir_op_const_char:
+        case ir_op_const_bytes:
+        case ir_op_load_var:
+        case ir_op_unreachable:
+        case ir_op_invalid:
+            return (IrOperands){ NULL, 0, 1 };
+        default:
+            return (IrOperands){ &inst->data.binary.lhs, 2, 1 };
+    }
+}
+
+// The temp read by a terminator, or NULL.
+static IrTempId* IrTerm_operand(IrTerm *term)
+{
+    switch (term->tag) {
+        case ir_term_br:
+            return &term->data.br.cond;
+        case ir_term_ret:
+            return &term->data.ret.value;
+        default:
+            return NULL;
+    }
 }
 DEFINE_ARRAY_NAMED(IrFunc*, IrFunc);
 
@@ -292,23 +368,28 @@ void IrProgram_init(IrProgram *p, Ctx *ctx)
 typedef struct {
     IrProgram p;
     size_t ir_count;
+    size_t extra_count;
+    IndexArray scratch; // call arguments being lowered, which may contain nested calls
 
-    IrFunc *func;   // active func
-    IrBlock *block; // active block
+    IrFunc *func;       // active func
+    IrBlockId block;    // active block, or ir_invalid_id
 
     Ctx *ctx;
+    const Ast *ast;
+    Parser *parser; // parses lazy function bodies when they are lowered
+    TraceBuffer *trace;
     // stack for current control flow we are in (e.g. loop)
 } Ir;
 
-static IrTempId Ir_lowerExpr(Ir *ir, Node *expr);
+static IrTempId Ir_lowerExpr(Ir *ir, NodeIndex expr);
 static void Ir_lowerBlock(Ir *ir, NodeDataBlock block);
-static void Ir_lowerStatementExpr(Ir *ir, Node *statement_or_expr);
+static void Ir_lowerStatementExpr(Ir *ir, NodeIndex statement_or_expr);
 static IrVarId Ir_putVar(Ir *ir, IrVar var);
 static IrVar Ir_getVar(Ir *ir, IrVarId id);
 
 static IrTempId Ir_newTemp(Ir *ir, tInternId ty)
 {
-    return IrTempArray_append(&ir->func->temps, (IrTemp){. type = ty });
+    return IrFunc_newTemp(ir->func, ty);
 }
 
 static tInternId Ir_getTempType(Ir *ir, IrTempId tmp_id)
@@ -318,26 +399,25 @@ static tInternId Ir_getTempType(Ir *ir, IrTempId tmp_id)
 
 static IrBlockId Ir_newBlock(Ir *ir)
 {
-    IrBlock *b = std_malloc(sizeof(IrBlock));
-    if (!b) std_panic("oom\n");
-    IrBlock_init(b);
-    uint32_t id = ir->func->blocks.len;
-    IrBlockArray_append(&ir->func->blocks, b);
-    return id;
+    return IrBlockArray_append(&ir->func->blocks, (IrBlock){ .term = { .tag = ir_term_next } });
 }
 
+// blocks start out empty and are set active once, their instructions go at the end of the function
 static void Ir_setBlock(Ir *ir, IrBlockId id)
 {
-    ir->block = ir->func->blocks.data[id];
+    IrBlock *b = &ir->func->blocks.data[id];
+    assume(b->len == 0);
+    b->start = ir->func->insts.len;
+    ir->block = id;
 }
 
 // terminate a block, and add it to the current function
-// leaves the current active block as NULL. Use Ir_newBlock
+// leaves no block active. Use Ir_newBlock
 // to construct and set a new block to active.
 static void Ir_terminateBlock(Ir *ir, IrTerm term)
 {
-    ir->block->term = term;
-    ir->block = NULL;
+    ir->func->blocks.data[ir->block].term = term;
+    ir->block = ir_invalid_id;
 }
 
 static void Ir_termJmp(Ir *ir, IrBlockId to)
@@ -372,26 +452,34 @@ static void Ir_init(Ir *ir, Ctx *ctx)
     IrProgram_init(&ir->p, ctx);
     ir->ctx = ctx;
     ir->ir_count = 0;
+    ir->extra_count = 0;
+    IndexArray_init(&ir->scratch);
     ir->func = NULL;
-    ir->block = NULL;
+    ir->block = ir_invalid_id;
+    ir->trace = NULL;
 }
 
 // append an instruction to the current block, returning the dst temp id
 static IrTempId Ir_appendInst(Ir *ir, IrInst inst)
 {
+    IrBlock *b = &ir->func->blocks.data[ir->block];
+    assume(b->start + b->len == ir->func->insts.len);
     ir->ir_count += 1;
-    IrInstArray_append(&ir->block->insts, inst);
+    b->len += 1;
+    IrInstArray_append(&ir->func->insts, inst);
     return inst.dst;
 }
 static IrVarId Ir_appendVar(Ir *ir, IrVar var)
 {
-    IrVarArray_append(&ir->func->vars, var);
-    return ir->func->vars.len - 1;
+    return IrFunc_newVar(ir->func, var);
 }
 
+// primitive ids are fixed at Ctx_init
 static tInternId Ir_primitiveType(Ir *ir, tTypeTag tag)
 {
-    return Ctx_putType(ir->ctx, (tType){ .tag = tag });
+    (void)ir;
+    assume(tag < ty_primitive_count);
+    return (tInternId)tag;
 }
 
 static void Ir_emitStoreVar(Ir *ir, IrVarId var_id, IrTempId tmp_id)
@@ -429,14 +517,14 @@ static IrTempId Ir_lowerPrimaryTypeExpr(Ir *ir, NodeDataPrimaryTypeExpr primary_
             return Ir_appendInst(ir, (IrInst){
                 .op = ir_op_const_num,
                 .dst = Ir_newTemp(ir, Ir_primitiveType(ir, ty_c_int)),
-                .data = { .i64 = Buffer_toInt(primary_type_expr.data.raw, 10) },
+                .data = { .i64 = Buffer_toInt(Ast_tokenSlice(ir->ast, primary_type_expr.data.raw), 10) },
             });
 
         case node_primary_type_identifier:
         {
             // Should use GetVar as it should exist, need a symbol table
             IrVarId rval = Ir_putVar(ir, (IrVar){
-                .name = Ctx_putString(ir->ctx, primary_type_expr.data.raw),
+                .name = Ctx_putString(ir->ctx, Ast_tokenSlice(ir->ast, primary_type_expr.data.raw)),
                 .type = Ir_primitiveType(ir, ty_c_int),
                 .init_name = ir_invalid_id,
             });
@@ -444,12 +532,15 @@ static IrTempId Ir_lowerPrimaryTypeExpr(Ir *ir, NodeDataPrimaryTypeExpr primary_
         }
 
         case node_primary_type_char_literal:
-            assume(primary_type_expr.data.raw.len == 1);
+        {
+            Buffer raw = Ast_tokenSlice(ir->ast, primary_type_expr.data.raw);
+            assume(raw.len == 1);
             return Ir_appendInst(ir, (IrInst){
                 .op = ir_op_const_char,
                 .dst = Ir_newTemp(ir, Ir_primitiveType(ir, ty_c_char)),
-                .data = { .i64 = primary_type_expr.data.raw.data[0] },
+                .data = { .i64 = raw.data[0] },
             });
+        }
 
         case node_primary_type_string_literal:
         {
@@ -463,7 +554,7 @@ static IrTempId Ir_lowerPrimaryTypeExpr(Ir *ir, NodeDataPrimaryTypeExpr primary_
                 .op = ir_op_const_bytes,
                 .dst = Ir_newTemp(ir, const_ptr_c_char),
                 // TODO: Ensure string is also stored in const table
-                .data = { .bytes = Ctx_putString(ir->ctx, primary_type_expr.data.raw) },
+                .data = { .bytes = Ctx_putString(ir->ctx, Ast_tokenSlice(ir->ast, primary_type_expr.data.raw)) },
             });
         }
         break;
@@ -493,47 +584,50 @@ static IrTempId Ir_lowerPrimaryTypeExpr(Ir *ir, NodeDataPrimaryTypeExpr primary_
 
 static IrTempId Ir_lowerTypeExpr(Ir *ir, NodeDataTypeExpr expr)
 {
-    NodeDataErrorUnionExpr error_union_expr = expr.type_expr->data.error_union_expr;
-    assume(error_union_expr.error_type_expr == NULL);
-    assume(error_union_expr.suffix_expr->tag == node_suffix_expr);
-    NodeDataSuffixExpr suffix_expr = error_union_expr.suffix_expr->data.suffix_expr;
-    assume(suffix_expr.expr->tag == node_primary_type_expr);
+    NodeDataErrorUnionExpr error_union_expr = Ast_node(ir->ast, expr.type_expr)->data.error_union_expr;
+    assume(error_union_expr.error_type_expr == NODE_NONE);
+    const Node *suffix = Ast_node(ir->ast, error_union_expr.suffix_expr);
+    assume(suffix->tag == node_suffix_expr);
+    NodeDataSuffixExpr suffix_expr = suffix->data.suffix_expr;
+    const Node *primary = Ast_node(ir->ast, suffix_expr.expr);
+    assume(primary->tag == node_primary_type_expr);
 
     // This is a bit of a hack
     if (suffix_expr.suffixes_len == 0) {
-        return Ir_lowerPrimaryTypeExpr(ir, suffix_expr.expr->data.primary_type_expr);
+        return Ir_lowerPrimaryTypeExpr(ir, primary->data.primary_type_expr);
     }
 
     IrTempId dst;
 
     for (uint32_t i = 0; i < suffix_expr.suffixes_len; i++) {
-        Node *s = suffix_expr.suffixes[i];
+        const Node *s = Ast_node(ir->ast, Ast_list(ir->ast, suffix_expr.suffixes)[i]);
         switch (s->tag) {
             case node_fn_call_arguments:
             {
                 // assumes this is a base type
-                IrValue value = {
-                    .tag = ir_val_sym,
-                    .data = { .sym = Ctx_putString(ir->ctx, suffix_expr.expr->data.primary_type_expr.data.raw) },
-                };
-
-                if (s->data.fn_call_arguments.exprs_len > 16) {
-                    std_panic("call supports 16 arguments max\n");
-                }
+                sInternId fn = Ctx_putString(ir->ctx, Ast_tokenSlice(ir->ast, primary->data.primary_type_expr.data.raw));
 
                 // TODO: identify from fn_call definition ret_ty
                 dst = Ir_newTemp(ir, Ir_primitiveType(ir, ty_c_int));
 
+                // arguments can be calls themselves, so only move them to extra once all are lowered
+                uint32_t top = ir->scratch.len;
+                for (uint32_t i = 0; i < s->data.fn_call_arguments.exprs_len; i++) {
+                    IndexArray_append(&ir->scratch, Ir_lowerExpr(ir, Ast_list(ir->ast, s->data.fn_call_arguments.exprs)[i]));
+                }
+
+                uint32_t args_len = ir->scratch.len - top;
+                uint32_t args = IrExtraArray_append(&ir->func->extra, args_len);
+                IrExtraArray_appendMany(&ir->func->extra, &ir->scratch.data[top], args_len);
+                ir->extra_count += 1 + args_len;
+                ir->scratch.len = top;
+
                 IrInst call = {
                     .op = ir_op_call,
                     .dst = dst,
-                    .data = { .call = { .fn = value, .args_len = s->data.fn_call_arguments.exprs_len } },
+                    .data = { .call = { .fn = fn, .args = args } },
                 };
 
-                for (uint32_t i = 0; i < s->data.fn_call_arguments.exprs_len; i++) {
-                    call.data.call.args[i] = Ir_lowerExpr(ir, s->data.fn_call_arguments.exprs[i]);
-                }
-
                 Ir_appendInst(ir, call);
             }
             break;
@@ -546,13 +640,14 @@ static IrTempId Ir_lowerTypeExpr(Ir *ir, NodeDataTypeExpr expr)
     return dst;
 }
 
-static IrTempId Ir_lowerPrimaryExpr(Ir *ir, Node *expr)
+static IrTempId Ir_lowerPrimaryExpr(Ir *ir, NodeIndex index)
 {
+    const Node *expr = Ast_node(ir->ast, index);
     switch (expr->tag) {
         case node_if_expr:
         {
             NodeDataIfExpr if_expr = expr->data.if_expr;
-            assume(if_expr.else_payload_name.len == 0);
+            assume(if_expr.else_payload_name == TOKEN_NONE);
 
             IrBlockId b_if = Ir_newBlock(ir);
             IrBlockId b_else = Ir_newBlock(ir);
@@ -632,7 +727,7 @@ static IrTempId Ir_lowerUnaryExpr(Ir *ir, NodeDataUnaryExpr unary_expr)
 
     // emit instructions during each loop
     for (uint32_t i = 0; i < unary_expr.ops_len; i++) {
-        switch (unary_expr.ops[i]) {
+        switch (Ast_list(ir->ast, unary_expr.ops)[i]) {
             case token_minus:
                 inst.op = ir_op_negate;
                 break;
@@ -648,7 +743,7 @@ static IrTempId Ir_lowerUnaryExpr(Ir *ir, NodeDataUnaryExpr unary_expr)
 
             case token_minus_percent:
             case token_keyword_try:
-                std_panic("unimplemented tag: %s\n", TokenTag_name(unary_expr.ops[i]));
+                std_panic("unimplemented tag: %s\n", TokenTag_name(Ast_list(ir->ast, unary_expr.ops)[i]));
 
             default:
                 assume(false);
@@ -679,8 +774,9 @@ static IrTempId Ir_lowerBinaryExpr(Ir *ir, NodeDataBinaryExpr binary_expr)
     return Ir_appendInst(ir, inst);
 }
 
-static IrTempId Ir_lowerExpr(Ir *ir, Node *expr)
+static IrTempId Ir_lowerExpr(Ir *ir, NodeIndex index)
 {
+    const Node *expr = Ast_node(ir->ast, index);
     switch (expr->tag) {
         case node_unary_expr:
             return Ir_lowerUnaryExpr(ir, expr->data.unary_expr);
@@ -691,7 +787,7 @@ static IrTempId Ir_lowerExpr(Ir *ir, Node *expr)
         case node_if_prefix:
         {
             NodeDataIfPrefix if_prefix = expr->data.if_prefix;
-            assume(if_prefix.ptr_payload == NULL);
+            assume(if_prefix.ptr_payload == NODE_NONE);
             return Ir_lowerExpr(ir, if_prefix.condition);
         }
         break;
@@ -720,10 +816,10 @@ static IrVar Ir_getVar(Ir *ir, IrVarId id)
     return ir->func->vars.data[id];
 }
 
-static tInternId Sema_evalTypeName(Ctx *ctx, Node *n);
+static tInternId Sema_evalTypeName(Ctx *ctx, const Ast *ast, NodeIndex n);
 static void Ir_lowerAssignExpr(Ir *ir, NodeDataSingleAssignExpr e)
 {
-    Buffer name = Sema_evalSymbolName(ir->ctx, e.lhs);
+    Buffer name = Sema_evalSymbolName(ir->ctx, ir->ast, e.lhs);
     bool is_discard = Buffer_eql(name, "_");
 
     IrVarId var_id = ir_invalid_id;
@@ -751,7 +847,7 @@ static void Ir_lowerAssignExpr(Ir *ir, NodeDataSingleAssignExpr e)
                 IrTempId lhs = Ir_emitLoadVar(ir, var_id);
                 IrInst add = {
                     .op = ir_op_add,
-                    .dst = Ir_newTemp(ir, var_id),
+                    .dst = Ir_newTemp(ir, Ir_getVar(ir, var_id).type),
                     .data = { .binary = { .lhs = lhs, .rhs = rhs } },
                 };
                 Ir_emitStoreVar(ir, var_id, Ir_appendInst(ir, add));
@@ -766,12 +862,13 @@ static void Ir_lowerAssignExpr(Ir *ir, NodeDataSingleAssignExpr e)
 
 static void Ir_lowerVarDecl(Ir *ir, NodeDataVarDeclStatement vd)
 {
-    assume(vd.var_decl->tag == node_var_decl_proto);
+    const Node *var_decl = Ast_node(ir->ast, vd.var_decl);
+    assume(var_decl->tag == node_var_decl_proto);
     assume(vd.var_decl_additional_len == 0);
 
     IrVar var = {
-        .name = Ctx_putString(ir->ctx, vd.var_decl->data.var_decl_proto.name),
-        .type = Sema_evalTypeName(ir->ctx, vd.var_decl->data.var_decl_proto.type),
+        .name = Ctx_putString(ir->ctx, Ast_tokenSlice(ir->ast, var_decl->data.var_decl_proto.name)),
+        .type = Sema_evalTypeName(ir->ctx, ir->ast, var_decl->data.var_decl_proto.type),
         .init_name = ir_invalid_id,
     };
     IrVarId id = Ir_appendVar(ir, var);
@@ -782,13 +879,14 @@ static void Ir_lowerVarDecl(Ir *ir, NodeDataVarDeclStatement vd)
 static void Ir_lowerLoop(Ir *ir, NodeDataLoopStatement loop)
 {
     assume(loop.is_inline == false);
-    switch (loop.statement->tag) {
+    const Node *statement = Ast_node(ir->ast, loop.statement);
+    switch (statement->tag) {
         case node_while_statement:
         {
-            NodeDataWhileStatement while_stmt = loop.statement->data.while_statement;
-            NodeDataWhilePrefix while_prefix = while_stmt.condition->data.while_prefix;
-            assume(while_prefix.ptr_payload == NULL);
-            assume(while_stmt.else_statement == NULL);
+            NodeDataWhileStatement while_stmt = statement->data.while_statement;
+            NodeDataWhilePrefix while_prefix = Ast_node(ir->ast, while_stmt.condition)->data.while_prefix;
+            assume(while_prefix.ptr_payload == NODE_NONE);
+            assume(while_stmt.else_statement == NODE_NONE);
 
             IrBlockId block_cond = Ir_newBlock(ir);
             IrBlockId block = Ir_newBlock(ir);
@@ -800,23 +898,23 @@ static void Ir_lowerLoop(Ir *ir, NodeDataLoopStatement loop)
             Ir_termBr(ir, cond, block, next);
 
             Ir_setBlock(ir, block);
-            Ir_lowerBlock(ir, while_stmt.block->data.block);
+            Ir_lowerBlock(ir, Ast_node(ir->ast, while_stmt.block)->data.block);
             Ir_termJmp(ir, cont_expr);
 
             Ir_setBlock(ir, cont_expr);
             Ir_lowerStatementExpr(ir, while_prefix.while_continue_expr);
             Ir_termJmp(ir, block_cond);
 
-            Ir_setBlock(ir, Ir_newBlock(ir));
+            Ir_setBlock(ir, next);
         }
         break;
 
         case node_for_statement:
         {
-            NodeDataForStatement for_stmt = loop.statement->data.for_statement;
-            NodeDataForPrefix for_prefix = for_stmt.condition->data.for_prefix;
-            assume(for_stmt.else_statement == NULL);
-            NodeDataForArgs for_args = for_prefix.for_args->data.for_args;
+            NodeDataForStatement for_stmt = statement->data.for_statement;
+            NodeDataForPrefix for_prefix = Ast_node(ir->ast, for_stmt.condition)->data.for_prefix;
+            assume(for_stmt.else_statement == NODE_NONE);
+            NodeDataForArgs for_args = Ast_node(ir->ast, for_prefix.for_args)->data.for_args;
             assume(for_args.args_len == 1);
 
             IrTempId block_cond = Ir_newBlock(ir);
@@ -824,16 +922,16 @@ static void Ir_lowerLoop(Ir *ir, NodeDataLoopStatement loop)
             IrTempId cont_expr = Ir_newBlock(ir);
             IrTempId next = Ir_newBlock(ir);
 
-            NodeDataPayloadList payloads = for_prefix.ptr_list_payload->data.payload_list;
+            NodeDataPayloadList payloads = Ast_node(ir->ast, for_prefix.ptr_list_payload)->data.payload_list;
             for (uint32_t i = 0; i < for_args.args_len; i++) {
-                NodeDataForItem for_item = for_args.args[i]->data.for_item;
+                NodeDataForItem for_item = Ast_node(ir->ast, Ast_list(ir->ast, for_args.args)[i])->data.for_item;
                 assume(for_item.is_range);
 
                 tInternId usize = Ir_primitiveType(ir, ty_usize);
 
                 if (i < payloads.payloads_len) {
                     IrVarId id = Ir_putVar(ir, (IrVar){
-                        .name = Ctx_putString(ir->ctx, payloads.payloads[i]->data.payload.name),
+                        .name = Ctx_putString(ir->ctx, Ast_tokenSlice(ir->ast, Ast_node(ir->ast, Ast_list(ir->ast, payloads.payloads)[i])->data.payload.name)),
                         .type = usize,
                         .init_name = ir_invalid_id,
                     });
@@ -849,7 +947,7 @@ static void Ir_lowerLoop(Ir *ir, NodeDataLoopStatement loop)
                     Ir_termBr(ir, cond, block, next);
 
                     Ir_setBlock(ir, block);
-                    Ir_lowerBlock(ir, for_stmt.block->data.block);
+                    Ir_lowerBlock(ir, Ast_node(ir->ast, for_stmt.block)->data.block);
                     Ir_termJmp(ir, cont_expr);
 
                     Ir_setBlock(ir, cont_expr);
@@ -869,22 +967,23 @@ static void Ir_lowerLoop(Ir *ir, NodeDataLoopStatement loop)
                     Ir_termJmp(ir, block_cond);
                 } else {
                     Ir_setBlock(ir, block);
-                    Ir_lowerBlock(ir, for_stmt.block->data.block);
+                    Ir_lowerBlock(ir, Ast_node(ir->ast, for_stmt.block)->data.block);
                     Ir_termJmp(ir, block);
                 }
             }
 
-            Ir_setBlock(ir, Ir_newBlock(ir));
+            Ir_setBlock(ir, next);
         }
         break;
 
         default:
-            std_panic("unsupported tag: %s\n", NodeTag_name(loop.statement->tag));
+            std_panic("unsupported tag: %s\n", NodeTag_name(statement->tag));
     }
 }
 
-static void Ir_lowerStatementExpr(Ir *ir, Node *statement_or_expr)
+static void Ir_lowerStatementExpr(Ir *ir, NodeIndex index)
 {
+    const Node *statement_or_expr = Ast_node(ir->ast, index);
     switch (statement_or_expr->tag) {
         case node_comptime_statement:
             std_panic("unimplemented comptime_statement\n");
@@ -904,9 +1003,10 @@ static void Ir_lowerStatementExpr(Ir *ir, Node *statement_or_expr)
         case node_if_statement:
         {
             NodeDataIfStatement if_stmt = statement_or_expr->data.if_statement;
-            assume(if_stmt.condition->tag == node_if_prefix);
-            NodeDataIfPrefix if_prefix = if_stmt.condition->data.if_prefix;
-            assume(if_prefix.ptr_payload == NULL);
+            const Node *condition = Ast_node(ir->ast, if_stmt.condition);
+            assume(condition->tag == node_if_prefix);
+            NodeDataIfPrefix if_prefix = condition->data.if_prefix;
+            assume(if_prefix.ptr_payload == NODE_NONE);
 
             IrBlockId b_body = Ir_newBlock(ir);
             IrBlockId b_else = Ir_newBlock(ir);
@@ -916,11 +1016,11 @@ static void Ir_lowerStatementExpr(Ir *ir, Node *statement_or_expr)
             Ir_termBr(ir, cond, b_body, b_else);
 
             Ir_setBlock(ir, b_body);
-            Ir_lowerBlock(ir, if_stmt.block->data.block);
+            Ir_lowerBlock(ir, Ast_node(ir->ast, if_stmt.block)->data.block);
             Ir_termJmp(ir, b_next);
 
             Ir_setBlock(ir, b_else);
-            if (if_stmt.else_statement != NULL) {
+            if (if_stmt.else_statement != NODE_NONE) {
                 Ir_lowerStatementExpr(ir, if_stmt.else_statement);
             }
             Ir_termJmp(ir, b_next);
@@ -931,19 +1031,20 @@ static void Ir_lowerStatementExpr(Ir *ir, Node *statement_or_expr)
         case node_labeled_statement:
         {
             NodeDataLabeledStatement labeled_stmt = statement_or_expr->data.labeled_statement;
-            assume(labeled_stmt.label.len == 0);
-            switch (labeled_stmt.statement->tag) {
+            assume(labeled_stmt.label == TOKEN_NONE);
+            const Node *statement = Ast_node(ir->ast, labeled_stmt.statement);
+            switch (statement->tag) {
                 case node_loop_statement:
-                    Ir_lowerLoop(ir, labeled_stmt.statement->data.loop_statement);
+                    Ir_lowerLoop(ir, statement->data.loop_statement);
                     break;
                 case node_block:
                     // TODO: re-use the created block from above?
-                    Ir_lowerBlock(ir, labeled_stmt.statement->data.block);
+                    Ir_lowerBlock(ir, statement->data.block);
                     break;
                 case node_switch_expr:
                     assume(false);
                 default:
-                    std_panic("unsupported tag: %s\n", NodeTag_name(labeled_stmt.statement->tag));
+                    std_panic("unsupported tag: %s\n", NodeTag_name(statement->tag));
             }
         }
         break;
@@ -958,7 +1059,7 @@ static void Ir_lowerStatementExpr(Ir *ir, Node *statement_or_expr)
 
         // simple, non-cfg-block creating instruction
         default:
-            Ir_lowerExpr(ir, statement_or_expr);
+            Ir_lowerExpr(ir, index);
             break;
     }
 }
@@ -972,37 +1073,39 @@ static void Ir_lowerStatementExpr(Ir *ir, Node *statement_or_expr)
 static void Ir_lowerBlock(Ir *ir, NodeDataBlock block)
 {
     for (uint32_t i = 0; i < block.statements_len; i++) {
-        Ir_lowerStatementExpr(ir, block.statements[i]);
+        Ir_lowerStatementExpr(ir, Ast_list(ir->ast, block.statements)[i]);
     }
 }
 
 static IrFunc* Ir_lowerFunc(Ir *ir, NodeDataDeclFn fn, bool is_static)
 {
-    assume(fn.fn_proto->tag == node_fn_proto);
-    NodeDataFnProto fn_proto = fn.fn_proto->data.fn_proto;
+    uint64_t trace_start = Trace_begin(ir->trace);
+    const Node *proto = Ast_node(ir->ast, fn.fn_proto);
+    assume(proto->tag == node_fn_proto);
+    NodeDataFnProto fn_proto = proto->data.fn_proto;
 
-    IrFunc *func = std_malloc(sizeof(IrFunc));
-    if (!func) std_panic("oom\n");
-    IrFunc_Init(func);
+    IrFunc *func = IrFunc_create();
 
     ir->func = func;
     ir->func->is_static = is_static;
     ir->func->modifiers = fn.modifiers;
-    ir->func->name = Ctx_putString(ir->ctx, fn_proto.name);
-    ir->func->ret_ty = Sema_evalTypeName(ir->ctx, fn_proto.return_type);
+    ir->func->name = Ctx_putString(ir->ctx, Ast_tokenSlice(ir->ast, fn_proto.name));
+    ir->func->ret_ty = Sema_evalTypeName(ir->ctx, ir->ast, fn_proto.return_type);
     if (fn_proto.params) {
-        assume(fn_proto.params->tag == node_param_decl_list);
-        NodeDataParamDeclList decl_list = fn_proto.params->data.param_decl_list;
+        const Node *params = Ast_node(ir->ast, fn_proto.params);
+        assume(params->tag == node_param_decl_list);
+        NodeDataParamDeclList decl_list = params->data.param_decl_list;
         for (uint32_t i = 0; i < decl_list.params_len; i++) {
-            assume(decl_list.params[i]->tag == node_param_decl);
-            NodeDataParamDecl decl = decl_list.params[i]->data.param_decl;
+            const Node *param = Ast_node(ir->ast, Ast_list(ir->ast, decl_list.params)[i]);
+            assume(param->tag == node_param_decl);
+            NodeDataParamDecl decl = param->data.param_decl;
 
             IrNamedType ty;
             if (decl.is_varargs) {
                 ty.is_varargs = true;
             } else {
-                ty.name = Ctx_putString(ir->ctx, decl.identifier);
-                ty.type = Sema_evalTypeName(ir->ctx, decl.type);
+                ty.name = Ctx_putString(ir->ctx, Ast_tokenSlice(ir->ast, decl.identifier));
+                ty.type = Sema_evalTypeName(ir->ctx, ir->ast, decl.type);
                 ty.is_varargs = false;
             }
 
@@ -1010,8 +1113,10 @@ static IrFunc* Ir_lowerFunc(Ir *ir, NodeDataDeclFn fn, bool is_static)
         }
     }
 
-    if (fn.block != NULL) {
-        assume(fn.block->tag == node_block);
+    if (fn.block != NODE_NONE) {
+        if (Ast_node(ir->ast, fn.block)->tag == node_lazy_block) Parser_parseLazyBlock(ir->parser, fn.block);
+        const Node *block = Ast_node(ir->ast, fn.block);
+        assume(block->tag == node_block);
         Ir_setBlock(ir, Ir_newBlock(ir));
 
         for (uint32_t i = 0; i < ir->func->call_args.len; i++) {
@@ -1023,30 +1128,38 @@ static IrFunc* Ir_lowerFunc(Ir *ir, NodeDataDeclFn fn, bool is_static)
             });
         }
 
-        Ir_lowerBlock(ir, fn.block->data.block);
+        Ir_lowerBlock(ir, block->data.block);
     }
+    Trace_end(ir->trace, trace_start, "lower fn", trace_arg_intern, func->name, 0);
     return func;
 }
 
-static IrFunc* Ir_lowerDeclFn(Ir *ir, Node *decl)
+static IrFunc* Ir_lowerDeclFn(Ir *ir, NodeIndex index)
 {
+    const Node *decl = Ast_node(ir->ast, index);
     if (decl->tag == node_top_level_decl) {
-        NodeDataTopLevelDecl *top_level_decl = &decl->data.top_level_decl;
-        if (top_level_decl->decl->tag == node_decl_fn) {
-            NodeDataDeclFn fn = top_level_decl->decl->data.decl_fn;
+        const NodeDataTopLevelDecl *top_level_decl = &decl->data.top_level_decl;
+        const Node *inner = Ast_node(ir->ast, top_level_decl->decl);
+        if (inner->tag == node_decl_fn) {
+            NodeDataDeclFn fn = inner->data.decl_fn;
             return Ir_lowerFunc(ir, fn, !top_level_decl->is_pub);
         }
     }
     return NULL;
 }
 
-static IrProgram* Ir_lower(Ir *ir, Node *root)
+static IrProgram* Ir_lower(Ir *ir, Parser *p)
 {
+    const Ast *ast = &p->ast;
+    ir->ast = ast;
+    ir->parser = p;
+    const Node *root = Ast_node(ast, ast->root);
     assume(root->tag == node_container_members);
-    NodeDataContainerMembers *m = &root->data.container_members;
+    // copied, as lowering a lazy body appends to the nodes and may move them
+    NodeDataContainerMembers m = root->data.container_members;
 
-    for (uint32_t i = 0; i < m->decls_len; i++) {
-        IrFunc *func = Ir_lowerDeclFn(ir, m->decls[i]);
+    for (uint32_t i = 0; i < m.decls_len; i++) {
+        IrFunc *func = Ir_lowerDeclFn(ir, Ast_list(ast, m.decls)[i]);
         if (func) IrFuncArray_append(&ir->p.funcs, func);
     }
 
@@ -0,0 +1,285 @@
+// IrCfg is the control-flow graph of an IrFunc along with its dominator tree and dominance
+// frontiers, computed by the passes that need them. Everything is allocated from a scratch arena
+// and is invalid once the blocks or their terminators change.
+//
+// Blocks are emitted in id order, so a block ending in ir_term_next falls through to the block
+// with the following id. Unreachable blocks have no predecessors or dominators and are left out
+// of the reverse postorder.
+
+typedef struct {
+    uint32_t blocks_len;
+    IrBlockId *succs;           // 2 per block, ir_invalid_id if absent
+    uint32_t *preds_start;      // preds of b are preds[preds_start[b]..preds_start[b + 1]]
+    IrBlockId *preds;
+    IrBlockId *rpo;             // reachable blocks in reverse postorder, the entry first
+    uint32_t rpo_len;
+    uint32_t *rpo_index;        // ir_invalid_id if unreachable
+    IrBlockId *idom;            // the entry is its own immediate dominator
+    uint32_t *children_start;   // dominator tree, same layout as preds
+    IrBlockId *children;
+    uint32_t *df_start;         // dominance frontiers, same layout as preds
+    IrBlockId *df;
+} IrCfg;
+
+// Returns the number of distinct successors.
+static uint32_t IrCfg_termSuccs(const IrFunc *func, IrBlockId id, IrBlockId succs[2])
+{
+    IrTerm term = func->blocks.data[id].term;
+    succs[0] = ir_invalid_id;
+    succs[1] = ir_invalid_id;
+    switch (term.tag) {
+        case ir_term_jmp:
+            succs[0] = term.data.jmp.target;
+            break;
+        case ir_term_br:
+            succs[0] = term.data.br.t;
+            if (term.data.br.f != term.data.br.t) succs[1] = term.data.br.f;
+            break;
+        case ir_term_ret:
+            break;
+        case ir_term_next:
+            if (id + 1 < func->blocks.len) succs[0] = id + 1;
+            break;
+    }
+    return (succs[0] != ir_invalid_id) + (succs[1] != ir_invalid_id);
+}
+
+static uint32_t* IrCfg_alloc(Arena *arena, uint32_t len, uint32_t value)
+{
+    uint32_t *a = Arena_alloc(arena, sizeof(uint32_t) * (len ? len : 1));
+    for (uint32_t i = 0; i < len; i++) a[i] = value;
+    return a;
+}
+
+// Fill start with the offsets for the given per-block counts, leaving count as the running fill.
+static void IrCfg_offsets(uint32_t blocks_len, uint32_t *start, uint32_t *count)
+{
+    start[0] = 0;
+    for (uint32_t b = 0; b < blocks_len; b++) {
+        start[b + 1] = start[b] + count[b];
+        count[b] = 0;
+    }
+}
+
+static void IrCfg_order(IrCfg *cfg, Arena *arena)
+{
+    uint32_t n = cfg->blocks_len;
+    cfg->rpo = IrCfg_alloc(arena, n, 0);
+    cfg->rpo_index = IrCfg_alloc(arena, n, ir_invalid_id);
+    cfg->rpo_len = 0;
+
+    // iterative dfs, postorder is collected at the end of rpo and then moved down
+    IrBlockId *stack = IrCfg_alloc(arena, n, 0);
+    uint32_t *next_succ = IrCfg_alloc(arena, n, 0);
+    bool *visited = Arena_alloc(arena, n ? n : 1);
+    for (uint32_t b = 0; b < n; b++) visited[b] = false;
+
+    uint32_t post_len = 0;
+    uint32_t stack_len = 0;
+    if (n) {
+        stack[stack_len++] = 0;
+        visited[0] = true;
+    }
+    while (stack_len) {
+        IrBlockId b = stack[stack_len - 1];
+        if (next_succ[b] < 2) {
+            IrBlockId s = cfg->succs[2 * b + next_succ[b]++];
+            if (s != ir_invalid_id && !visited[s]) {
+                visited[s] = true;
+                stack[stack_len++] = s;
+            }
+        } else {
+            stack_len--;
+            cfg->rpo[n - 1 - post_len++] = b;
+        }
+    }
+    for (uint32_t i = 0; i < post_len; i++) cfg->rpo[i] = cfg->rpo[n - post_len + i];
+    cfg->rpo_len = post_len;
+    for (uint32_t i = 0; i < post_len; i++) cfg->rpo_index[cfg->rpo[i]] = i;
+}
+
+static IrBlockId IrCfg_intersect(const IrCfg *cfg, IrBlockId a, IrBlockId b)
+{
+    while (a != b) {
+        while (cfg->rpo_index[a] > cfg->rpo_index[b]) a = cfg->idom[a];
+        while (cfg->rpo_index[b] > cfg->rpo_index[a]) b = cfg->idom[b];
+    }
+    return a;
+}
+
+// "A Simple, Fast Dominance Algorithm", Cooper, Harvey and Kennedy.
+static void IrCfg_dominators(IrCfg *cfg, Arena *arena)
+{
+    uint32_t n = cfg->blocks_len;
+    cfg->idom = IrCfg_alloc(arena, n, ir_invalid_id);
+    if (cfg->rpo_len == 0) return;
+    cfg->idom[cfg->rpo[0]] = cfg->rpo[0];
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t i = 1; i < cfg->rpo_len; i++) {
+            IrBlockId b = cfg->rpo[i];
+            IrBlockId idom = ir_invalid_id;
+            for (uint32_t j = cfg->preds_start[b]; j < cfg->preds_start[b + 1]; j++) {
+                IrBlockId p = cfg->preds[j];
+                if (cfg->idom[p] == ir_invalid_id) continue;
+                idom = idom == ir_invalid_id ? p : IrCfg_intersect(cfg, p, idom);
+            }
+            if (cfg->idom[b] != idom) {
+                cfg->idom[b] = idom;
+                changed = true;
+            }
+        }
+    }
+
+    uint32_t *count = IrCfg_alloc(arena, n, 0);
+    for (uint32_t i = 1; i < cfg->rpo_len; i++) count[cfg->idom[cfg->rpo[i]]]++;
+    cfg->children_start = IrCfg_alloc(arena, n + 1, 0);
+    IrCfg_offsets(n, cfg->children_start, count);
+    cfg->children = IrCfg_alloc(arena, cfg->children_start[n], 0);
+    for (uint32_t i = 1; i < cfg->rpo_len; i++) {
+        IrBlockId b = cfg->rpo[i];
+        IrBlockId d = cfg->idom[b];
+        cfg->children[cfg->children_start[d] + count[d]++] = b;
+    }
+}
+
+// Frontiers are found by walking up from the predecessors of each join point, the same paper.
+// A block reaches the join once per predecessor, so last[] skips the repeats.
+static void IrCfg_frontiers(IrCfg *cfg, Arena *arena)
+{
+    uint32_t n = cfg->blocks_len;
+    uint32_t *count = IrCfg_alloc(arena, n, 0);
+    uint32_t *last = IrCfg_alloc(arena, n, ir_invalid_id);
+    cfg->df_start = IrCfg_alloc(arena, n + 1, 0);
+
+    for (uint32_t pass = 0; pass < 2; pass++) {
+        for (uint32_t i = 0; i < cfg->rpo_len; i++) {
+            IrBlockId b = cfg->rpo[i];
+            if (cfg->preds_start[b + 1] - cfg->preds_start[b] < 2) continue;
+            for (uint32_t j = cfg->preds_start[b]; j < cfg->preds_start[b + 1]; j++) {
+                for (IrBlockId r = cfg->preds[j]; r != cfg->idom[b] && last[r] != b; r = cfg->idom[r]) {
+                    last[r] = b;
+                    if (pass == 1) cfg->df[cfg->df_start[r] + count[r]] = b;
+                    count[r]++;
+                }
+            }
+        }
+        if (pass == 0) {
+            IrCfg_offsets(n, cfg->df_start, count);
+            cfg->df = IrCfg_alloc(arena, cfg->df_start[n], 0);
+            for (uint32_t b = 0; b < n; b++) last[b] = ir_invalid_id;
+        }
+    }
+}
+
+static void IrCfg_build(IrCfg *cfg, const IrFunc *func, Arena *arena)
+{
+    uint32_t n = func->blocks.len;
+    cfg->blocks_len = n;
+    cfg->succs = IrCfg_alloc(arena, 2 * n, ir_invalid_id);
+    for (IrBlockId b = 0; b < n; b++) IrCfg_termSuccs(func, b, &cfg->succs[2 * b]);
+
+    IrCfg_order(cfg, arena);
+
+    // only edges out of reachable blocks count as predecessors
+    uint32_t *count = IrCfg_alloc(arena, n, 0);
+    for (uint32_t i = 0; i < cfg->rpo_len; i++) {
+        IrBlockId b = cfg->rpo[i];
+        for (uint32_t j = 0; j < 2; j++) {
+            if (cfg->succs[2 * b + j] != ir_invalid_id) count[cfg->succs[2 * b + j]]++;
+        }
+    }
+    cfg->preds_start = IrCfg_alloc(arena, n + 1, 0);
+    IrCfg_offsets(n, cfg->preds_start, count);
+    cfg->preds = IrCfg_alloc(arena, cfg->preds_start[n], 0);
+    for (IrBlockId b = 0; b < n; b++) {
+        if (cfg->rpo_index[b] == ir_invalid_id) continue;
+        for (uint32_t j = 0; j < 2; j++) {
+            IrBlockId s = cfg->succs[2 * b + j];
+            if (s != ir_invalid_id) cfg->preds[cfg->preds_start[s] + count[s]++] = b;
+        }
+    }
+
+    IrCfg_dominators(cfg, arena);
+    IrCfg_frontiers(cfg, arena);
+}
+
+static bool IrCfg_isReachable(const IrCfg *cfg, IrBlockId b)
+{
+    return cfg->rpo_index[b] != ir_invalid_id;
+}
+
+static uint32_t IrCfg_predsLen(const IrCfg *cfg, IrBlockId b)
+{
+    return cfg->preds_start[b + 1] - cfg->preds_start[b];
+}
+
+// Drop the phi arguments for edges that no longer exist, after terminators have changed.
+static void IrCfg_prunePhiArgs(IrFunc *func)
+{
+    for (IrBlockId b = 0; b < func->blocks.len; b++) {
+        IrBlock *block = &func->blocks.data[b];
+        for (uint32_t i = block->start; i < block->start + block->len; i++) {
+            IrInst inst = func->insts.data[i];
+            if (inst.op != ir_op_phi) continue;
+            uint32_t *args = &func->extra.data[inst.data.phi.args];
+            uint32_t len = 0;
+            for (uint32_t j = 0; j < args[0]; j++) {
+                IrBlockId p = args[1 + 2 * j];
+                IrBlockId succs[2];
+                if (p == ir_invalid_id || p >= func->blocks.len) continue;
+                IrCfg_termSuccs(func, p, succs);
+                if (succs[0] != b && succs[1] != b) continue;
+                args[1 + 2 * len] = p;
+                args[2 + 2 * len] = args[2 + 2 * j];
+                len++;
+            }
+            args[0] = len;
+        }
+    }
+}
+
+// Remove the blocks that are not kept, renumbering the rest in order. A kept block that falls
+// through with ir_term_next has to be followed by a kept block, and jumps may only target kept
+// blocks.
+static void IrCfg_removeBlocks(IrFunc *func, const bool *keep, Arena *arena)
+{
+    uint32_t n = func->blocks.len;
+    uint32_t *map = IrCfg_alloc(arena, n, ir_invalid_id);
+    IrInstArray insts;
+    IrInstArray_init(&insts, &func->arena);
+    uint32_t len = 0;
+    for (IrBlockId b = 0; b < n; b++) {
+        if (!keep[b]) continue;
+        IrBlock block = func->blocks.data[b];
+        uint32_t start = insts.len;
+        IrInstArray_appendMany(&insts, &func->insts.data[block.start], block.len);
+        block.start = start;
+        map[b] = len;
+        func->blocks.data[len++] = block;
+    }
+    func->blocks.len = len;
+    func->insts = insts;
+
+    for (IrBlockId b = 0; b < len; b++) {
+        IrBlock *block = &func->blocks.data[b];
+        IrTerm *term = &block->term;
+        if (term->tag == ir_term_jmp) {
+            term->data.jmp.target = map[term->data.jmp.target];
+            assume(term->data.jmp.target != ir_invalid_id);
+        } else if (term->tag == ir_term_br) {
+            term->data.br.t = map[term->data.br.t];
+            term->data.br.f = map[term->data.br.f];
+            assume(term->data.br.t != ir_invalid_id && term->data.br.f != ir_invalid_id);
+        }
+        for (uint32_t i = block->start; i < block->start + block->len; i++) {
+            IrInst inst = func->insts.data[i];
+            if (inst.op != ir_op_phi) continue;
+            uint32_t *args = &func->extra.data[inst.data.phi.args];
+            for (uint32_t j = 0; j < args[0]; j++) args[1 + 2 * j] = map[args[1 + 2 * j]];
+        }
+    }
+    IrCfg_prunePhiArgs(func);
+}
@@ -0,0 +1,466 @@
+// IrSccp is conditional constant propagation over the SSA form ("Constant Propagation with
+// Conditional Branches", Wegman and Zadeck). Only edges out of blocks known to execute are
+// followed, so constants found on one side of a branch are not lost to the other side.
+//
+// Temps are folded to the value the emitted C computes: operands go through the integer promotions
+// and usual arithmetic conversions, and the result is converted to the type of the destination.
+// Operations C leaves undefined, such as signed overflow, division by zero or shifting past the
+// width, are not folded. Afterwards branches on constants become jumps, blocks that never execute
+// are removed and instructions whose value is no longer used are dropped.
+//
+// Rather than keeping def-use worklists this iterates over the executable blocks until nothing
+// changes, which reaches the same result and is quick for the size of functions seen so far.
+
+typedef enum {
+    ir_sccp_unknown,    // no definition has executed yet
+    ir_sccp_const,
+    ir_sccp_varying,
+} IrSccpState;
+
+typedef struct {
+    IrSccpState state;
+    int64_t value;      // normalized to the type of the temp, see IrSccp_convert
+} IrSccpValue;
+
+typedef struct {
+    Ctx *ctx;
+    IrFunc *func;
+    IrCfg cfg;
+    IrSccpValue *values;    // per temp
+    bool *edges;            // executable, in the layout of IrCfg.succs
+    bool *executable;       // per block
+    bool changed;
+} IrSccp;
+
+static bool IrSccp_isFoldable(tTypeInfo info)
+{
+    return info.class == class_int && info.bits <= 64;
+}
+
+// Wrap a value to the width of the type, sign-extending signed types.
+static int64_t IrSccp_convert(int64_t value, tTypeInfo info)
+{
+    if (info.bits >= 64) return value;
+    uint64_t mask = ((uint64_t)1 << info.bits) - 1;
+    uint64_t v = (uint64_t)value & mask;
+    if (info.is_signed && (v >> (info.bits - 1)) != 0) v |= ~mask;
+    return (int64_t)v;
+}
+
+static int64_t IrSccp_signedMin(tTypeInfo info)
+{
+    return info.bits >= 64 ? INT64_MIN : -((int64_t)1 << (info.bits - 1));
+}
+
+// Whether a value is representable in the signed type.
+static bool IrSccp_fitsSigned(int64_t value, tTypeInfo info)
+{
+    return IrSccp_convert(value, info) == value;
+}
+
+static tTypeInfo IrSccp_promote(tTypeInfo info)
+{
+    if (info.bits < 32) return (tTypeInfo){ .class = class_int, .bits = 32, .is_signed = true };
+    return info;
+}
+
+// The C usual arithmetic conversions, for integers of at most 64 bits.
+static tTypeInfo IrSccp_common(tTypeInfo a, tTypeInfo b)
+{
+    a = IrSccp_promote(a);
+    b = IrSccp_promote(b);
+    if (a.is_signed == b.is_signed) return a.bits >= b.bits ? a : b;
+    tTypeInfo u = a.is_signed ? b : a;
+    tTypeInfo s = a.is_signed ? a : b;
+    return u.bits >= s.bits ? u : s;
+}
+
+static tTypeInfo IrSccp_typeInfo(IrSccp *s, IrTempId t)
+{
+    return Ctx_getTypeInfo(s->ctx, s->func->temps.data[t].type);
+}
+
+static IrSccpValue IrSccp_const(int64_t value)
+{
+    return (IrSccpValue){ .state = ir_sccp_const, .value = value };
+}
+
+static const IrSccpValue ir_sccp_varying_value = { .state = ir_sccp_varying };
+
+// Fold a unary operation on the promoted operand, or fail.
+static bool IrSccp_foldUnary(IrOp op, tTypeInfo info, int64_t a, int64_t *result)
+{
+    tTypeInfo t = IrSccp_promote(info);
+    switch (op) {
+        case ir_op_cast:
+            *result = a;
+            return true;
+        case ir_op_negate:
+            // negating the minimum overflows a signed type
+            if (t.is_signed && IrSccp_convert(a, t) == IrSccp_signedMin(t)) return false;
+            *result = IrSccp_convert((int64_t)(0 - (uint64_t)a), t);
+            return true;
+        case ir_op_bw_not:
+            *result = IrSccp_convert(~a, t);
+            return true;
+        case ir_op_not:
+            *result = a == 0;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool IrSccp_foldShift(IrOp op, tTypeInfo a_info, int64_t a, tTypeInfo b_info, int64_t b, int64_t *result)
+{
+    tTypeInfo t = IrSccp_promote(a_info);
+    if ((b_info.is_signed && b < 0) || (uint64_t)b >= t.bits) return false;
+    a = IrSccp_convert(a, t);
+    if (op == ir_op_shr) {
+        *result = t.is_signed ? a >> b : (int64_t)((uint64_t)a >> b);
+        if (!t.is_signed && t.bits < 64) *result = IrSccp_convert(*result, t);
+        return true;
+    }
+    int64_t shifted = IrSccp_convert((int64_t)((uint64_t)a << b), t);
+    // shifting a signed value out of range is undefined
+    if (t.is_signed && (a < 0 || shifted < 0 || (shifted >> b) != a)) return false;
+    *result = shifted;
+    return true;
+}
+
+static bool IrSccp_foldBinary(IrOp op, tTypeInfo a_info, int64_t a, tTypeInfo b_info, int64_t b, int64_t *result)
+{
+    if (op == ir_op_shl || op == ir_op_shr) return IrSccp_foldShift(op, a_info, a, b_info, b, result);
+
+    tTypeInfo t = IrSccp_common(a_info, b_info);
+    a = IrSccp_convert(a, t);
+    b = IrSccp_convert(b, t);
+    uint64_t ua = (uint64_t)a;
+    uint64_t ub = (uint64_t)b;
+    // unsigned values are stored zero-extended below 64 bits, so only 64 bits need the unsigned compare
+    bool lt = t.is_signed ? a < b : ua < ub;
+    bool gt = t.is_signed ? a > b : ua > ub;
+    switch (op) {
+        case ir_op_or:
+            *result = a != 0 || b != 0;
+            return true;
+        case ir_op_and:
+            *result = a != 0 && b != 0;
+            return true;
+        case ir_op_eq:
+            *result = a == b;
+            return true;
+        case ir_op_neq:
+            *result = a != b;
+            return true;
+        case ir_op_lt:
+            *result = lt;
+            return true;
+        case ir_op_gt:
+            *result = gt;
+            return true;
+        case ir_op_lte:
+            *result = !gt;
+            return true;
+        case ir_op_gte:
+            *result = !lt;
+            return true;
+        case ir_op_bit_and:
+            *result = a & b;
+            return true;
+        case ir_op_bit_xor:
+            *result = a ^ b;
+            return true;
+        case ir_op_add:
+        case ir_op_sub:
+        case ir_op_mul:
+        {
+            if (!t.is_signed) {
+                uint64_t r = op == ir_op_add ? ua + ub : op == ir_op_sub ? ua - ub : ua * ub;
+                *result = IrSccp_convert((int64_t)r, t);
+                return true;
+            }
+            // signed overflow is undefined, leave it to run
+            int64_t r;
+            bool overflow = op == ir_op_add ? __builtin_add_overflow(a, b, &r)
+                : op == ir_op_sub ? __builtin_sub_overflow(a, b, &r)
+                : __builtin_mul_overflow(a, b, &r);
+            if (overflow || !IrSccp_fitsSigned(r, t)) return false;
+            *result = r;
+            return true;
+        }
+        case ir_op_div:
+        case ir_op_mod:
+        {
+            if (b == 0) return false;
+            if (t.is_signed) {
+                if (a == IrSccp_signedMin(t) && b == -1) return false;
+                *result = op == ir_op_div ? a / b : a % b;
+            } else {
+                *result = (int64_t)(op == ir_op_div ? ua / ub : ua % ub);
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+static IrSccpValue IrSccp_evalPhi(IrSccp *s, IrBlockId b, IrInst inst)
+{
+    uint32_t len = s->func->extra.data[inst.data.phi.args];
+    const uint32_t *args = &s->func->extra.data[inst.data.phi.args + 1];
+    IrSccpValue result = { .state = ir_sccp_unknown };
+    for (uint32_t i = 0; i < len; i++) {
+        IrBlockId p = args[2 * i];
+        bool executable = (s->cfg.succs[2 * p] == b && s->edges[2 * p]) || (s->cfg.succs[2 * p + 1] == b && s->edges[2 * p + 1]);
+        if (!executable) continue;
+        IrSccpValue v = s->values[args[2 * i + 1]];
+        if (v.state == ir_sccp_unknown) continue;
+        if (v.state == ir_sccp_varying) return v;
+        if (result.state == ir_sccp_const && result.value != v.value) return ir_sccp_varying_value;
+        result = v;
+    }
+    return result;
+}
+
+static IrSccpValue IrSccp_eval(IrSccp *s, IrBlockId b, IrInst inst)
+{
+    switch (inst.op) {
+        case ir_op_const_num:
+        case ir_op_const_char:
+            return IrSccp_const(IrSccp_convert(inst.data.i64, IrSccp_typeInfo(s, inst.dst)));
+
+        case ir_op_phi:
+            return IrSccp_evalPhi(s, b, inst);
+
+        case ir_op_cast:
+        case ir_op_negate:
+        case ir_op_bw_not:
+        case ir_op_not:
+        case ir_op_or:
+        case ir_op_and:
+        case ir_op_eq:
+        case ir_op_neq:
+        case ir_op_lt:
+        case ir_op_gt:
+        case ir_op_lte:
+        case ir_op_gte:
+        case ir_op_bit_and:
+        case ir_op_bit_xor:
+        case ir_op_shl:
+        case ir_op_shr:
+        case ir_op_add:
+        case ir_op_sub:
+        case ir_op_mul:
+        case ir_op_div:
+        case ir_op_mod:
+            break;
+
+        default:
+            return ir_sccp_varying_value;
+    }
+
+    IrOperands ops = IrFunc_operands(s->func, &inst);
+    tTypeInfo info[2];
+    for (uint32_t i = 0; i < ops.len; i++) {
+        IrTempId t = ops.data[i];
+        if (s->values[t].state == ir_sccp_varying) return ir_sccp_varying_value;
+        info[i] = IrSccp_typeInfo(s, t);
+        if (!IrSccp_isFoldable(info[i])) return ir_sccp_varying_value;
+    }
+    for (uint32_t i = 0; i < ops.len; i++) {
+        if (s->values[ops.data[i]].state == ir_sccp_unknown) return (IrSccpValue){ .state = ir_sccp_unknown };
+    }
+
+    tTypeInfo dst_info = IrSccp_typeInfo(s, inst.dst);
+    if (!IrSccp_isFoldable(dst_info)) return ir_sccp_varying_value;
+    int64_t a = s->values[ops.data[0]].value;
+    int64_t result;
+    bool folded = ops.len == 1
+        ? IrSccp_foldUnary(inst.op, info[0], a, &result)
+        : IrSccp_foldBinary(inst.op, info[0], a, info[1], s->values[ops.data[1]].value, &result);
+    if (!folded) return ir_sccp_varying_value;
+    return IrSccp_const(IrSccp_convert(result, dst_info));
+}
+
+static void IrSccp_set(IrSccp *s, IrTempId t, IrSccpValue v)
+{
+    IrSccpValue *old = &s->values[t];
+    if (old->state == v.state && (v.state != ir_sccp_const || old->value == v.value)) return;
+    // values only move down the lattice, a constant that changes is varying
+    if (old->state == ir_sccp_varying) return;
+    if (old->state == ir_sccp_const && v.state != ir_sccp_varying) v = ir_sccp_varying_value;
+    *old = v;
+    s->changed = true;
+}
+
+static void IrSccp_markEdge(IrSccp *s, IrBlockId b, uint32_t j)
+{
+    IrBlockId succ = s->cfg.succs[2 * b + j];
+    if (succ == ir_invalid_id || s->edges[2 * b + j]) return;
+    s->edges[2 * b + j] = true;
+    s->executable[succ] = true;
+    s->changed = true;
+}
+
+static void IrSccp_visitBlock(IrSccp *s, IrBlockId b)
+{
+    IrBlock *block = &s->func->blocks.data[b];
+    for (uint32_t i = block->start; i < block->start + block->len; i++) {
+        IrInst inst = s->func->insts.data[i];
+        if (IrOp_hasDst(inst.op)) IrSccp_set(s, inst.dst, IrSccp_eval(s, b, inst));
+    }
+
+    if (block->term.tag != ir_term_br) {
+        IrSccp_markEdge(s, b, 0);
+        return;
+    }
+    IrSccpValue cond = s->values[block->term.data.br.cond];
+    if (cond.state == ir_sccp_varying) {
+        IrSccp_markEdge(s, b, 0);
+        IrSccp_markEdge(s, b, 1);
+    } else if (cond.state == ir_sccp_const) {
+        // succs[1] is absent if both targets are the same block
+        IrBlockId target = cond.value != 0 ? block->term.data.br.t : block->term.data.br.f;
+        IrSccp_markEdge(s, b, s->cfg.succs[2 * b] == target ? 0 : 1);
+    }
+}
+
+static bool IrSccp_isPure(IrOp op)
+{
+    switch (op) {
+        case ir_op_call:
+        case ir_op_copy:
+        case ir_op_store_var:
+        case ir_op_div:     // may trap, unless it was folded
+        case ir_op_mod:
+        case ir_op_unreachable:
+        case ir_op_invalid:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// Drop pure instructions whose value is unused, until there are none. Temps assigned by copy keep
+// their defining instruction as that is where C declares them.
+static void IrSccp_removeDead(IrSccp *s, const bool *pinned, Arena *arena)
+{
+    IrFunc *func = s->func;
+    uint32_t *uses = IrCfg_alloc(arena, func->temps.len, 0);
+    bool *dead = Arena_alloc(arena, func->insts.len ? func->insts.len : 1);
+    for (uint32_t i = 0; i < func->insts.len; i++) {
+        dead[i] = false;
+        IrOperands ops = IrFunc_operands(func, &func->insts.data[i]);
+        for (uint32_t j = 0; j < ops.len; j++) uses[ops.data[j * ops.stride]]++;
+    }
+    for (IrBlockId b = 0; b < func->blocks.len; b++) {
+        IrTempId *t = IrTerm_operand(&func->blocks.data[b].term);
+        if (t) uses[*t]++;
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t i = func->insts.len; i-- > 0;) {
+            IrInst *inst = &func->insts.data[i];
+            if (dead[i] || !IrOp_hasDst(inst->op) || !IrSccp_isPure(inst->op)) continue;
+            if (uses[inst->dst] != 0 || pinned[inst->dst]) continue;
+            dead[i] = true;
+            changed = true;
+            IrOperands ops = IrFunc_operands(func, inst);
+            for (uint32_t j = 0; j < ops.len; j++) uses[ops.data[j * ops.stride]]--;
+        }
+    }
+
+    uint32_t len = 0;
+    for (IrBlockId b = 0; b < func->blocks.len; b++) {
+        IrBlock *block = &func->blocks.data[b];
+        uint32_t start = len;
+        for (uint32_t i = block->start; i < block->start + block->len; i++) {
+            if (!dead[i]) func->insts.data[len++] = func->insts.data[i];
+        }
+        block->start = start;
+        block->len = len - start;
+    }
+    func->insts.len = len;
+}
+
+// Move the phis that were not folded back in front of the rest of the block.
+static void IrSccp_phisFirst(IrFunc *func, IrBlock *block)
+{
+    uint32_t phis = block->start;
+    for (uint32_t i = block->start; i < block->start + block->len; i++) {
+        IrInst inst = func->insts.data[i];
+        if (inst.op != ir_op_phi) continue;
+        for (uint32_t j = i; j > phis; j--) func->insts.data[j] = func->insts.data[j - 1];
+        func->insts.data[phis++] = inst;
+    }
+}
+
+static void IrSccp_runFunc(Ctx *ctx, IrFunc *func)
+{
+    if (func->blocks.len == 0) return;
+
+    Arena arena;
+    Arena_init(&arena);
+    IrSccp s = { .ctx = ctx, .func = func };
+    IrCfg_build(&s.cfg, func, &arena);
+
+    uint32_t blocks_len = func->blocks.len;
+    uint32_t temps_len = func->temps.len;
+    s.values = Arena_alloc(&arena, sizeof(IrSccpValue) * temps_len);
+    for (uint32_t i = 0; i < temps_len; i++) s.values[i] = (IrSccpValue){ .state = ir_sccp_unknown };
+    s.edges = Arena_alloc(&arena, 2 * blocks_len);
+    s.executable = Arena_alloc(&arena, blocks_len);
+    for (uint32_t i = 0; i < 2 * blocks_len; i++) s.edges[i] = false;
+    for (uint32_t i = 0; i < blocks_len; i++) s.executable[i] = i == 0;
+
+    // temps assigned by copy are not in SSA form, they have more than one definition
+    bool *pinned = Arena_alloc(&arena, temps_len);
+    for (uint32_t i = 0; i < temps_len; i++) pinned[i] = false;
+    for (uint32_t i = 0; i < func->insts.len; i++) {
+        IrInst inst = func->insts.data[i];
+        if (inst.op == ir_op_copy) {
+            pinned[inst.dst] = true;
+            s.values[inst.dst] = ir_sccp_varying_value;
+        }
+    }
+
+    s.changed = true;
+    while (s.changed) {
+        s.changed = false;
+        for (uint32_t i = 0; i < s.cfg.rpo_len; i++) {
+            if (s.executable[s.cfg.rpo[i]]) IrSccp_visitBlock(&s, s.cfg.rpo[i]);
+        }
+    }
+
+    for (IrBlockId b = 0; b < blocks_len; b++) {
+        if (!s.executable[b]) continue;
+        IrBlock *block = &func->blocks.data[b];
+        for (uint32_t i = block->start; i < block->start + block->len; i++) {
+            IrInst *inst = &func->insts.data[i];
+            if (!IrOp_hasDst(inst->op) || inst->op == ir_op_const_num || inst->op == ir_op_const_char) continue;
+            IrSccpValue v = s.values[inst->dst];
+            // INT64_MIN has no literal in C
+            if (v.state != ir_sccp_const || v.value == INT64_MIN) continue;
+            *inst = (IrInst){ .op = ir_op_const_num, .dst = inst->dst, .data = { .i64 = v.value } };
+        }
+        IrSccp_phisFirst(func, block);
+        IrTerm *term = &block->term;
+        if (term->tag == ir_term_br && s.values[term->data.br.cond].state == ir_sccp_const) {
+            IrBlockId target = s.values[term->data.br.cond].value != 0 ? term->data.br.t : term->data.br.f;
+            *term = (IrTerm){ .tag = ir_term_jmp, .data = { .jmp = { .target = target } } };
+        }
+    }
+
+    IrCfg_removeBlocks(func, s.executable, &arena);
+    IrSccp_removeDead(&s, pinned, &arena);
+    Arena_deinit(&arena);
+}
+
+static void IrSccp_run(IrProgram *p)
+{
+    for (uint32_t i = 0; i < p->funcs.len; i++) IrSccp_runFunc(p->ctx, p->funcs.data[i]);
+}
@@ -0,0 +1,188 @@
+// IrSimplify cleans up the control flow left by lowering and the other passes:
+//
+//  - jumps to an empty block that only jumps on are threaded through to its target
+//  - blocks that are unreachable from the entry are removed
+//  - a block whose only successor has it as its only predecessor absorbs that successor
+//  - a jump to the following block becomes a fallthrough
+//
+// It runs on the SSA form. Jumps are not threaded into blocks with phis, as that would change
+// their predecessors. A block is only absorbed by an earlier block, so that the instructions keep
+// their order for codegen.
+
+typedef struct {
+    IrFunc *func;
+    IrTempId *replace;      // the temp to use instead, for phis left with a single argument
+    IrBlockId *merged_into; // ir_invalid_id unless absorbed into another block
+    IrBlockId *chain;       // the block absorbed into this one, or ir_invalid_id
+} IrSimplify;
+
+static bool IrSimplify_hasPhis(const IrFunc *func, IrBlockId b)
+{
+    IrBlock block = func->blocks.data[b];
+    return block.len != 0 && func->insts.data[block.start].op == ir_op_phi;
+}
+
+// Make falling through to the next block an explicit jump, so blocks can be moved around. Falling
+// off the end of the function stays as it is.
+static void IrSimplify_explicitJumps(IrFunc *func)
+{
+    for (IrBlockId b = 0; b + 1 < func->blocks.len; b++) {
+        IrTerm *term = &func->blocks.data[b].term;
+        if (term->tag == ir_term_next) *term = (IrTerm){ .tag = ir_term_jmp, .data = { .jmp = { .target = b + 1 } } };
+    }
+}
+
+// Follow empty blocks that jump on, stopping before any block with phis.
+static IrBlockId IrSimplify_threadTarget(const IrFunc *func, IrBlockId target)
+{
+    for (uint32_t i = 0; i < func->blocks.len; i++) {
+        IrBlock block = func->blocks.data[target];
+        if (target == 0 || block.len != 0 || block.term.tag != ir_term_jmp) break;
+        IrBlockId next = block.term.data.jmp.target;
+        if (next == target || IrSimplify_hasPhis(func, next)) break;
+        target = next;
+    }
+    return target;
+}
+
+static void IrSimplify_threadJumps(IrFunc *func)
+{
+    for (IrBlockId b = 0; b < func->blocks.len; b++) {
+        IrTerm *term = &func->blocks.data[b].term;
+        if (term->tag == ir_term_jmp) {
+            term->data.jmp.target = IrSimplify_threadTarget(func, term->data.jmp.target);
+        } else if (term->tag == ir_term_br) {
+            term->data.br.t = IrSimplify_threadTarget(func, term->data.br.t);
+            term->data.br.f = IrSimplify_threadTarget(func, term->data.br.f);
+            if (term->data.br.t == term->data.br.f) {
+                *term = (IrTerm){ .tag = ir_term_jmp, .data = { .jmp = { .target = term->data.br.t } } };
+            }
+        }
+    }
+}
+
+// Absorb the chain of blocks following b that have a single predecessor.
+static void IrSimplify_mergeChain(IrSimplify *s, const IrCfg *cfg, IrBlockId b)
+{
+    IrFunc *func = s->func;
+    IrBlockId tail = b;
+    while (func->blocks.data[b].term.tag == ir_term_jmp) {
+        IrBlockId succ = func->blocks.data[b].term.data.jmp.target;
+        if (succ <= tail || IrCfg_predsLen(cfg, succ) != 1) break;
+        // falling off the end of the function only works from the last block
+        if (func->blocks.data[succ].term.tag == ir_term_next) break;
+
+        // a single predecessor leaves each phi with its one argument
+        IrBlock *block = &func->blocks.data[succ];
+        while (block->len != 0 && func->insts.data[block->start].op == ir_op_phi) {
+            IrInst phi = func->insts.data[block->start];
+            assume(func->extra.data[phi.data.phi.args] == 1);
+            s->replace[phi.dst] = func->extra.data[phi.data.phi.args + 2];
+            block->start++;
+            block->len--;
+        }
+
+        s->chain[tail] = succ;
+        s->merged_into[succ] = b;
+        func->blocks.data[b].term = block->term;
+        tail = succ;
+    }
+}
+
+static IrTempId IrSimplify_resolve(const IrSimplify *s, IrTempId t)
+{
+    while (s->replace[t] != ir_invalid_id) t = s->replace[t];
+    return t;
+}
+
+static void IrSimplify_replaceOperands(IrSimplify *s)
+{
+    IrFunc *func = s->func;
+    for (uint32_t i = 0; i < func->insts.len; i++) {
+        IrOperands ops = IrFunc_operands(func, &func->insts.data[i]);
+        for (uint32_t j = 0; j < ops.len; j++) {
+            ops.data[j * ops.stride] = IrSimplify_resolve(s, ops.data[j * ops.stride]);
+        }
+    }
+    for (IrBlockId b = 0; b < func->blocks.len; b++) {
+        IrTempId *t = IrTerm_operand(&func->blocks.data[b].term);
+        if (t) *t = IrSimplify_resolve(s, *t);
+    }
+}
+
+// Lay out each chain of merged blocks as the one block at its head, and move the phi arguments
+// from absorbed blocks over to the head.
+static void IrSimplify_layout(IrSimplify *s)
+{
+    IrFunc *func = s->func;
+    IrInstArray insts;
+    IrInstArray_init(&insts, &func->arena);
+    IrInstArray_reserve(&insts, func->insts.len);
+    for (IrBlockId b = 0; b < func->blocks.len; b++) {
+        if (s->merged_into[b] != ir_invalid_id) continue;
+        uint32_t start = insts.len;
+        for (IrBlockId c = b; c != ir_invalid_id; c = s->chain[c]) {
+            IrBlock block = func->blocks.data[c];
+            IrInstArray_appendMany(&insts, &func->insts.data[block.start], block.len);
+        }
+        func->blocks.data[b].start = start;
+        func->blocks.data[b].len = insts.len - start;
+    }
+    func->insts = insts;
+
+    for (uint32_t i = 0; i < func->insts.len; i++) {
+        IrInst inst = func->insts.data[i];
+        if (inst.op != ir_op_phi) continue;
+        uint32_t *args = &func->extra.data[inst.data.phi.args];
+        for (uint32_t j = 0; j < args[0]; j++) {
+            IrBlockId p = args[1 + 2 * j];
+            if (p != ir_invalid_id && s->merged_into[p] != ir_invalid_id) args[1 + 2 * j] = s->merged_into[p];
+        }
+    }
+}
+
+static void IrSimplify_implicitJumps(IrFunc *func)
+{
+    for (IrBlockId b = 0; b < func->blocks.len; b++) {
+        IrTerm *term = &func->blocks.data[b].term;
+        if (term->tag == ir_term_jmp && term->data.jmp.target == b + 1) *term = (IrTerm){ .tag = ir_term_next };
+    }
+}
+
+static void IrSimplify_runFunc(IrFunc *func)
+{
+    if (func->blocks.len == 0) return;
+
+    Arena arena;
+    Arena_init(&arena);
+    IrSimplify s = {
+        .func = func,
+        .replace = IrCfg_alloc(&arena, func->temps.len, ir_invalid_id),
+        .merged_into = IrCfg_alloc(&arena, func->blocks.len, ir_invalid_id),
+        .chain = IrCfg_alloc(&arena, func->blocks.len, ir_invalid_id),
+    };
+
+    IrSimplify_explicitJumps(func);
+    IrSimplify_threadJumps(func);
+
+    IrCfg cfg;
+    IrCfg_build(&cfg, func, &arena);
+    for (IrBlockId b = 0; b < func->blocks.len; b++) {
+        if (IrCfg_isReachable(&cfg, b) && s.merged_into[b] == ir_invalid_id) IrSimplify_mergeChain(&s, &cfg, b);
+    }
+    IrSimplify_replaceOperands(&s);
+    IrSimplify_layout(&s);
+
+    bool *keep = Arena_alloc(&arena, func->blocks.len);
+    for (IrBlockId b = 0; b < func->blocks.len; b++) {
+        keep[b] = IrCfg_isReachable(&cfg, b) && s.merged_into[b] == ir_invalid_id;
+    }
+    IrCfg_removeBlocks(func, keep, &arena);
+    IrSimplify_implicitJumps(func);
+    Arena_deinit(&arena);
+}
+
+static void IrSimplify_run(IrProgram *p)
+{
+    for (uint32_t i = 0; i < p->funcs.len; i++) IrSimplify_runFunc(p->funcs.data[i]);
+}
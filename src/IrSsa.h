@@ -0,0 +1,521 @@
+// IrSsa converts variables to SSA form and back.
+//
+// IrSsa_construct (mem2reg) replaces load_var and store_var with the temps that were stored, and
+// inserts phis where different stores meet, at the iterated dominance frontiers of the stores
+// ("Efficiently Computing Static Single Assignment Form and the Control Dependence Graph",
+// Cytron et al.). A variable may only be promoted if its address is never taken. Nothing in the
+// IR can take one (& applies to a loaded temp), so every variable is. Unreachable blocks are left
+// as they are, the variables stay declared for them.
+//
+// IrSsa_destruct gives each phi a variable of its own, stored at the end of each predecessor and
+// loaded in place of the phi. Each phi only ever reads and writes its own variable, so no copies
+// interfere and critical edges need no splitting. It runs just before codegen.
+
+typedef struct {
+    IrBlockId block;
+    IrVarId var;
+    IrTempId dst;
+    uint32_t args;      // in IrFunc.extra, as for ir_op_phi
+    uint32_t filled;
+    uint32_t next;      // next phi of the block, or ir_invalid_id
+    bool removed;
+} IrSsaPhi;
+
+DEFINE_ARENA_ARRAY(IrSsaPhi);
+
+typedef struct {
+    IrFunc *func;
+    IrCfg cfg;
+    IrSsaPhiArray phis;
+    uint32_t *block_phis;   // first phi of each block
+    IrTempId *current;      // value of each variable during renaming, ir_invalid_id if not stored yet
+    IrTempId *entry;        // value of each variable at entry, loaded on first use
+    IrTempId *replace;      // value that replaces a removed temp, ir_invalid_id if kept
+    uint32_t replace_len;
+    bool *removed;          // per instruction
+    IndexArray undo;        // (var, previous value) pairs to restore when leaving a block
+} IrSsa;
+
+static IrTempId IrSsa_resolve(const IrSsa *s, IrTempId t)
+{
+    while (t < s->replace_len && s->replace[t] != ir_invalid_id) t = s->replace[t];
+    return t;
+}
+
+static IrTempId IrSsa_value(IrSsa *s, IrVarId var)
+{
+    if (s->current[var] != ir_invalid_id) return s->current[var];
+    if (s->entry[var] == ir_invalid_id) s->entry[var] = IrFunc_newTemp(s->func, s->func->vars.data[var].type);
+    return s->entry[var];
+}
+
+static void IrSsa_define(IrSsa *s, IrVarId var, IrTempId value)
+{
+    IndexArray_append(&s->undo, var);
+    IndexArray_append(&s->undo, s->current[var]);
+    s->current[var] = value;
+}
+
+static void IrSsa_insertPhis(IrSsa *s, Arena *arena)
+{
+    IrFunc *func = s->func;
+    uint32_t blocks_len = func->blocks.len;
+    uint32_t vars_len = func->vars.len;
+
+    // blocks storing to each variable, same layout as the IrCfg lists
+    uint32_t *count = IrCfg_alloc(arena, vars_len, 0);
+    uint32_t *last = IrCfg_alloc(arena, vars_len, ir_invalid_id);
+    uint32_t *defs_start = IrCfg_alloc(arena, vars_len + 1, 0);
+    IrBlockId *defs = NULL;
+    for (uint32_t pass = 0; pass < 2; pass++) {
+        for (uint32_t i = 0; i < s->cfg.rpo_len; i++) {
+            IrBlockId b = s->cfg.rpo[i];
+            IrBlock *block = &func->blocks.data[b];
+            for (uint32_t j = 0; j < block->len; j++) {
+                IrInst inst = func->insts.data[block->start + j];
+                if (inst.op != ir_op_store_var || last[inst.data.var.id] == b) continue;
+                IrVarId v = inst.data.var.id;
+                last[v] = b;
+                if (pass == 1) defs[defs_start[v] + count[v]] = b;
+                count[v]++;
+            }
+        }
+        if (pass == 0) {
+            IrCfg_offsets(vars_len, defs_start, count);
+            defs = IrCfg_alloc(arena, defs_start[vars_len], 0);
+            for (uint32_t v = 0; v < vars_len; v++) last[v] = ir_invalid_id;
+        }
+    }
+
+    // a block is on the worklist at most once per variable
+    IrBlockId *work = IrCfg_alloc(arena, blocks_len, 0);
+    uint32_t *has_phi = IrCfg_alloc(arena, blocks_len, ir_invalid_id);
+    uint32_t *queued = IrCfg_alloc(arena, blocks_len, ir_invalid_id);
+    uint32_t *block_last = IrCfg_alloc(arena, blocks_len, ir_invalid_id);
+    for (IrVarId v = 0; v < vars_len; v++) {
+        uint32_t work_len = 0;
+        for (uint32_t i = defs_start[v]; i < defs_start[v + 1]; i++) {
+            work[work_len++] = defs[i];
+            queued[defs[i]] = v;
+        }
+        while (work_len) {
+            IrBlockId b = work[--work_len];
+            for (uint32_t i = s->cfg.df_start[b]; i < s->cfg.df_start[b + 1]; i++) {
+                IrBlockId d = s->cfg.df[i];
+                if (has_phi[d] != v) {
+                    has_phi[d] = v;
+                    uint32_t preds_len = IrCfg_predsLen(&s->cfg, d);
+                    uint32_t args = IrExtraArray_append(&func->extra, preds_len);
+                    for (uint32_t j = 0; j < 2 * preds_len; j++) IrExtraArray_append(&func->extra, ir_invalid_id);
+                    uint32_t id = IrSsaPhiArray_append(&s->phis, (IrSsaPhi){
+                        .block = d,
+                        .var = v,
+                        .dst = IrFunc_newTemp(func, func->vars.data[v].type),
+                        .args = args,
+                        .next = ir_invalid_id,
+                    });
+                    if (block_last[d] == ir_invalid_id) s->block_phis[d] = id;
+                    else s->phis.data[block_last[d]].next = id;
+                    block_last[d] = id;
+                }
+                if (queued[d] != v) {
+                    queued[d] = v;
+                    work[work_len++] = d;
+                }
+            }
+        }
+    }
+}
+
+static void IrSsa_rename(IrSsa *s, IrBlockId b)
+{
+    IrFunc *func = s->func;
+    uint32_t undo_len = s->undo.len;
+
+    for (uint32_t i = s->block_phis[b]; i != ir_invalid_id; i = s->phis.data[i].next) {
+        IrSsa_define(s, s->phis.data[i].var, s->phis.data[i].dst);
+    }
+
+    IrBlock *block = &func->blocks.data[b];
+    for (uint32_t i = block->start; i < block->start + block->len; i++) {
+        IrInst *inst = &func->insts.data[i];
+        if (inst->op == ir_op_load_var) {
+            s->replace[inst->dst] = IrSsa_value(s, inst->data.var.id);
+            s->removed[i] = true;
+        } else if (inst->op == ir_op_store_var) {
+            // C converts the value when storing it, which the promoted value has to keep doing
+            IrVarId v = inst->data.var.id;
+            IrTempId value = IrSsa_resolve(s, inst->data.var.value);
+            tInternId type = func->vars.data[v].type;
+            if (func->temps.data[value].type == type) {
+                s->removed[i] = true;
+            } else {
+                *inst = (IrInst){
+                    .op = ir_op_cast,
+                    .dst = IrFunc_newTemp(func, type),
+                    .data = { .unary = { .lhs = value } },
+                };
+                value = inst->dst;
+            }
+            IrSsa_define(s, v, value);
+        }
+    }
+
+    for (uint32_t j = 0; j < 2; j++) {
+        IrBlockId succ = s->cfg.succs[2 * b + j];
+        if (succ == ir_invalid_id) continue;
+        for (uint32_t i = s->block_phis[succ]; i != ir_invalid_id; i = s->phis.data[i].next) {
+            IrSsaPhi *phi = &s->phis.data[i];
+            uint32_t *arg = &func->extra.data[phi->args + 1 + 2 * phi->filled++];
+            arg[0] = b;
+            arg[1] = IrSsa_value(s, phi->var);
+        }
+    }
+
+    for (uint32_t i = s->cfg.children_start[b]; i < s->cfg.children_start[b + 1]; i++) {
+        IrSsa_rename(s, s->cfg.children[i]);
+    }
+
+    while (s->undo.len > undo_len) {
+        s->undo.len -= 2;
+        s->current[s->undo.data[s->undo.len]] = s->undo.data[s->undo.len + 1];
+    }
+}
+
+// Replace phis whose arguments are all the same value, or the phi itself, by that value. Removing
+// one can make another trivial, so repeat until nothing changes.
+static void IrSsa_removeTrivialPhis(IrSsa *s)
+{
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t i = 0; i < s->phis.len; i++) {
+            IrSsaPhi *phi = &s->phis.data[i];
+            if (phi->removed) continue;
+            uint32_t len = s->func->extra.data[phi->args];
+            const uint32_t *args = &s->func->extra.data[phi->args + 1];
+            IrTempId same = ir_invalid_id;
+            bool trivial = true;
+            for (uint32_t j = 0; j < len && trivial; j++) {
+                IrTempId a = IrSsa_resolve(s, args[2 * j + 1]);
+                if (a == phi->dst || a == same) continue;
+                if (same != ir_invalid_id) trivial = false;
+                same = a;
+            }
+            if (!trivial || same == ir_invalid_id) continue;
+            s->replace[phi->dst] = same;
+            phi->removed = true;
+            changed = true;
+        }
+    }
+}
+
+static void IrSsa_resolveOperands(IrSsa *s, IrOperands ops)
+{
+    for (uint32_t i = 0; i < ops.len; i++) {
+        ops.data[i * ops.stride] = IrSsa_resolve(s, ops.data[i * ops.stride]);
+    }
+}
+
+static void IrSsa_markOperands(bool *used, IrOperands ops)
+{
+    for (uint32_t i = 0; i < ops.len; i++) used[ops.data[i * ops.stride]] = true;
+}
+
+// Drop the phis and entry loads nothing reads. A phi that is only read by unused phis, such as
+// one for a variable that is dead around a loop, is unused too.
+static void IrSsa_markUsed(IrSsa *s, bool *used)
+{
+    IrFunc *func = s->func;
+    for (uint32_t i = 0; i < func->temps.len; i++) used[i] = false;
+    for (IrBlockId b = 0; b < func->blocks.len; b++) {
+        IrBlock *block = &func->blocks.data[b];
+        for (uint32_t i = block->start; i < block->start + block->len; i++) {
+            if (!s->removed[i]) IrSsa_markOperands(used, IrFunc_operands(func, &func->insts.data[i]));
+        }
+        IrTempId *t = IrTerm_operand(&block->term);
+        if (t) used[*t] = true;
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t i = 0; i < s->phis.len; i++) {
+            IrSsaPhi *phi = &s->phis.data[i];
+            if (phi->removed || !used[phi->dst]) continue;
+            uint32_t len = func->extra.data[phi->args];
+            for (uint32_t j = 0; j < len; j++) {
+                IrTempId a = func->extra.data[phi->args + 2 + 2 * j];
+                if (!used[a]) {
+                    used[a] = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+    for (uint32_t i = 0; i < s->phis.len; i++) {
+        if (!used[s->phis.data[i].dst]) s->phis.data[i].removed = true;
+    }
+}
+
+// Lay the instructions out again with the phis and entry loads at the start of their blocks.
+static void IrSsa_rebuild(IrSsa *s, const bool *used)
+{
+    IrFunc *func = s->func;
+    IrInstArray insts;
+    IrInstArray_init(&insts, &func->arena);
+    for (IrBlockId b = 0; b < func->blocks.len; b++) {
+        IrBlock *block = &func->blocks.data[b];
+        uint32_t start = insts.len;
+        if (b == 0) {
+            for (IrVarId v = 0; v < func->vars.len; v++) {
+                if (s->entry[v] == ir_invalid_id || !used[s->entry[v]]) continue;
+                IrInstArray_append(&insts, (IrInst){
+                    .op = ir_op_load_var,
+                    .dst = s->entry[v],
+                    .data = { .var = { .id = v, .value = ir_invalid_id } },
+                });
+            }
+        }
+        for (uint32_t i = s->block_phis[b]; i != ir_invalid_id; i = s->phis.data[i].next) {
+            IrSsaPhi *phi = &s->phis.data[i];
+            if (phi->removed) continue;
+            IrInstArray_append(&insts, (IrInst){
+                .op = ir_op_phi,
+                .dst = phi->dst,
+                .data = { .phi = { .var = phi->var, .args = phi->args } },
+            });
+        }
+        for (uint32_t i = block->start; i < block->start + block->len; i++) {
+            if (!s->removed[i]) IrInstArray_append(&insts, func->insts.data[i]);
+        }
+        block->start = start;
+        block->len = insts.len - start;
+    }
+    func->insts = insts;
+}
+
+static void IrSsa_constructFunc(IrFunc *func)
+{
+    if (func->blocks.len == 0 || func->vars.len == 0) return;
+
+    Arena arena;
+    Arena_init(&arena);
+    IrSsa s = { .func = func };
+    IrCfg_build(&s.cfg, func, &arena);
+    // the entry loads are only valid if the entry runs once
+    assume(IrCfg_predsLen(&s.cfg, 0) == 0);
+
+    IrSsaPhiArray_init(&s.phis, &arena);
+    s.block_phis = IrCfg_alloc(&arena, func->blocks.len, ir_invalid_id);
+    IrSsa_insertPhis(&s, &arena);
+
+    // renaming adds at most a cast per store and an entry load per variable
+    s.current = IrCfg_alloc(&arena, func->vars.len, ir_invalid_id);
+    s.entry = IrCfg_alloc(&arena, func->vars.len, ir_invalid_id);
+    s.replace_len = func->temps.len + func->insts.len + func->vars.len;
+    s.replace = IrCfg_alloc(&arena, s.replace_len, ir_invalid_id);
+    s.removed = Arena_alloc(&arena, func->insts.len ? func->insts.len : 1);
+    for (uint32_t i = 0; i < func->insts.len; i++) s.removed[i] = false;
+    IndexArray_init(&s.undo);
+    IrSsa_rename(&s, 0);
+    std_free(s.undo.data);
+
+    IrSsa_removeTrivialPhis(&s);
+    for (IrBlockId b = 0; b < func->blocks.len; b++) {
+        IrBlock *block = &func->blocks.data[b];
+        for (uint32_t i = block->start; i < block->start + block->len; i++) {
+            IrSsa_resolveOperands(&s, IrFunc_operands(func, &func->insts.data[i]));
+        }
+        IrTempId *t = IrTerm_operand(&block->term);
+        if (t) *t = IrSsa_resolve(&s, *t);
+    }
+    for (uint32_t i = 0; i < s.phis.len; i++) {
+        IrSsaPhi *phi = &s.phis.data[i];
+        IrSsa_resolveOperands(&s, (IrOperands){ &func->extra.data[phi->args + 2], func->extra.data[phi->args], 2 });
+    }
+
+    bool *used = Arena_alloc(&arena, func->temps.len);
+    IrSsa_markUsed(&s, used);
+    IrSsa_rebuild(&s, used);
+    Arena_deinit(&arena);
+}
+
+static void IrSsa_construct(IrProgram *p)
+{
+    for (uint32_t i = 0; i < p->funcs.len; i++) IrSsa_constructFunc(p->funcs.data[i]);
+}
+
+typedef struct {
+    IrVarId var;
+    IrTempId value;
+    uint32_t next;      // next store at the end of the same block, or ir_invalid_id
+} IrSsaStore;
+
+DEFINE_ARENA_ARRAY(IrSsaStore);
+
+static void IrSsa_addStore(IrSsaStoreArray *stores, uint32_t *block_stores, IrBlockId b, IrVarId var, IrTempId value)
+{
+    uint32_t id = IrSsaStoreArray_append(stores, (IrSsaStore){ .var = var, .value = value, .next = block_stores[b] });
+    block_stores[b] = id;
+}
+
+static IrTempId IrSsa_local(const IrTempId *local, IrTempId t)
+{
+    return local[t] != ir_invalid_id ? local[t] : t;
+}
+
+static void IrSsa_checkUse(IndexArray *reloads, const IrBlockId *decl, IrBlockId *seen, IrBlockId b, IrTempId t)
+{
+    if (decl[t] == ir_invalid_id || decl[t] <= b || seen[t] == b) return;
+    seen[t] = b;
+    IndexArray_append(reloads, b);
+    IndexArray_append(reloads, t);
+}
+
+static void IrSsa_markVars(const IrFunc *func, uint32_t *var_map)
+{
+    for (uint32_t i = 0; i < func->insts.len; i++) {
+        IrInst inst = func->insts.data[i];
+        if (inst.op == ir_op_load_var || inst.op == ir_op_store_var) var_map[inst.data.var.id] = 0;
+    }
+}
+
+// Drop the variables that are no longer loaded or stored and renumber the rest.
+static void IrSsa_compactVars(IrFunc *func, Arena *arena)
+{
+    uint32_t *var_map = IrCfg_alloc(arena, func->vars.len, ir_invalid_id);
+    IrSsa_markVars(func, var_map);
+    uint32_t len = 0;
+    for (IrVarId v = 0; v < func->vars.len; v++) {
+        if (var_map[v] == ir_invalid_id) continue;
+        var_map[v] = len;
+        func->vars.data[len++] = func->vars.data[v];
+    }
+    func->vars.len = len;
+    for (uint32_t i = 0; i < func->insts.len; i++) {
+        IrInst *inst = &func->insts.data[i];
+        if (inst->op == ir_op_load_var || inst->op == ir_op_store_var) inst->data.var.id = var_map[inst->data.var.id];
+    }
+}
+
+// Every temp has to be declared, by the instruction defining it, above its uses in the C output,
+// which is in block id order. SSA values reach any dominated block, which need not come later, so
+// such temps are passed through a variable as well.
+static void IrSsa_destructFunc(IrFunc *func, sInternId spill_name)
+{
+    if (func->blocks.len == 0) return;
+
+    Arena arena;
+    Arena_init(&arena);
+    uint32_t blocks_len = func->blocks.len;
+
+    IrSsaStoreArray stores;
+    IrSsaStoreArray_init(&stores, &arena);
+    uint32_t *block_stores = IrCfg_alloc(&arena, blocks_len, ir_invalid_id);
+    for (uint32_t i = 0; i < func->insts.len; i++) {
+        IrInst *inst = &func->insts.data[i];
+        if (inst->op != ir_op_phi) continue;
+        IrVar orig = func->vars.data[inst->data.phi.var];
+        IrVarId var = IrFunc_newVar(func, (IrVar){ .name = orig.name, .type = orig.type, .init_name = ir_invalid_id });
+        uint32_t len = func->extra.data[inst->data.phi.args];
+        for (uint32_t j = 0; j < len; j++) {
+            const uint32_t *arg = &func->extra.data[inst->data.phi.args + 1 + 2 * j];
+            IrSsa_addStore(&stores, block_stores, arg[0], var, arg[1]);
+        }
+        *inst = (IrInst){
+            .op = ir_op_load_var,
+            .dst = inst->dst,
+            .data = { .var = { .id = var, .value = ir_invalid_id } },
+        };
+    }
+
+    uint32_t temps_len = func->temps.len;
+    IrBlockId *decl = IrCfg_alloc(&arena, temps_len, ir_invalid_id);
+    for (IrBlockId b = 0; b < blocks_len; b++) {
+        IrBlock *block = &func->blocks.data[b];
+        for (uint32_t i = block->start; i < block->start + block->len; i++) {
+            IrInst inst = func->insts.data[i];
+            if (IrOp_hasDst(inst.op) && decl[inst.dst] == ir_invalid_id) decl[inst.dst] = b;
+        }
+    }
+
+    // (block, temp) pairs of uses above the declaration, at most once per block
+    IndexArray reloads;
+    IndexArray_init(&reloads);
+    IrVarId *spill = IrCfg_alloc(&arena, temps_len, ir_invalid_id);
+    IrBlockId *seen = IrCfg_alloc(&arena, temps_len, ir_invalid_id);
+    for (IrBlockId b = 0; b < blocks_len; b++) {
+        IrBlock *block = &func->blocks.data[b];
+        for (uint32_t i = block->start; i < block->start + block->len; i++) {
+            IrOperands ops = IrFunc_operands(func, &func->insts.data[i]);
+            for (uint32_t j = 0; j < ops.len; j++) IrSsa_checkUse(&reloads, decl, seen, b, ops.data[j * ops.stride]);
+        }
+        for (uint32_t k = block_stores[b]; k != ir_invalid_id; k = stores.data[k].next) {
+            IrSsa_checkUse(&reloads, decl, seen, b, stores.data[k].value);
+        }
+        IrTempId *t = IrTerm_operand(&block->term);
+        if (t) IrSsa_checkUse(&reloads, decl, seen, b, *t);
+    }
+    for (uint32_t i = 0; i < reloads.len; i += 2) {
+        IrTempId t = reloads.data[i + 1];
+        if (spill[t] != ir_invalid_id) continue;
+        spill[t] = IrFunc_newVar(func, (IrVar){ .name = spill_name, .type = func->temps.data[t].type, .init_name = ir_invalid_id });
+    }
+
+    IrTempId *local = IrCfg_alloc(&arena, temps_len, ir_invalid_id);
+    IrInstArray insts;
+    IrInstArray_init(&insts, &func->arena);
+    uint32_t r = 0;
+    for (IrBlockId b = 0; b < blocks_len; b++) {
+        IrBlock *block = &func->blocks.data[b];
+        uint32_t start = insts.len;
+        uint32_t reloads_start = r;
+        for (; r < reloads.len && reloads.data[r] == b; r += 2) {
+            IrTempId t = reloads.data[r + 1];
+            local[t] = IrFunc_newTemp(func, func->temps.data[t].type);
+            IrInstArray_append(&insts, (IrInst){
+                .op = ir_op_load_var,
+                .dst = local[t],
+                .data = { .var = { .id = spill[t], .value = ir_invalid_id } },
+            });
+        }
+        for (uint32_t i = block->start; i < block->start + block->len; i++) {
+            IrInst inst = func->insts.data[i];
+            IrOperands ops = IrFunc_operands(func, &inst);
+            for (uint32_t j = 0; j < ops.len; j++) ops.data[j * ops.stride] = IrSsa_local(local, ops.data[j * ops.stride]);
+            IrInstArray_append(&insts, inst);
+            bool defines = IrOp_hasDst(inst.op) || inst.op == ir_op_copy;
+            if (defines && inst.dst < temps_len && spill[inst.dst] != ir_invalid_id) {
+                IrInstArray_append(&insts, (IrInst){
+                    .op = ir_op_store_var,
+                    .dst = ir_invalid_id,
+                    .data = { .var = { .id = spill[inst.dst], .value = inst.dst } },
+                });
+            }
+        }
+        for (uint32_t k = block_stores[b]; k != ir_invalid_id; k = stores.data[k].next) {
+            IrInstArray_append(&insts, (IrInst){
+                .op = ir_op_store_var,
+                .dst = ir_invalid_id,
+                .data = { .var = { .id = stores.data[k].var, .value = IrSsa_local(local, stores.data[k].value) } },
+            });
+        }
+        IrTempId *t = IrTerm_operand(&block->term);
+        if (t) *t = IrSsa_local(local, *t);
+        for (uint32_t i = reloads_start; i < r; i += 2) local[reloads.data[i + 1]] = ir_invalid_id;
+        block->start = start;
+        block->len = insts.len - start;
+    }
+    func->insts = insts;
+    std_free(reloads.data);
+
+    IrSsa_compactVars(func, &arena);
+    Arena_deinit(&arena);
+}
+
+static void IrSsa_destruct(IrProgram *p)
+{
+    sInternId spill_name = Ctx_putString(p->ctx, (Buffer){ .data = "spill", .len = 5 });
+    for (uint32_t i = 0; i < p->funcs.len; i++) IrSsa_destructFunc(p->funcs.data[i], spill_name);
+}
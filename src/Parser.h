@@ -4,48 +4,53 @@
 
 //#define TRACE
 
-// TODO: can we just track the last p->index and compare against to check invalid cycles/loops
-#define LOOP_MAX 3000
-
 typedef struct Node Node;
 
+// Nodes reference other nodes, tokens and lists by 32-bit index into the Ast arrays.
+typedef uint32_t NodeIndex;     // into Ast.nodes, NODE_NONE if absent
+typedef uint32_t TokenIndex;    // into the token list, TOKEN_NONE if absent
+typedef uint32_t ExtraIndex;    // start of a list in Ast.extra, paired with a _len field
+
+#define NODE_NONE 0
+#define TOKEN_NONE UINT32_MAX
+
 typedef struct {
-    Node **decls;
+    ExtraIndex decls;
     uint32_t decls_len;
-    Node **fields;
+    ExtraIndex fields;
     uint32_t fields_len;
 } NodeDataContainerMembers;
 
 typedef struct {
-    Buffer name;
-    Node *type_expr;
-    Node *bytealign;
-    Node *expr;
+    TokenIndex name;
+    NodeIndex type_expr;
+    NodeIndex bytealign;
+    NodeIndex expr;
     bool is_comptime;
 } NodeDataContainerField;
 
 typedef struct {
-    Buffer name;
-    Node *block;
+    TokenIndex name;
+    NodeIndex block;
     bool is_ident;
 } NodeDataTestDecl;
 
 typedef struct {
-    Node *block;
+    NodeIndex block;
 } NodeDataComptimeDecl;
 
 typedef struct {
-    Buffer name;
-    Node *type;
-    Node *bytealign;
-    Node *addrspace;
-    Node *linksection;
+    TokenIndex name;
+    NodeIndex type;
+    NodeIndex bytealign;
+    NodeIndex addrspace;
+    NodeIndex linksection;
     bool is_const;
 } NodeDataVarDeclProto;
 
 typedef struct {
-    Node *var_decl_proto;
-    Node *expr;
+    NodeIndex var_decl_proto;
+    NodeIndex expr;
 } NodeDataGlobalVarDecl;
 
 typedef enum {
@@ -57,76 +62,81 @@ typedef enum {
 } DeclModifiers;
 
 typedef struct {
-    Node *fn_proto;
-    Node *block;
+    NodeIndex fn_proto;
+    NodeIndex block;
     DeclModifiers modifiers;
-    Buffer extern_name;
+    TokenIndex extern_name;
 } NodeDataDeclFn;
 
 typedef struct {
-    Node *global_var_decl;
+    NodeIndex global_var_decl;
     DeclModifiers modifiers;
-    Buffer extern_name;
+    TokenIndex extern_name;
 } NodeDataDeclGlobalVarDecl;
 
 typedef struct {
-    Node **statements;
+    ExtraIndex statements;
     uint32_t statements_len;
 } NodeDataBlock;
 
 typedef struct {
-    Buffer name;
-    Node *params;
-    Node *return_type;
-    Node *extra_data;
+    TokenIndex l_brace;
+    TokenIndex r_brace;
+} NodeDataLazyBlock;
+
+typedef struct {
+    TokenIndex name;
+    NodeIndex params;
+    NodeIndex return_type;
+    NodeIndex extra_data;
     bool is_return_type_error;
 } NodeDataFnProto;
 
 typedef struct {
-    Node *bytealign;
-    Node *addrspace;
-    Node *linksection;
-    Node *callconv;
+    NodeIndex bytealign;
+    NodeIndex addrspace;
+    NodeIndex linksection;
+    NodeIndex callconv;
 } NodeDataFnProtoExtra;
 
 typedef struct {
-    Node **params;
+    ExtraIndex params;
     uint32_t params_len;
 } NodeDataParamDeclList;
 
 typedef struct {
     bool is_varargs;
     TokenTag modifier;
-    Node *type;
-    Buffer identifier;
+    NodeIndex type;
+    TokenIndex identifier;
 } NodeDataParamDecl;
 
 typedef struct {
-    Node **prefix_type_ops;
+    ExtraIndex prefix_type_ops;
     uint32_t prefix_type_ops_len;
-    Node *type_expr;
+    NodeIndex type_expr;
 } NodeDataTypeExpr;
 
 typedef struct {
-    Node *suffix_expr;
-    Node *error_type_expr;
+    NodeIndex suffix_expr;
+    NodeIndex error_type_expr;
 } NodeDataErrorUnionExpr;
 
 typedef struct {
-    Node *expr;
+    NodeIndex expr;
 } NodeDataExpr;
 
 typedef struct {
-    Node *comptime_statement;
+    NodeIndex comptime_statement;
 } NodeDataComptimeStatement;
 
 typedef struct {
-    Node *block_expr;
+    NodeIndex block_expr;
 } NodeDataBlockExprStatement;
 
 typedef struct {
-    Buffer payload_name;
-    Node *block_expr;
+    TokenIndex payload_name;
+    NodeIndex block_expr;
 } NodeDataErrdeferStatement;
 
 // Does not include assignment operators (as these have their own rules).
@@ -165,20 +175,20 @@ typedef enum BinOp {
 } BinOp;
 
 typedef struct {
-    TokenTag *ops;
+    ExtraIndex ops;
     uint32_t ops_len;
-    Node *expr;
+    NodeIndex expr;
 } NodeDataUnaryExpr;
 
 typedef struct {
     BinOp op;
-    Node *lhs;
-    Node *rhs;
+    NodeIndex lhs;
+    NodeIndex rhs;
 } NodeDataBinaryExpr;
 
 typedef struct {
-    Node *type;
-    Node *initlist;
+    NodeIndex type;
+    NodeIndex initlist;
 } NodeDataCurlySuffixExpr;
 
 typedef enum {
@@ -245,13 +255,13 @@ const char* NodePrimaryTypeTag_name(NodePrimaryTypeTag tag)
 }
 
 typedef struct {
-    Buffer name;
-    Node *args;
+    TokenIndex name;
+    NodeIndex args;
 } NodePrimaryTypeDataBuiltin;
 
 typedef union {
-    Buffer raw;
-    Node *node;
+    TokenIndex raw;
+    NodeIndex node;
     NodePrimaryTypeDataBuiltin builtin;
 } NodePrimaryTypeData;
 
@@ -261,168 +271,168 @@ typedef struct {
 } NodeDataPrimaryTypeExpr;
 
 typedef struct {
-    Node *decl;
+    NodeIndex decl;
     bool is_pub;
 } NodeDataTopLevelDecl;
 
 typedef struct {
-    Node *for_start;
-    Node *for_end;
+    NodeIndex for_start;
+    NodeIndex for_end;
     bool is_range;
 } NodeDataForItem;
 
 typedef struct {
-    Node **args;
+    ExtraIndex args;
     uint32_t args_len;
 } NodeDataForArgs;
 
 typedef struct {
-    Buffer name;
-    Node *expr;
+    TokenIndex name;
+    NodeIndex expr;
 } NodeDataFieldInit;
 
 typedef struct {
-    Node *expr;
+    NodeIndex expr;
     bool is_tagged;
 } NodeDataUnionDecl;
 
 typedef struct {
-    Node *start;
-    Node *end;
+    NodeIndex start;
+    NodeIndex end;
 } NodeDataSwitchItem;
 
 typedef struct {
-    Node **cases;
+    ExtraIndex cases;
     uint32_t cases_len;
     bool is_else;
 } NodeDataSwitchCase;
 
 typedef struct {
-    Buffer label;
-    Node *node;
+    TokenIndex label;
+    NodeIndex node;
 } NodeDataLabeledTypeExpr;
 
 typedef struct {
-    Buffer label;
-    Node *statement;
+    TokenIndex label;
+    NodeIndex statement;
 } NodeDataLabeledStatement;
 
 typedef struct {
-    Node *condition;
-    Node *block;
-    Buffer else_payload_name;
-    Node *else_statement;
+    NodeIndex condition;
+    NodeIndex block;
+    TokenIndex else_payload_name;
+    NodeIndex else_statement;
 } NodeDataWhileStatement;
 
 typedef struct {
-    Node *condition;
-    Node *block;
-    Node *else_statement;
+    NodeIndex condition;
+    NodeIndex block;
+    NodeIndex else_statement;
 } NodeDataForStatement;
 
 typedef struct {
-    Node *condition;
-    Node *block;
-    Buffer else_payload_name;
-    Node *else_statement;
+    NodeIndex condition;
+    NodeIndex block;
+    TokenIndex else_payload_name;
+    NodeIndex else_statement;
 } NodeDataIfStatement;
 
 typedef struct {
-    Node *condition;
-    Node *expr;
-    Buffer else_payload_name;
-    Node *else_payload_expr;
+    NodeIndex condition;
+    NodeIndex expr;
+    TokenIndex else_payload_name;
+    NodeIndex else_payload_expr;
 } NodeDataIfExpr;
 
 typedef struct {
-    Node *var_decl;
-    Node **var_decl_additional;
+    NodeIndex var_decl;
+    ExtraIndex var_decl_additional;
     uint32_t var_decl_additional_len;
-    Node *expr;
+    NodeIndex expr;
 } NodeDataVarDeclStatement;
 
 typedef struct {
-    Node *lhs;
+    NodeIndex lhs;
     TokenTag assign_op;
-    Node *rhs;
+    NodeIndex rhs;
 } NodeDataSingleAssignExpr;
 
 typedef struct {
-    Node *lhs;
-    Node **lhs_additional;
+    NodeIndex lhs;
+    ExtraIndex lhs_additional;
     uint32_t lhs_additional_len;
-    Node *expr;
+    NodeIndex expr;
 } NodeDataMultiAssignExpr;
 
 typedef struct {
-    Buffer label;
-    Node *loop_expr;
+    TokenIndex label;
+    NodeIndex loop_expr;
 } NodeDataLoopExpr;
 
 typedef struct {
-    Buffer label;
-    Node *expr;
+    TokenIndex label;
+    NodeIndex expr;
 } NodeDataContinueExpr;
 
 typedef struct {
-    Buffer label;
-    Node *expr;
+    TokenIndex label;
+    NodeIndex expr;
 } NodeDataBreakExpr;
 
 typedef struct {
-    Node *condition;
-    Node *expr;
-    Buffer else_payload_name;
-    Node *else_expr;
+    NodeIndex condition;
+    NodeIndex expr;
+    TokenIndex else_payload_name;
+    NodeIndex else_expr;
 } NodeDataWhileExpr;
 
 typedef struct {
-    Node *condition;
-    Node *expr;
-    Node *else_expr;
+    NodeIndex condition;
+    NodeIndex expr;
+    NodeIndex else_expr;
 } NodeDataForExpr;
 
 typedef struct {
     bool is_inline;
-    Node *statement;
+    NodeIndex statement;
 } NodeDataLoopStatement;
 
 typedef struct {
-    Node *type;
-    Node *members;
+    NodeIndex type;
+    NodeIndex members;
 } NodeDataContainerDeclAuto;
 
 typedef struct {
-    Node *byte_align;
-    Node *bit_offset;
-    Node *bit_backing_integer_size;
+    NodeIndex byte_align;
+    NodeIndex bit_offset;
+    NodeIndex bit_backing_integer_size;
 } NodeDataPtrAlignExpr;
 
 typedef struct {
-    Node *slice;
-    Node *bytealign;
-    Node *addrspace;
+    NodeIndex slice;
+    NodeIndex bytealign;
+    NodeIndex addrspace;
     tTypePointerModifiers modifiers;
 } NodeDataPrefixTypeSlice;
 
 typedef struct {
-    Node *ptr;
-    Node *addrspace;
-    Node *align;
+    NodeIndex ptr;
+    NodeIndex addrspace;
+    NodeIndex align;
     tTypePointerModifiers modifiers;
 } NodeDataPrefixTypePtr;
 
 typedef struct {
-    Node *array;
+    NodeIndex array;
 } NodeDataPrefixTypeArray;
 
 typedef struct {
-    Node *index;
-    Node *sentinel_expr;
+    NodeIndex index;
+    NodeIndex sentinel_expr;
 } NodeDataArrayTypeStart;
 
 typedef struct {
-    Node *sentinel_expr;
+    NodeIndex sentinel_expr;
 } NodeDataSliceTypeStart;
 
 typedef enum {
@@ -435,157 +445,157 @@ typedef enum {
 
 typedef struct {
     NodePtrType type;
-    Node *sentinel_expr;
+    NodeIndex sentinel_expr;
 } NodeDataPtrTypeStart;
 
 typedef struct {
-    Node *start_expr;
-    Node *end_expr;
-    Node *sentinel_expr;
+    NodeIndex start_expr;
+    NodeIndex end_expr;
+    NodeIndex sentinel_expr;
 } NodeDataSuffixTypeOpSlice;
 
 typedef struct {
-    Buffer name;
+    TokenIndex name;
 } NodeDataSuffixTypeOpNamedAccess;
 
 typedef struct {
-    Node **exprs;
+    ExtraIndex exprs;
     uint32_t exprs_len;
 } NodeDataFnCallArguments;
 
 typedef struct {
-    Node *expr;
-    Node **suffixes;
+    NodeIndex expr;
+    ExtraIndex suffixes;
     uint32_t suffixes_len;
 } NodeDataSuffixExpr;
 
 typedef struct {
-    Node *for_args;
-    Node *ptr_list_payload;
+    NodeIndex for_args;
+    NodeIndex ptr_list_payload;
 } NodeDataForPrefix;
 
 typedef struct {
-    Node *condition;
-    Node *ptr_payload;
-    Node *while_continue_expr;
+    NodeIndex condition;
+    NodeIndex ptr_payload;
+    NodeIndex while_continue_expr;
 } NodeDataWhilePrefix;
 
 typedef struct {
-    Node *condition;
-    Node *ptr_payload;
+    NodeIndex condition;
+    NodeIndex ptr_payload;
 } NodeDataIfPrefix;
 
 typedef struct {
-    Buffer name;
+    TokenIndex name;
     bool is_pointer;
 } NodeDataPayload;
 
 typedef struct {
-    Buffer name;
+    TokenIndex name;
     bool is_pointer;
-    Buffer name_index;
+    TokenIndex name_index;
 } NodeDataPayloadIndex;
 
 typedef struct {
-    Node **payloads;
+    ExtraIndex payloads;
     uint32_t payloads_len;
 } NodeDataPayloadList;
 
 typedef struct {
     bool is_inline;
-    Node *switch_case;
-    Node *payload;
-    Node *expr;
+    NodeIndex switch_case;
+    NodeIndex payload;
+    NodeIndex expr;
 } NodeDataSwitchProng;
 
 typedef struct {
-    Node **prongs;
+    ExtraIndex prongs;
     uint32_t prongs_len;
 } NodeDataSwitchProngList;
 
 typedef struct {
-    Node *for_prefix;
-    Node *condition;
-    Node *expr;
-    Node *else_expr;
+    NodeIndex for_prefix;
+    NodeIndex condition;
+    NodeIndex expr;
+    NodeIndex else_expr;
 } NodeDataForTypeExpr;
 
 typedef struct {
     bool is_extern;
     bool is_packed;
-    Node *container_decl;
+    NodeIndex container_decl;
 } NodeDataContainerDecl;
 
 typedef struct {
-    Node *if_prefix;
-    Node *type_expr;
-    Buffer else_payload_name;
-    Node *else_payload_type_expr;
+    NodeIndex if_prefix;
+    NodeIndex type_expr;
+    TokenIndex else_payload_name;
+    NodeIndex else_payload_type_expr;
 } NodeDataIfTypeExpr;
 
 typedef struct {
-    Node *while_prefix;
-    Node *type_expr;
-    Buffer else_payload_name;
-    Node *else_payload_type_expr;
+    NodeIndex while_prefix;
+    NodeIndex type_expr;
+    TokenIndex else_payload_name;
+    NodeIndex else_payload_type_expr;
 } NodeDataWhileTypeExpr;
 
 typedef struct {
-    Buffer *idents;
+    ExtraIndex idents;
     uint32_t idents_len;
 } NodeDataIdentifierList;
 
 typedef struct {
-    Node *expr;
-    Node *switch_prong_list;
+    NodeIndex expr;
+    NodeIndex switch_prong_list;
 } NodeDataSwitchExpr;
 
 typedef struct {
-    Node **nodes;
+    ExtraIndex nodes;
     uint32_t nodes_len;
 } NodeDataInitList;
 
 typedef struct {
-    Node **asm_inputs;
+    ExtraIndex asm_inputs;
     uint32_t asm_inputs_len;
 } NodeDataAsmInputList;
 
 typedef struct {
-    Buffer name;
-    Buffer lit;
-    Node *input_expr;
+    TokenIndex name;
+    TokenIndex lit;
+    NodeIndex input_expr;
 } NodeDataAsmInputItem;
 
 typedef struct {
-    Node **asm_outputs;
+    ExtraIndex asm_outputs;
     uint32_t asm_outputs_len;
 } NodeDataAsmOutputList;
 
 typedef struct {
-    Buffer name;
-    Buffer lit;
-    Node *output_expr;
+    TokenIndex name;
+    TokenIndex lit;
+    NodeIndex output_expr;
 } NodeDataAsmOutputItem;
 
 typedef struct {
-    Node *asm_output_list;
-    Node *asm_input;
+    NodeIndex asm_output_list;
+    NodeIndex asm_input;
 } NodeDataAsmOutput;
 
 typedef struct {
-    Node *asm_input_list;
-    Node *clobbers;
+    NodeIndex asm_input_list;
+    NodeIndex clobbers;
 } NodeDataAsmInput;
 
 typedef struct {
     bool is_volatile;
-    Node *expr;
-    Node *asm_output;
+    NodeIndex expr;
+    NodeIndex asm_output;
 } NodeDataAsmExpr;
 
 typedef struct {
-    Node *type;
-    Buffer name;
+    NodeIndex type;
+    TokenIndex name;
     bool is_type;
 } NodeDataTypeOrName;
 
@@ -599,6 +609,7 @@ typedef union NodeData {
     NodeDataDeclFn decl_fn;
     NodeDataDeclGlobalVarDecl decl_global_var_decl;
     NodeDataBlock block;
+    NodeDataLazyBlock lazy_block;
     NodeDataFnProto fn_proto;
     NodeDataFnProtoExtra fn_proto_extra;
     NodeDataParamDeclList param_decl_list;
@@ -613,18 +624,18 @@ typedef union NodeData {
     NodeDataErrdeferStatement errdefer_statement;
     NodeDataUnaryExpr unary_expr;
     NodeDataBinaryExpr binary_expr;
-    Node* comptime_expr;
-    Node* nosuspend_expr;
-    Node* resume_expr;
-    Node* return_expr;
+    NodeIndex comptime_expr;
+    NodeIndex nosuspend_expr;
+    NodeIndex resume_expr;
+    NodeIndex return_expr;
     NodeDataCurlySuffixExpr curly_suffix_expr;
     NodeDataPrimaryTypeExpr primary_type_expr;
     NodeDataTopLevelDecl top_level_decl;
     NodeDataForItem for_item;
     NodeDataForArgs for_args;
     NodeDataFieldInit field_init;
-    Node* struct_decl;
-    Node* enum_decl;
+    NodeIndex struct_decl;
+    NodeIndex enum_decl;
     NodeDataUnionDecl union_decl;
     NodeDataSwitchItem switch_item;
     NodeDataSwitchCase switch_case;
@@ -690,6 +701,7 @@ typedef enum NodeTag {
     node_decl_fn,
     node_decl_global_var_decl,
     node_block,
+    node_lazy_block,
     node_fn_proto,
     node_fn_proto_extra,
     node_param_decl_list,
@@ -802,6 +814,8 @@ static const char* NodeTag_name(NodeTag tag)
             return "node_decl_global_var_decl";
         case node_block:
             return "node_block";
+        case node_lazy_block:
+            return "node_lazy_block";
         case node_fn_proto:
             return "node_fn_proto";
         case node_fn_proto_extra:
@@ -986,31 +1000,658 @@ struct Node {
     NodeData data;
 };
 
-DEFINE_ARRAY_NAMED(Node*, Node)
-DEFINE_ARRAY(TokenTag)
-DEFINE_ARRAY(Buffer)
+DEFINE_ARRAY(Node)
+DEFINE_ARRAY_NAMED(uint32_t, Index)
+
+// Which 32-bit words of a node's data hold a node index, and which start a list in Ast.extra (the
+// following word is its length). node_lists is the subset of lists whose elements are nodes.
+// This is what moving nodes between Asts needs to rewrite, token indices are left as-is.
+typedef struct NodeLayout {
+    uint8_t nodes;
+    uint8_t lists;
+    uint8_t node_lists;
+} NodeLayout;
+
+#define NODE_WORD(Type, field) (1u << (offsetof(Type, field) / sizeof(uint32_t)))
+
+static const NodeLayout node_layouts[node_invalid + 1] = {
+    [node_container_members] = {
+        .lists = NODE_WORD(NodeDataContainerMembers, decls) | NODE_WORD(NodeDataContainerMembers, fields),
+        .node_lists = NODE_WORD(NodeDataContainerMembers, decls) | NODE_WORD(NodeDataContainerMembers, fields),
+    },
+    [node_container_field] = {
+        .nodes = NODE_WORD(NodeDataContainerField, type_expr) | NODE_WORD(NodeDataContainerField, bytealign)
+            | NODE_WORD(NodeDataContainerField, expr),
+    },
+    [node_test_decl] = { .nodes = NODE_WORD(NodeDataTestDecl, block) },
+    [node_comptime_decl] = { .nodes = NODE_WORD(NodeDataComptimeDecl, block) },
+    [node_var_decl_proto] = {
+        .nodes = NODE_WORD(NodeDataVarDeclProto, type) | NODE_WORD(NodeDataVarDeclProto, bytealign)
+            | NODE_WORD(NodeDataVarDeclProto, addrspace) | NODE_WORD(NodeDataVarDeclProto, linksection),
+    },
+    [node_global_var_decl] = {
+        .nodes = NODE_WORD(NodeDataGlobalVarDecl, var_decl_proto) | NODE_WORD(NodeDataGlobalVarDecl, expr),
+    },
+    [node_decl_fn] = { .nodes = NODE_WORD(NodeDataDeclFn, fn_proto) | NODE_WORD(NodeDataDeclFn, block) },
+    [node_decl_global_var_decl] = { .nodes = NODE_WORD(NodeDataDeclGlobalVarDecl, global_var_decl) },
+    [node_block] = {
+        .lists = NODE_WORD(NodeDataBlock, statements),
+        .node_lists = NODE_WORD(NodeDataBlock, statements),
+    },
+    [node_fn_proto] = {
+        .nodes = NODE_WORD(NodeDataFnProto, params) | NODE_WORD(NodeDataFnProto, return_type)
+            | NODE_WORD(NodeDataFnProto, extra_data),
+    },
+    [node_fn_proto_extra] = {
+        .nodes = NODE_WORD(NodeDataFnProtoExtra, bytealign) | NODE_WORD(NodeDataFnProtoExtra, addrspace)
+            | NODE_WORD(NodeDataFnProtoExtra, linksection) | NODE_WORD(NodeDataFnProtoExtra, callconv),
+    },
+    [node_param_decl_list] = {
+        .lists = NODE_WORD(NodeDataParamDeclList, params),
+        .node_lists = NODE_WORD(NodeDataParamDeclList, params),
+    },
+    [node_param_decl] = { .nodes = NODE_WORD(NodeDataParamDecl, type) },
+    [node_type_expr] = {
+        .nodes = NODE_WORD(NodeDataTypeExpr, type_expr),
+        .lists = NODE_WORD(NodeDataTypeExpr, prefix_type_ops),
+        .node_lists = NODE_WORD(NodeDataTypeExpr, prefix_type_ops),
+    },
+    [node_error_union_expr] = {
+        .nodes = NODE_WORD(NodeDataErrorUnionExpr, suffix_expr)
+            | NODE_WORD(NodeDataErrorUnionExpr, error_type_expr),
+    },
+    [node_suffix_expr] = {
+        .nodes = NODE_WORD(NodeDataSuffixExpr, expr),
+        .lists = NODE_WORD(NodeDataSuffixExpr, suffixes),
+        .node_lists = NODE_WORD(NodeDataSuffixExpr, suffixes),
+    },
+    [node_comptime_statement] = { .nodes = NODE_WORD(NodeDataComptimeStatement, comptime_statement) },
+    [node_nosuspend_statement] = { .nodes = NODE_WORD(NodeDataBlockExprStatement, block_expr) },
+    [node_suspend_statement] = { .nodes = NODE_WORD(NodeDataBlockExprStatement, block_expr) },
+    [node_defer_statement] = { .nodes = NODE_WORD(NodeDataBlockExprStatement, block_expr) },
+    [node_errdefer_statement] = { .nodes = NODE_WORD(NodeDataErrdeferStatement, block_expr) },
+    [node_unary_expr] = {
+        .nodes = NODE_WORD(NodeDataUnaryExpr, expr),
+        .lists = NODE_WORD(NodeDataUnaryExpr, ops),
+    },
+    [node_binary_expr] = { .nodes = NODE_WORD(NodeDataBinaryExpr, lhs) | NODE_WORD(NodeDataBinaryExpr, rhs) },
+    [node_comptime_expr] = { .nodes = 1 },
+    [node_nosuspend_expr] = { .nodes = 1 },
+    [node_resume_expr] = { .nodes = 1 },
+    [node_return_expr] = { .nodes = 1 },
+    [node_curly_suffix_expr] = {
+        .nodes = NODE_WORD(NodeDataCurlySuffixExpr, type) | NODE_WORD(NodeDataCurlySuffixExpr, initlist),
+    },
+    [node_top_level_decl] = { .nodes = NODE_WORD(NodeDataTopLevelDecl, decl) },
+    [node_for_item] = {
+        .nodes = NODE_WORD(NodeDataForItem, for_start) | NODE_WORD(NodeDataForItem, for_end),
+    },
+    [node_for_args] = {
+        .lists = NODE_WORD(NodeDataForArgs, args),
+        .node_lists = NODE_WORD(NodeDataForArgs, args),
+    },
+    [node_field_init] = { .nodes = NODE_WORD(NodeDataFieldInit, expr) },
+    [node_struct_decl] = { .nodes = 1 },
+    [node_enum_decl] = { .nodes = 1 },
+    [node_union_decl] = { .nodes = NODE_WORD(NodeDataUnionDecl, expr) },
+    [node_switch_item] = {
+        .nodes = NODE_WORD(NodeDataSwitchItem, start) | NODE_WORD(NodeDataSwitchItem, end),
+    },
+    [node_switch_case] = {
+        .lists = NODE_WORD(NodeDataSwitchCase, cases),
+        .node_lists = NODE_WORD(NodeDataSwitchCase, cases),
+    },
+    [node_labeled_block] = { .nodes = NODE_WORD(NodeDataLabeledTypeExpr, node) },
+    [node_labeled_loop_expr] = { .nodes = NODE_WORD(NodeDataLabeledTypeExpr, node) },
+    [node_labeled_switch_expr] = { .nodes = NODE_WORD(NodeDataLabeledTypeExpr, node) },
+    [node_while_statement] = {
+        .nodes = NODE_WORD(NodeDataWhileStatement, condition) | NODE_WORD(NodeDataWhileStatement, block)
+            | NODE_WORD(NodeDataWhileStatement, else_statement),
+    },
+    [node_for_statement] = {
+        .nodes = NODE_WORD(NodeDataForStatement, condition) | NODE_WORD(NodeDataForStatement, block)
+            | NODE_WORD(NodeDataForStatement, else_statement),
+    },
+    [node_if_statement] = {
+        .nodes = NODE_WORD(NodeDataIfStatement, condition) | NODE_WORD(NodeDataIfStatement, block)
+            | NODE_WORD(NodeDataIfStatement, else_statement),
+    },
+    [node_labeled_statement] = { .nodes = NODE_WORD(NodeDataLabeledStatement, statement) },
+    [node_if_expr] = {
+        .nodes = NODE_WORD(NodeDataIfExpr, condition) | NODE_WORD(NodeDataIfExpr, expr)
+            | NODE_WORD(NodeDataIfExpr, else_payload_expr),
+    },
+    [node_var_decl_statement] = {
+        .nodes = NODE_WORD(NodeDataVarDeclStatement, var_decl) | NODE_WORD(NodeDataVarDeclStatement, expr),
+        .lists = NODE_WORD(NodeDataVarDeclStatement, var_decl_additional),
+        .node_lists = NODE_WORD(NodeDataVarDeclStatement, var_decl_additional),
+    },
+    [node_single_assign_expr] = {
+        .nodes = NODE_WORD(NodeDataSingleAssignExpr, lhs) | NODE_WORD(NodeDataSingleAssignExpr, rhs),
+    },
+    [node_multi_assign_expr] = {
+        .nodes = NODE_WORD(NodeDataMultiAssignExpr, lhs) | NODE_WORD(NodeDataMultiAssignExpr, expr),
+        .lists = NODE_WORD(NodeDataMultiAssignExpr, lhs_additional),
+        .node_lists = NODE_WORD(NodeDataMultiAssignExpr, lhs_additional),
+    },
+    [node_loop_expr] = { .nodes = NODE_WORD(NodeDataLoopExpr, loop_expr) },
+    [node_continue_expr] = { .nodes = NODE_WORD(NodeDataContinueExpr, expr) },
+    [node_break_expr] = { .nodes = NODE_WORD(NodeDataBreakExpr, expr) },
+    [node_while_expr] = {
+        .nodes = NODE_WORD(NodeDataWhileExpr, condition) | NODE_WORD(NodeDataWhileExpr, expr)
+            | NODE_WORD(NodeDataWhileExpr, else_expr),
+    },
+    [node_for_expr] = {
+        .nodes = NODE_WORD(NodeDataForExpr, condition) | NODE_WORD(NodeDataForExpr, expr)
+            | NODE_WORD(NodeDataForExpr, else_expr),
+    },
+    [node_loop_statement] = { .nodes = NODE_WORD(NodeDataLoopStatement, statement) },
+    [node_container_decl_auto] = {
+        .nodes = NODE_WORD(NodeDataContainerDeclAuto, type) | NODE_WORD(NodeDataContainerDeclAuto, members),
+    },
+    [node_prefix_type_op_slice] = {
+        .nodes = NODE_WORD(NodeDataPrefixTypeSlice, slice) | NODE_WORD(NodeDataPrefixTypeSlice, bytealign)
+            | NODE_WORD(NodeDataPrefixTypeSlice, addrspace),
+    },
+    [node_prefix_type_op_ptr] = {
+        .nodes = NODE_WORD(NodeDataPrefixTypePtr, ptr) | NODE_WORD(NodeDataPrefixTypePtr, addrspace)
+            | NODE_WORD(NodeDataPrefixTypePtr, align),
+    },
+    [node_prefix_type_op_array] = { .nodes = NODE_WORD(NodeDataPrefixTypeArray, array) },
+    [node_ptr_align_expr] = {
+        .nodes = NODE_WORD(NodeDataPtrAlignExpr, byte_align) | NODE_WORD(NodeDataPtrAlignExpr, bit_offset)
+            | NODE_WORD(NodeDataPtrAlignExpr, bit_backing_integer_size),
+    },
+    [node_array_type_start] = {
+        .nodes = NODE_WORD(NodeDataArrayTypeStart, index) | NODE_WORD(NodeDataArrayTypeStart, sentinel_expr),
+    },
+    [node_ptr_type_start] = { .nodes = NODE_WORD(NodeDataPtrTypeStart, sentinel_expr) },
+    [node_slice_type_start] = { .nodes = NODE_WORD(NodeDataSliceTypeStart, sentinel_expr) },
+    [node_suffix_type_op_slice] = {
+        .nodes = NODE_WORD(NodeDataSuffixTypeOpSlice, start_expr)
+            | NODE_WORD(NodeDataSuffixTypeOpSlice, end_expr)
+            | NODE_WORD(NodeDataSuffixTypeOpSlice, sentinel_expr),
+    },
+    [node_fn_call_arguments] = {
+        .lists = NODE_WORD(NodeDataFnCallArguments, exprs),
+        .node_lists = NODE_WORD(NodeDataFnCallArguments, exprs),
+    },
+    [node_for_prefix] = {
+        .nodes = NODE_WORD(NodeDataForPrefix, for_args) | NODE_WORD(NodeDataForPrefix, ptr_list_payload),
+    },
+    [node_while_prefix] = {
+        .nodes = NODE_WORD(NodeDataWhilePrefix, condition) | NODE_WORD(NodeDataWhilePrefix, ptr_payload)
+            | NODE_WORD(NodeDataWhilePrefix, while_continue_expr),
+    },
+    [node_if_prefix] = {
+        .nodes = NODE_WORD(NodeDataIfPrefix, condition) | NODE_WORD(NodeDataIfPrefix, ptr_payload),
+    },
+    [node_payload_list] = {
+        .lists = NODE_WORD(NodeDataPayloadList, payloads),
+        .node_lists = NODE_WORD(NodeDataPayloadList, payloads),
+    },
+    [node_switch_prong] = {
+        .nodes = NODE_WORD(NodeDataSwitchProng, switch_case) | NODE_WORD(NodeDataSwitchProng, payload)
+            | NODE_WORD(NodeDataSwitchProng, expr),
+    },
+    [node_for_type_expr] = {
+        .nodes = NODE_WORD(NodeDataForTypeExpr, for_prefix) | NODE_WORD(NodeDataForTypeExpr, condition)
+            | NODE_WORD(NodeDataForTypeExpr, expr) | NODE_WORD(NodeDataForTypeExpr, else_expr),
+    },
+    [node_switch_prong_list] = {
+        .lists = NODE_WORD(NodeDataSwitchProngList, prongs),
+        .node_lists = NODE_WORD(NodeDataSwitchProngList, prongs),
+    },
+    [node_container_decl] = { .nodes = NODE_WORD(NodeDataContainerDecl, container_decl) },
+    [node_if_type_expr] = {
+        .nodes = NODE_WORD(NodeDataIfTypeExpr, if_prefix) | NODE_WORD(NodeDataIfTypeExpr, type_expr)
+            | NODE_WORD(NodeDataIfTypeExpr, else_payload_type_expr),
+    },
+    [node_while_type_expr] = {
+        .nodes = NODE_WORD(NodeDataWhileTypeExpr, while_prefix) | NODE_WORD(NodeDataWhileTypeExpr, type_expr)
+            | NODE_WORD(NodeDataWhileTypeExpr, else_payload_type_expr),
+    },
+    [node_identifier_list] = { .lists = NODE_WORD(NodeDataIdentifierList, idents) },
+    [node_switch_expr] = {
+        .nodes = NODE_WORD(NodeDataSwitchExpr, expr) | NODE_WORD(NodeDataSwitchExpr, switch_prong_list),
+    },
+    [node_init_list_field] = {
+        .lists = NODE_WORD(NodeDataInitList, nodes),
+        .node_lists = NODE_WORD(NodeDataInitList, nodes),
+    },
+    [node_init_list_expr] = {
+        .lists = NODE_WORD(NodeDataInitList, nodes),
+        .node_lists = NODE_WORD(NodeDataInitList, nodes),
+    },
+    [node_asm_input_list] = {
+        .lists = NODE_WORD(NodeDataAsmInputList, asm_inputs),
+        .node_lists = NODE_WORD(NodeDataAsmInputList, asm_inputs),
+    },
+    [node_asm_output_list] = {
+        .lists = NODE_WORD(NodeDataAsmOutputList, asm_outputs),
+        .node_lists = NODE_WORD(NodeDataAsmOutputList, asm_outputs),
+    },
+    [node_asm_input_item] = { .nodes = NODE_WORD(NodeDataAsmInputItem, input_expr) },
+    [node_asm_output_item] = { .nodes = NODE_WORD(NodeDataAsmOutputItem, output_expr) },
+    [node_asm_input] = {
+        .nodes = NODE_WORD(NodeDataAsmInput, asm_input_list) | NODE_WORD(NodeDataAsmInput, clobbers),
+    },
+    [node_asm_output] = {
+        .nodes = NODE_WORD(NodeDataAsmOutput, asm_output_list) | NODE_WORD(NodeDataAsmOutput, asm_input),
+    },
+    [node_asm_expr] = { .nodes = NODE_WORD(NodeDataAsmExpr, expr) | NODE_WORD(NodeDataAsmExpr, asm_output) },
+    [node_type_or_name] = { .nodes = NODE_WORD(NodeDataTypeOrName, type) },
+};
+
+static NodeLayout Node_layout(const Node *n)
+{
+    if (n->tag != node_primary_type_expr) return node_layouts[n->tag];
+
+    switch (n->data.primary_type_expr.tag) {
+        case node_primary_type_builtin:
+            return (NodeLayout){ .nodes = NODE_WORD(NodeDataPrimaryTypeExpr, data.builtin.args) };
+
+        case node_primary_type_container_decl:
+        case node_primary_type_dot_initlist:
+        case node_primary_type_error_set_decl:
+        case node_primary_type_fn_proto:
+        case node_primary_type_grouped_expr:
+        case node_primary_type_labeled_type_expr:
+        case node_primary_type_if_type_expr:
+        case node_primary_type_comptime_type_expr:
+            return (NodeLayout){ .nodes = NODE_WORD(NodeDataPrimaryTypeExpr, data.node) };
+
+        default:
+            return (NodeLayout){ 0 };
+    }
+}
+
+#undef NODE_WORD
+
+// Ast is the parser output. All nodes live in one array and reference each other, the tokens
+// and variable-length lists (stored in extra) by index, so the tree can be relocated as-is.
+typedef struct Ast {
+    Buffer source;
+    const uint32_t *token_starts;
+    NodeArray nodes;            // nodes[NODE_NONE] is reserved
+    IndexArray extra;
+    NodeIndex root;
+} Ast;
+
+static Node* Ast_node(const Ast *ast, NodeIndex n)
+{
+    assume(n != NODE_NONE && n < ast->nodes.len);
+    return &ast->nodes.data[n];
+}
+
+static const uint32_t* Ast_list(const Ast *ast, ExtraIndex list)
+{
+    return &ast->extra.data[list];
+}
+
+static void Ast_init(Ast *ast, Buffer source)
+{
+    ast->source = source;
+    ast->token_starts = NULL;   // set once parsing is done and the token list is final
+    NodeArray_init(&ast->nodes);
+    NodeArray_append(&ast->nodes, (Node){ .tag = node_invalid });
+    IndexArray_init(&ast->extra);
+    ast->root = NODE_NONE;
+}
+
+// Append the nodes and lists of src to dst, rewriting their indices for the new positions. The
+// node indices in roots (which refer into src) are rewritten in place.
+static void Ast_append(Ast *dst, const Ast *src, uint32_t *roots, uint32_t roots_len)
+{
+    uint32_t node_base = dst->nodes.len - 1;    // src node 0 is reserved and not copied
+    uint32_t extra_base = dst->extra.len;
+    uint32_t first = dst->nodes.len;
+    NodeArray_appendMany(&dst->nodes, src->nodes.data + 1, src->nodes.len - 1);
+    IndexArray_appendMany(&dst->extra, src->extra.data, src->extra.len);
+
+    for (uint32_t i = first; i < dst->nodes.len; i++) {
+        Node *n = &dst->nodes.data[i];
+        NodeLayout l = Node_layout(n);
+        union {
+            NodeData data;
+            uint32_t words[sizeof(NodeData) / sizeof(uint32_t)];
+        } d = { .data = n->data };
+        uint32_t *w = d.words;
+        for (uint32_t j = 0; j < sizeof(d.words) / sizeof(d.words[0]); j++) {
+            uint32_t bit = 1u << j;
+            if ((l.nodes & bit) && w[j] != NODE_NONE) w[j] += node_base;
+            if (l.lists & bit) {
+                w[j] += extra_base;
+                if (l.node_lists & bit) {
+                    for (uint32_t k = 0; k < w[j + 1]; k++) dst->extra.data[w[j] + k] += node_base;
+                }
+            }
+        }
+        n->data = d.data;
+    }
+
+    for (uint32_t i = 0; i < roots_len; i++) roots[i] += node_base;
+}
+
+static Buffer Ast_tokenSlice(const Ast *ast, TokenIndex t)
+{
+    if (t == TOKEN_NONE) return Buffer_empty();
+    uint32_t start = ast->token_starts[t];
+    return Buffer_slice(ast->source, start, Tokenizer_tokenEnd(ast->source, start));
+}
+
+// Rules whose results are memoized with -memo, see Parser_memoGet.
+typedef enum ParserRule {
+    parser_rule_expr,
+    parser_rule_type_expr,
+    parser_rule_primary_type_expr,
+    parser_rule_prefix_type_op,
+    parser_rule_suffix_op,
+    parser_rule_statement,
+    parser_rule_count,
+} ParserRule;
+
+static const char *parser_rule_names[parser_rule_count] = {
+    [parser_rule_expr] = "Expr",
+    [parser_rule_type_expr] = "TypeExpr",
+    [parser_rule_primary_type_expr] = "PrimaryTypeExpr",
+    [parser_rule_prefix_type_op] = "PrefixTypeOp",
+    [parser_rule_suffix_op] = "SuffixOp",
+    [parser_rule_statement] = "Statement",
+};
+
+typedef struct ParserMemoEntry {
+    uint32_t index;     // token the rule started at, UINT32_MAX if the slot is empty
+    uint32_t end;       // token after the match
+    NodeIndex node;     // NODE_NONE if the rule failed
+    uint8_t rule;       // ParserRule
+} ParserMemoEntry;
+
+// Packrat memo table keyed by (rule, token index), open addressing with linear probing.
+typedef struct ParserMemo {
+    ParserMemoEntry *entries;
+    uint32_t len;
+    uint32_t cap;       // power of two
+    uint32_t hits[parser_rule_count];
+    uint32_t misses[parser_rule_count];
+} ParserMemo;
+
+static ParserMemo* ParserMemo_create(void)
+{
+    ParserMemo *m = std_malloc(sizeof(ParserMemo));
+    if (!m) std_panic("oom");
+    *m = (ParserMemo){ .cap = 1024 };
+    m->entries = std_malloc(sizeof(ParserMemoEntry) * m->cap);
+    if (!m->entries) std_panic("oom");
+    for (uint32_t i = 0; i < m->cap; i++) m->entries[i].index = UINT32_MAX;
+    return m;
+}
+
+static void ParserMemo_destroy(ParserMemo *m)
+{
+    std_free(m->entries);
+    std_free(m);
+}
+
+static ParserMemoEntry* ParserMemo_slot(ParserMemo *m, ParserRule rule, uint32_t index)
+{
+    uint32_t h = (index * parser_rule_count + rule) * 2654435761u;
+    for (uint32_t i = h & (m->cap - 1);; i = (i + 1) & (m->cap - 1)) {
+        ParserMemoEntry *e = &m->entries[i];
+        if (e->index == UINT32_MAX || (e->index == index && e->rule == rule)) return e;
+    }
+}
+
+static void ParserMemo_put(ParserMemo *m, ParserMemoEntry entry)
+{
+    if (2 * (m->len + 1) > m->cap) {
+        ParserMemoEntry *old = m->entries;
+        uint32_t old_cap = m->cap;
+        m->cap *= 2;
+        m->entries = std_malloc(sizeof(ParserMemoEntry) * m->cap);
+        if (!m->entries) std_panic("oom");
+        for (uint32_t i = 0; i < m->cap; i++) m->entries[i].index = UINT32_MAX;
+        for (uint32_t i = 0; i < old_cap; i++) {
+            if (old[i].index != UINT32_MAX) *ParserMemo_slot(m, old[i].rule, old[i].index) = old[i];
+        }
+        std_free(old);
+    }
+    ParserMemoEntry *e = ParserMemo_slot(m, entry.rule, entry.index);
+    if (e->index == UINT32_MAX) m->len++;
+    *e = entry;
+}
+
+// Per-rule counters for -parse-profile, keyed by the __func__ of the Parser_parse* function.
+#define PARSER_PROFILE_SLOTS 256    // power of two, larger than the number of rules
+
+typedef struct ParserProfileRule {
+    const char *name;           // NULL if the slot is empty
+    uint64_t calls;
+    uint64_t matches;           // calls that returned having consumed tokens
+    uint64_t rollbacks;         // Parser_reset calls that moved the token index back
+    uint64_t tokens;            // tokens consumed, including by nested rules
+    uint64_t cycles;            // including nested rules, counted once for recursive calls
+    uint64_t self_cycles;
+    uint32_t depth;             // active calls of this rule
+} ParserProfileRule;
+
+typedef struct ParserProfile {
+    ParserProfileRule rules[PARSER_PROFILE_SLOTS];
+} ParserProfile;
+
+// Lives on the stack of the rule it measures, see Parser_trace.
+typedef struct ParserProfileFrame {
+    struct Parser *p;
+    ParserProfileRule *rule;    // NULL when not profiling
+    struct ParserProfileFrame *parent;
+    uint32_t start;
+    uint64_t cycles;
+    uint64_t child_cycles;
+} ParserProfileFrame;
+
+static ParserProfile* ParserProfile_create(void)
+{
+    ParserProfile *pr = std_malloc(sizeof(ParserProfile));
+    if (!pr) std_panic("oom");
+    *pr = (ParserProfile){0};
+    return pr;
+}
+
+static ParserProfileRule* ParserProfile_rule(ParserProfile *pr, const char *name)
+{
+    uint32_t h = (uint32_t)((uintptr_t)name >> 3) * 2654435761u;
+    for (uint32_t i = h & (PARSER_PROFILE_SLOTS - 1);; i = (i + 1) & (PARSER_PROFILE_SLOTS - 1)) {
+        ParserProfileRule *r = &pr->rules[i];
+        if (r->name == name) return r;
+        if (!r->name) {
+            r->name = name;
+            return r;
+        }
+    }
+}
+
+// Add the counters of src, e.g. from a parser worker, to dst.
+static void ParserProfile_merge(ParserProfile *dst, const ParserProfile *src)
+{
+    for (uint32_t i = 0; i < PARSER_PROFILE_SLOTS; i++) {
+        const ParserProfileRule *s = &src->rules[i];
+        if (!s->name) continue;
+        ParserProfileRule *d = ParserProfile_rule(dst, s->name);
+        d->calls += s->calls;
+        d->matches += s->matches;
+        d->rollbacks += s->rollbacks;
+        d->tokens += s->tokens;
+        d->cycles += s->cycles;
+        d->self_cycles += s->self_cycles;
+    }
+}
+
+// Print the rules that were called, most self cycles first.
+static void ParserProfile_print(ParserProfile *pr)
+{
+    ParserProfileRule *sorted[PARSER_PROFILE_SLOTS];
+    uint32_t len = 0;
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < PARSER_PROFILE_SLOTS; i++) {
+        ParserProfileRule *r = &pr->rules[i];
+        if (!r->name) continue;
+        uint32_t j = len++;
+        for (; j > 0 && sorted[j - 1]->self_cycles < r->self_cycles; j--) sorted[j] = sorted[j - 1];
+        sorted[j] = r;
+        total += r->self_cycles;
+    }
+
+    std_printf("%-32s %12s %12s %10s %12s %10s %10s %6s\n",
+        "rule", "calls", "matches", "rollbacks", "tokens", "Mcycles", "self", "self%");
+    for (uint32_t i = 0; i < len; i++) {
+        ParserProfileRule *r = sorted[i];
+        const char *name = r->name;
+        size_t name_len = std_strlen(name);
+        if (name_len > 7 && Buffer_eql((Buffer){ .data = (char *)name, .len = 7 }, "Parser_")) {
+            name += 7;
+            name_len -= 7;
+        }
+        if (name[name_len - 1] == '0') name_len--;     // Parser_parseExpr0 and the like
+        std_printf("%-32.*s %12llu %12llu %10llu %12llu %10.1f %10.1f %5.1f%%\n", (int)name_len, name,
+            (unsigned long long)r->calls, (unsigned long long)r->matches, (unsigned long long)r->rollbacks,
+            (unsigned long long)r->tokens, r->cycles / 1e6, r->self_cycles / 1e6,
+            total ? 100.0 * r->self_cycles / total : 0.0);
+    }
+}
 
 typedef struct Parser {
     uint32_t index;
     Buffer source;
-    Token *tokens;
+    TokenStream *stream;
+    const uint8_t *tags;        // TokenTag, view of the tokens lexed so far
+    const uint32_t *starts;
     uint32_t tokens_len;
-    uint32_t nodes_count;
+    Ast ast;
+    uint32_t nodes_discarded;   // nodes released by Parser_reset
+    uint32_t threads;           // workers for the top-level declarations
+    void **bail;                // __builtin_setjmp buffer, parse errors unwind here instead of exiting
+    bool lazy;                  // skip function bodies, see Parser_parseLazyBlock
+    uint32_t lazy_parsed;       // skipped bodies parsed on demand
+    ParserMemo *memo;           // NULL unless enabled by Parser_enableMemo
+    IndexArray scratch;         // stack of the node lists being built, see Parser_startList
+    ParserProfile *profile;     // NULL unless enabled by Parser_enableProfile
+    ParserProfileFrame *profile_frame;  // innermost rule being profiled
+    TraceBuffer *trace;         // NULL unless tracing
 } Parser;
 
-static void Parser_init(Parser *p, Ctx *ctx, Buffer source, Token *tokens, uint32_t tokens_len)
+// A rollback point. Nodes and lists added after the mark are dropped when a failed alternative resets.
+typedef struct ParserMark {
+    uint32_t index;
+    uint32_t nodes_len;
+    uint32_t extra_len;
+    uint32_t scratch_len;
+} ParserMark;
+
+static void Parser_init(Parser *p, Ctx *ctx, Buffer source, TokenStream *stream, uint32_t threads)
 {
     (void)ctx;
     p->source = source;
-    p->tokens = tokens;
-    p->tokens_len = tokens_len;
+    p->stream = stream;
+    p->tags = stream->tokens->tags;
+    p->starts = stream->tokens->starts;
+    p->tokens_len = stream->tokens->len;
     p->index = 0;
-    p->nodes_count = 0;
+    p->nodes_discarded = 0;
+    p->threads = threads;
+    p->bail = NULL;
+    // Function bodies can only be skipped when the token list tracks braces.
+    p->lazy = stream->tokens->match != NULL;
+    p->lazy_parsed = 0;
+    p->memo = NULL;
+    IndexArray_init(&p->scratch);
+    p->profile = NULL;
+    p->profile_frame = NULL;
+    p->trace = NULL;
+    Ast_init(&p->ast, source);
+}
+
+// Memoize the results of the ParserRule rules. Rolled back nodes are then kept instead of being
+// released, since a memoized result may still refer to them.
+static void Parser_enableMemo(Parser *p)
+{
+    p->memo = ParserMemo_create();
+}
+
+// Replay the memoized result of rule at the current token, if there is one.
+static bool Parser_memoGet(Parser *p, ParserRule rule, NodeIndex *result)
+{
+    if (!p->memo) return false;
+    ParserMemoEntry *e = ParserMemo_slot(p->memo, rule, p->index);
+    if (e->index == UINT32_MAX) {
+        p->memo->misses[rule]++;
+        return false;
+    }
+    p->memo->hits[rule]++;
+    p->index = e->end;
+    *result = e->node;
+    return true;
+}
+
+static NodeIndex Parser_memoPut(Parser *p, ParserRule rule, uint32_t start, NodeIndex result)
+{
+    if (p->memo) {
+        ParserMemo_put(p->memo, (ParserMemoEntry){
+            .index = start,
+            .end = p->index,
+            .node = result,
+            .rule = rule,
+        });
+    }
+    return result;
+}
+
+// Make token i available, lexing ahead as needed. The token list may have moved so the view is
+// refreshed. Once the stream is done it is only read, which parse workers sharing it rely on.
+static bool Parser_fill(Parser *p, uint32_t i)
+{
+    if (!p->stream->done) TokenStream_fill(p->stream, i);
+    const TokenList *l = p->stream->tokens;
+    p->tags = l->tags;
+    p->starts = l->starts;
+    p->tokens_len = l->len;
+    return i < p->tokens_len;
+}
+
+// Tokens past the end of the stream read as eof.
+static TokenTag Parser_tag(Parser *p, uint32_t i)
+{
+    if (i >= p->tokens_len && !Parser_fill(p, i)) return token_eof;
+    return (TokenTag)p->tags[i];
+}
+
+static uint32_t Parser_tokenStart(Parser *p, uint32_t i)
+{
+    if (i >= p->tokens_len && !Parser_fill(p, i)) return p->source.len;
+    return p->starts[i];
+}
+
+static ParserMark Parser_mark(Parser *p)
+{
+    return (ParserMark){ .index = p->index, .nodes_len = p->ast.nodes.len, .extra_len = p->ast.extra.len,
+        .scratch_len = p->scratch.len };
+}
+
+static void Parser_reset(Parser *p, ParserMark m)
+{
+    if (p->profile_frame && p->index != m.index) p->profile_frame->rule->rollbacks++;
+    p->index = m.index;
+    p->scratch.len = m.scratch_len;
+    if (p->memo) return;
+    p->nodes_discarded += p->ast.nodes.len - m.nodes_len;
+    p->ast.nodes.len = m.nodes_len;
+    p->ast.extra.len = m.extra_len;
 }
 
 #define Parser_fail(p_, ...) Parser_fail0(p_, __LINE__, "parse error: " __VA_ARGS__)
 static void _Noreturn Parser_fail0(Parser *p, int line_no, const char *fmt, ...)
 {
+    if (p->bail) __builtin_longjmp(p->bail, 1);
+
     std_printf("%d:", line_no);
 
     va_list args;
@@ -1020,15 +1661,15 @@ static void _Noreturn Parser_fail0(Parser *p, int line_no, const char *fmt, ...)
     std_printf("\n");
 
     // context
-    Token current = p->tokens[p->index];
-    const char *s = p->source.data + current.loc.start;
+    uint32_t start = Parser_tokenStart(p, p->index);
+    const char *s = p->source.data + start;
     size_t offset = 0;
     while (s != p->source.data && *s != '\n') {
         s--;
         offset++;
     }
     if (*s == '\n') s++;
-    const char *e = p->source.data + current.loc.end;
+    const char *e = p->source.data + Tokenizer_tokenEnd(p->source, start);
     while (*e != '\n' && *e != 0) e++;
     Buffer line = Buffer_slice(p->source, s - p->source.data, e - p->source.data);
     std_printf(PRIb"\n", Buffer(line));
@@ -1040,8 +1681,14 @@ static void _Noreturn Parser_fail0(Parser *p, int line_no, const char *fmt, ...)
 
 static bool Parser_peek(Parser *p, TokenTag tag)
 {
-    if (p->index >= p->tokens_len) return false;
-    return p->tokens[p->index].tag == tag;
+    return Parser_tag(p, p->index) == tag;
+}
+
+// Whether the current token can start a rule, given its FIRST set from ParserFirst.h. Only
+// conclusive for rules that are not nullable.
+static bool Parser_peekFirst(Parser *p, TokenSet first)
+{
+    return TokenSet_has(first, Parser_tag(p, p->index));
 }
 
 static bool Parser_eat(Parser *p, TokenTag tag)
@@ -1053,26 +1700,76 @@ static bool Parser_eat(Parser *p, TokenTag tag)
     return 0;
 }
 
+#define Parser_dump(p) Parser_dump0(p, __func__)
+__attribute__((unused))
+static void Parser_dump0(Parser *p, const char *function)
+{
+    uint32_t start = Parser_tokenStart(p, p->index);
+    Buffer token = Buffer_slice(p->source, start, Tokenizer_tokenEnd(p->source, start));
+    std_printf("%d:%s:%s:"PRIb"\n", p->index, function, TokenTag_name(Parser_tag(p, p->index)), Buffer(token));
+}
+
+// Every rule starts with Parser_trace. The frame it declares is closed by Parser_profileExit
+// whenever the rule returns.
+#define Parser_trace(p) \
+    __attribute__((cleanup(Parser_profileExit))) ParserProfileFrame profile_frame; \
+    profile_frame.rule = NULL; \
+    if ((p)->profile) Parser_profileEnter(p, &profile_frame, __func__); \
+    Parser_traceDump(p)
+
 #ifdef TRACE
-#define Parser_trace(p) Parser_dump0(p, __func__)
+#define Parser_traceDump(p) Parser_dump(p)
 #else
-#define Parser_trace(p)
+#define Parser_traceDump(p)
 #endif
 
-#define Parser_dump(p) Parser_dump0(p, __func__)
-__attribute__((unused))
-static void Parser_dump0(Parser *p, const char *function)
+static void Parser_enableProfile(Parser *p)
+{
+    p->profile = ParserProfile_create();
+}
+
+__attribute__((noinline))
+static void Parser_profileEnter(Parser *p, ParserProfileFrame *f, const char *function)
 {
-    Token t = p->tokens[p->index];
-    Buffer token = Buffer_slice(p->source, t.loc.start, t.loc.end);
-    std_printf("%d:%s:%s:"PRIb"\n", p->index, function, TokenTag_name(t.tag), Buffer(token));
+    ParserProfileRule *rule = ParserProfile_rule(p->profile, function);
+    rule->calls++;
+    rule->depth++;
+    *f = (ParserProfileFrame){
+        .p = p,
+        .rule = rule,
+        .parent = p->profile_frame,
+        .start = p->index,
+        .cycles = std_cycles(),
+    };
+    p->profile_frame = f;
+}
+
+__attribute__((noinline))
+static void Parser_profileExit0(ParserProfileFrame *f)
+{
+    Parser *p = f->p;
+    uint64_t cycles = std_cycles() - f->cycles;
+    ParserProfileRule *rule = f->rule;
+    if (p->index > f->start) {
+        rule->matches++;
+        rule->tokens += p->index - f->start;
+    }
+    rule->self_cycles += cycles - f->child_cycles;
+    if (--rule->depth == 0) rule->cycles += cycles;
+    if (f->parent) f->parent->child_cycles += cycles;
+    p->profile_frame = f->parent;
+}
+
+static inline void Parser_profileExit(ParserProfileFrame *f)
+{
+    if (f->rule) Parser_profileExit0(f);
 }
 
 #define Parser_expect(p, tag) Parser_expect0(p, __LINE__, __func__, tag)
 static void Parser_expect0(Parser *p, int line_no, const char *function, TokenTag tag)
 {
-    Token found = p->tokens[p->index];
-    if (!Parser_eat(p, tag)) Parser_fail0(p, line_no, "%s: expected tag %s found %s\n", function, TokenTag_name(tag), TokenTag_name(found.tag));
+    TokenTag found = Parser_tag(p, p->index);
+    if (!Parser_eat(p, tag)) Parser_fail0(p, line_no, "%s: expected tag %s found %s\n", function, TokenTag_name(tag), TokenTag_name(found));
 }
 
 static TokenTag Parser_eatOneOf(Parser *p, TokenTag *tags, size_t tags_len)
@@ -1085,23 +1782,21 @@ static TokenTag Parser_eatOneOf(Parser *p, TokenTag *tags, size_t tags_len)
 
 static Buffer Parser_tokenSlice(Parser *p)
 {
-    Token t = p->tokens[p->index];
-    return Buffer_slice(p->source, t.loc.start, t.loc.end);
+    uint32_t start = Parser_tokenStart(p, p->index);
+    return Buffer_slice(p->source, start, Tokenizer_tokenEnd(p->source, start));
 }
 
-static Buffer Parser_eatIdentifier(Parser *p)
+static TokenIndex Parser_eatIdentifier(Parser *p)
 {
-    Buffer b = Parser_tokenSlice(p);
-    if (Parser_eat(p, token_identifier)) return b;
-    return Buffer_empty();
+    if (!Parser_eat(p, token_identifier)) return TOKEN_NONE;
+    return p->index - 1;
 }
 
 #define Parser_expectIdentifier(p) Parser_expectIdentifier0(p, __func__)
-static Buffer Parser_expectIdentifier0(Parser *p, const char *function)
+static TokenIndex Parser_expectIdentifier0(Parser *p, const char *function)
 {
-    Buffer b = Parser_tokenSlice(p);
     if (!Parser_eat(p, token_identifier)) Parser_fail(p, "%s: expected identifier\n", function);
-    return b;
+    return p->index - 1;
 }
 
 #define Parser_allocNode(p) Parser_allocNode0(p, __func__, __LINE__)
@@ -1115,171 +1810,211 @@ static Node* Parser_allocNode0(Parser *p, const char *function, int line)
     std_printf("Node - %s:%d\n", function, line);
 #endif
 
-    p->nodes_count++;
-    Node *n = std_malloc(sizeof(Node));
-    if (!n) std_panic("oom\n");
-    return n;
+    NodeArray_append(&p->ast.nodes, (Node){ .tag = node_invalid });
+    return &p->ast.nodes.data[p->ast.nodes.len - 1];
+}
+
+// The pointer returned by Parser_allocNode is only valid until the next node is allocated.
+static NodeIndex Parser_nodeIndex(Parser *p, const Node *n)
+{
+    return (NodeIndex)(n - p->ast.nodes.data);
+}
+
+// Node lists are collected on Parser.scratch and copied into Ast.extra once complete. Lists nest,
+// so the scratch array is used as a stack: a list owns the entries above the length it started at.
+typedef struct ParserList {
+    uint32_t top;
+    uint32_t len;
+} ParserList;
+
+static ParserList Parser_startList(Parser *p)
+{
+    return (ParserList){ .top = p->scratch.len, .len = 0 };
+}
+
+static void Parser_listAppend(Parser *p, ParserList *l, uint32_t item)
+{
+    assume(p->scratch.len == l->top + l->len);
+    IndexArray_append(&p->scratch, item);
+    l->len++;
 }
 
-static Node* Parser_parseExpr(Parser *p);
+// Pop an unfinished list off the scratch stack.
+static void Parser_dropList(Parser *p, ParserList *l)
+{
+    p->scratch.len = l->top;
+}
+
+// Move a list from the scratch stack into Ast.extra.
+static ExtraIndex Parser_finishList(Parser *p, ParserList *l)
+{
+    assume(p->scratch.len == l->top + l->len);
+    ExtraIndex list = p->ast.extra.len;
+    IndexArray_appendMany(&p->ast.extra, p->scratch.data + l->top, l->len);
+    p->scratch.len = l->top;
+    return list;
+}
+
+// Loop guard, fails if a whole iteration went by without consuming a token.
+static bool Parser_progress(Parser *p, uint32_t *at)
+{
+    if (p->index == *at) Parser_fail(p, "infinite loop");
+    *at = p->index;
+    return true;
+}
+
+static NodeIndex Parser_parseExpr(Parser *p);
 
 // ExprList <- (Expr COMMA)* Expr?
-static Node** Parser_parseExprList(Parser *p, uint32_t *exprs_len)
+static ExtraIndex Parser_parseExprList(Parser *p, uint32_t *exprs_len)
 {
     Parser_trace(p);
-    NodeArray exprs;
-    NodeArray_init(&exprs);
+    ParserList exprs = Parser_startList(p);
 
-    int c = 0;
-    while (c++ < LOOP_MAX) {
-        Node *expr = Parser_parseExpr(p);
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at)) {
+        NodeIndex expr = Parser_parseExpr(p);
         if (!expr) break;
-        NodeArray_append(&exprs, expr);
+        Parser_listAppend(p, &exprs, expr);
         if (!Parser_eat(p, token_comma)) break;
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop detected");
 
     *exprs_len = exprs.len;
-    return exprs.data;
+    return Parser_finishList(p, &exprs);
 }
 
-static Node* Parser_parseParamDecl(Parser *p);
+static NodeIndex Parser_parseParamDecl(Parser *p);
 // ParamDeclList <- (ParamDecl COMMA)* ParamDecl?
-static Node* Parser_parseParamDeclList(Parser *p)
+static NodeIndex Parser_parseParamDeclList(Parser *p)
 {
     Parser_trace(p);
 
-    NodeArray a;
-    NodeArray_init(&a);
+    ParserList a = Parser_startList(p);
 
-    int c = 0;
-    while (c++ < LOOP_MAX && !Parser_peek(p, token_r_paren)) {
-        Node *param = Parser_parseParamDecl(p);
-        if (!param) return NULL;
-        NodeArray_append(&a, param);
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at) && !Parser_peek(p, token_r_paren)) {
+        NodeIndex param = Parser_parseParamDecl(p);
+        if (!param) {
+            Parser_dropList(p, &a);
+            return NODE_NONE;
+        }
+        Parser_listAppend(p, &a, param);
         Parser_eat(p, token_comma);
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
 
     Node *n = Parser_allocNode(p);
     n->tag = node_param_decl_list;
     n->data.param_decl_list = (NodeDataParamDeclList){
-        .params = a.data,
+        .params = Parser_finishList(p, &a),
         .params_len = a.len
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
-static Node* Parser_parseAsmInputItem(Parser *p);
+static NodeIndex Parser_parseAsmInputItem(Parser *p);
 // AsmInputList <- (AsmInputItem COMMA)* AsmInputItem?
-static Node* Parser_parseAsmInputList(Parser *p)
+static NodeIndex Parser_parseAsmInputList(Parser *p)
 {
-    NodeArray a;
-    NodeArray_init(&a);
+    Parser_trace(p);
+    ParserList a = Parser_startList(p);
 
-    int c = 0;
-    while (c++ < LOOP_MAX) {
-        Node *item = Parser_parseAsmInputItem(p);
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at)) {
+        NodeIndex item = Parser_parseAsmInputItem(p);
         if (!item) break;
-        NodeArray_append(&a, item);
+        Parser_listAppend(p, &a, item);
         if (!Parser_eat(p, token_comma)) break;
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
 
     Node *n = Parser_allocNode(p);
     n->tag = node_asm_input_list;
     n->data.asm_input_list = (NodeDataAsmInputList){
-        .asm_inputs = a.data,
+        .asm_inputs = Parser_finishList(p, &a),
         .asm_inputs_len = a.len,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
-static Node* Parser_parseAsmOutputItem(Parser *p);
+static NodeIndex Parser_parseAsmOutputItem(Parser *p);
 // AsmOutputList <- (AsmOutputItem COMMA)* AsmOutputItem?
-static Node* Parser_parseAsmOutputList(Parser *p)
+static NodeIndex Parser_parseAsmOutputList(Parser *p)
 {
-    NodeArray a;
-    NodeArray_init(&a);
+    Parser_trace(p);
+    ParserList a = Parser_startList(p);
 
-    int c = 0;
-    while (c++ < LOOP_MAX) {
-        Node *item = Parser_parseAsmOutputItem(p);
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at)) {
+        NodeIndex item = Parser_parseAsmOutputItem(p);
         if (!item) break;
-        NodeArray_append(&a, item);
+        Parser_listAppend(p, &a, item);
         if (!Parser_eat(p, token_comma)) break;
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
 
     Node *n = Parser_allocNode(p);
     n->tag = node_asm_output_list;
     n->data.asm_output_list = (NodeDataAsmOutputList){
-        .asm_outputs = a.data,
+        .asm_outputs = Parser_finishList(p, &a),
         .asm_outputs_len = a.len,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
-static Node* Parser_parseSwitchProng(Parser *p);
+static NodeIndex Parser_parseSwitchProng(Parser *p);
 // SwitchProngList <- (SwitchProng COMMA)* SwitchProng?
-static Node* Parser_parseSwitchProngList(Parser *p)
+static NodeIndex Parser_parseSwitchProngList(Parser *p)
 {
     Parser_trace(p);
-    NodeArray a;
-    NodeArray_init(&a);
+    ParserList a = Parser_startList(p);
 
-    int c = 0;
-    while (c++ < LOOP_MAX) {
-        Node *prong = Parser_parseSwitchProng(p);
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at)) {
+        NodeIndex prong = Parser_parseSwitchProng(p);
         if (!prong) break;
-        NodeArray_append(&a, prong);
+        Parser_listAppend(p, &a, prong);
         if (!Parser_eat(p, token_comma)) break;
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
 
     Node *n = Parser_allocNode(p);
     n->tag = node_switch_prong_list;
     n->data.switch_prong_list = (NodeDataSwitchProngList){
-        .prongs = a.data,
+        .prongs = Parser_finishList(p, &a),
         .prongs_len = a.len,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // IdentifierList <- (doc_comment? IDENTIFIER COMMA)* (doc_comment? IDENTIFIER)?
-static Node* Parser_parseIdentifierList(Parser *p)
+static NodeIndex Parser_parseIdentifierList(Parser *p)
 {
     Parser_trace(p);
 
-    BufferArray a;
-    BufferArray_init(&a);
+    ParserList a = Parser_startList(p);
 
-    int c = 0;
-    while (c++ < LOOP_MAX) {
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at)) {
         while (Parser_eat(p, token_doc_comment)) {}
-        Buffer ident = Parser_eatIdentifier(p);
-        if (ident.len == 0) break;
-        BufferArray_append(&a, ident);
+        TokenIndex ident = Parser_eatIdentifier(p);
+        if (ident == TOKEN_NONE) break;
+        Parser_listAppend(p, &a, ident);
         if (!Parser_eat(p, token_comma)) break;
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
 
     Node *n = Parser_allocNode(p);
     n->tag = node_identifier_list;
     n->data.identifier_list = (NodeDataIdentifierList){
-        .idents = a.data,
+        .idents = Parser_finishList(p, &a),
         .idents_len = a.len,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // ByteAlign <- KEYWORD_align LPAREN Expr RPAREN
-static Node* Parser_parseByteAlign(Parser *p)
+static NodeIndex Parser_parseByteAlign(Parser *p)
 {
     Parser_trace(p);
-    if (!Parser_eat(p, token_keyword_align)) return NULL;
+    if (!Parser_eat(p, token_keyword_align)) return NODE_NONE;
     Parser_expect(p, token_l_paren);
-    Node *n = Parser_parseExpr(p);
+    NodeIndex n = Parser_parseExpr(p);
     Parser_expect(p, token_r_paren);
     return n;
 }
@@ -1289,11 +2024,11 @@ static Node* Parser_parseByteAlign(Parser *p)
 //      / KEYWORD_opaque
 //      / KEYWORD_enum (LPAREN Expr RPAREN)?
 //      / KEYWORD_union (LPAREN (KEYWORD_enum (LPAREN Expr RPAREN)? / Expr) RPAREN)?
-static Node* Parser_parseContainerDeclType(Parser *p)
+static NodeIndex Parser_parseContainerDeclType(Parser *p)
 {
     Parser_trace(p);
     if (Parser_eat(p, token_keyword_struct)) {
-        Node *expr = NULL;
+        NodeIndex expr = NODE_NONE;
         if (Parser_eat(p, token_l_paren)) {
             expr = Parser_parseExpr(p);
             Parser_expect(p, token_r_paren);
@@ -1301,13 +2036,13 @@ static Node* Parser_parseContainerDeclType(Parser *p)
         Node *n = Parser_allocNode(p);
         n->tag = node_struct_decl;
         n->data.struct_decl = expr;
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_keyword_opaque)) {
         Node *n = Parser_allocNode(p);
         n->tag = node_opaque_decl;
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_keyword_enum)) {
-        Node *expr = NULL;
+        NodeIndex expr = NODE_NONE;
         if (Parser_eat(p, token_l_paren)) {
             expr = Parser_parseExpr(p);
             Parser_expect(p, token_r_paren);
@@ -1315,9 +2050,9 @@ static Node* Parser_parseContainerDeclType(Parser *p)
         Node *n = Parser_allocNode(p);
         n->tag = node_enum_decl;
         n->data.enum_decl = expr;
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_keyword_union)) {
-        Node *expr = NULL;
+        NodeIndex expr = NODE_NONE;
         bool is_tagged = false;
         if (Parser_eat(p, token_l_paren)) {
             if (Parser_eat(p, token_keyword_enum)) {
@@ -1337,23 +2072,23 @@ static Node* Parser_parseContainerDeclType(Parser *p)
             .is_tagged = is_tagged,
             .expr = expr,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
-    return NULL;
+    return NODE_NONE;
 }
 
-static Node* Parser_expectContainerMembers(Parser *p);
+static NodeIndex Parser_expectContainerMembers(Parser *p, bool is_root);
 // ContainerDeclAuto <- ContainerDeclType LBRACE ContainerMembers RBRACE
-static Node* Parser_parseContainerDeclAuto(Parser *p)
+static NodeIndex Parser_parseContainerDeclAuto(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
-    Node *type = Parser_parseContainerDeclType(p);
+    NodeIndex type = Parser_parseContainerDeclType(p);
     if (!type) goto fail;
     if (!Parser_eat(p, token_l_brace)) goto fail;
-    Node *members = Parser_expectContainerMembers(p);
+    NodeIndex members = Parser_expectContainerMembers(p, false);
     if (!Parser_eat(p, token_r_brace)) goto fail;
 
     Node *n = Parser_allocNode(p);
@@ -1362,23 +2097,23 @@ static Node* Parser_parseContainerDeclAuto(Parser *p)
         .type = type,
         .members = members,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // ArrayTypeStart <- LBRACKET Expr (COLON Expr)? RBRACKET
-static Node* Parser_parseArrayTypeStart(Parser *p)
+static NodeIndex Parser_parseArrayTypeStart(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
     if (!Parser_eat(p, token_l_bracket)) goto fail;
-    Node *index_expr = Parser_parseExpr(p);
-    if (!index) goto fail;
-    Node *sentinel_expr = NULL;
+    NodeIndex index_expr = Parser_parseExpr(p);
+    if (!index_expr) goto fail;
+    NodeIndex sentinel_expr = NODE_NONE;
     if (Parser_eat(p, token_colon)) {
         sentinel_expr = Parser_parseExpr(p);
         if (!sentinel_expr) goto fail;
@@ -1391,21 +2126,21 @@ static Node* Parser_parseArrayTypeStart(Parser *p)
         .index = index_expr,
         .sentinel_expr = sentinel_expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // PtrTypeStart
 //     <- ASTERISK
 //      / ASTERISK2
 //      / LBRACKET ASTERISK (LETTERC / COLON Expr)? RBRACKET
-static Node* Parser_parsePtrTypeStart(Parser *p)
+static NodeIndex Parser_parsePtrTypeStart(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
     if (Parser_eat(p, token_asterisk)) {
         Node *n = Parser_allocNode(p);
@@ -1413,21 +2148,21 @@ static Node* Parser_parsePtrTypeStart(Parser *p)
         n->data.ptr_type_start = (NodeDataPtrTypeStart){
             .type = node_ptr_type_single,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_asterisk_asterisk)) {
         Node *n = Parser_allocNode(p);
         n->tag = node_ptr_type_start;
         n->data.ptr_type_start = (NodeDataPtrTypeStart){
             .type = node_ptr_type_double,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
     if (!Parser_eat(p, token_l_bracket)) goto fail;
     if (!Parser_eat(p, token_asterisk)) goto fail;
 
     NodePtrType type = node_ptr_type_multi;
-    Node *sentinel_expr = NULL;
+    NodeIndex sentinel_expr = NODE_NONE;
 
     if (Parser_eat(p, token_colon)) {
         type = node_ptr_type_sentinel;
@@ -1447,21 +2182,21 @@ static Node* Parser_parsePtrTypeStart(Parser *p)
         .type = type,
         .sentinel_expr = sentinel_expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // SliceTypeStart <- LBRACKET (COLON Expr)? RBRACKET
-static Node* Parser_parseSliceTypeStart(Parser *p)
+static NodeIndex Parser_parseSliceTypeStart(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
     if (!Parser_eat(p, token_l_bracket)) goto fail;
-    Node *sentinel_expr = NULL;
+    NodeIndex sentinel_expr = NODE_NONE;
     if (Parser_eat(p, token_colon)) {
         sentinel_expr = Parser_parseExpr(p);
     }
@@ -1472,21 +2207,21 @@ static Node* Parser_parseSliceTypeStart(Parser *p)
     n->data.slice_type_start = (NodeDataSliceTypeStart){
         .sentinel_expr = sentinel_expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // FnCallArguments <- LPAREN ExprList RPAREN
-static Node* Parser_parseFnCallArguments(Parser *p)
+static NodeIndex Parser_parseFnCallArguments(Parser *p)
 {
     Parser_trace(p);
-    if (!Parser_eat(p, token_l_paren)) return NULL;
+    if (!Parser_eat(p, token_l_paren)) return NODE_NONE;
 
     uint32_t exprs_len = 0;
-    Node **expr_list = NULL;
+    ExtraIndex expr_list = 0;
     if (!Parser_eat(p, token_r_paren)) {
         exprs_len = 0;
         expr_list = Parser_parseExprList(p, &exprs_len);
@@ -1499,7 +2234,7 @@ static Node* Parser_parseFnCallArguments(Parser *p)
         .exprs = expr_list,
         .exprs_len = exprs_len,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // SuffixOp
@@ -1507,13 +2242,13 @@ static Node* Parser_parseFnCallArguments(Parser *p)
 //      / DOT IDENTIFIER
 //      / DOTASTERISK
 //      / DOTQUESTIONMARK
-static Node* Parser_parseSuffixOp(Parser *p)
+static NodeIndex Parser_parseSuffixOp0(Parser *p)
 {
     Parser_trace(p);
     if (Parser_eat(p, token_l_bracket)) {
-        Node *range_start = Parser_parseExpr(p);
-        Node *range_end = NULL;
-        Node *sentinel = NULL;
+        NodeIndex range_start = Parser_parseExpr(p);
+        NodeIndex range_end = NODE_NONE;
+        NodeIndex sentinel = NODE_NONE;
         if (Parser_eat(p, token_ellipsis2)) {
             range_end = Parser_parseExpr(p);
             if (Parser_eat(p, token_colon)) {
@@ -1529,40 +2264,48 @@ static Node* Parser_parseSuffixOp(Parser *p)
             .end_expr = range_end,
             .sentinel_expr = sentinel,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_period)) {
         // NOTE: grammar not updated but `.?` is not a singular token.
         if (Parser_eat(p, token_question_mark)) {
             Node *n = Parser_allocNode(p);
             n->tag = node_suffix_type_op_assert_maybe;
-            return n;
+            return Parser_nodeIndex(p, n);
         }
 
-        Buffer name = Parser_expectIdentifier(p);
+        TokenIndex name = Parser_expectIdentifier(p);
         Node *n = Parser_allocNode(p);
         n->tag = node_suffix_type_op_named_access;
         n->data.suffix_type_op_named_access = (NodeDataSuffixTypeOpNamedAccess){
             .name = name,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_period_asterisk)) {
         Node *n = Parser_allocNode(p);
         n->tag = node_suffix_type_op_deref;
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
-    return NULL;
+    return NODE_NONE;
+}
+
+static NodeIndex Parser_parseSuffixOp(Parser *p)
+{
+    NodeIndex n;
+    if (Parser_memoGet(p, parser_rule_suffix_op, &n)) return n;
+    uint32_t start = p->index;
+    return Parser_memoPut(p, parser_rule_suffix_op, start, Parser_parseSuffixOp0(p));
 }
 
 // Align <- KEYWORD_align LPAREN Expr (COLON Expr COLON Expr)? RPAREN
-static Node* Parser_parseAlign(Parser *p)
+static NodeIndex Parser_parseAlign(Parser *p)
 {
     Parser_trace(p);
-    if (!Parser_eat(p, token_keyword_align)) return NULL;
+    if (!Parser_eat(p, token_keyword_align)) return NODE_NONE;
     Parser_expect(p, token_l_paren);
-    Node *byte_align = Parser_parseExpr(p);
-    Node *bit_offset = NULL;
-    Node *bit_backing_integer_size = NULL;
+    NodeIndex byte_align = Parser_parseExpr(p);
+    NodeIndex bit_offset = NODE_NONE;
+    NodeIndex bit_backing_integer_size = NODE_NONE;
     if (Parser_eat(p, token_colon)) {
         bit_offset = Parser_parseExpr(p);
         if (!bit_offset) Parser_fail(p, "expected expression for bit_offset");
@@ -1579,37 +2322,37 @@ static Node* Parser_parseAlign(Parser *p)
         .bit_offset = bit_offset,
         .bit_backing_integer_size = bit_backing_integer_size,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
-static Node* Parser_parseAddrSpace(Parser *p);
+static NodeIndex Parser_parseAddrSpace(Parser *p);
 // PrefixTypeOp
 //     <- QUESTIONMARK
 //      / KEYWORD_anyframe MINUSRARROW
 //      / SliceTypeStart (ByteAlign / AddrSpace / KEYWORD_const / KEYWORD_volatile / KEYWORD_allowzero)*
 //      / PtrTypeStart (AddrSpace / Align / KEYWORD_const / KEYWORD_volatile / KEYWORD_allowzero)*
 //      / ArrayTypeStart
-static Node* Parser_parsePrefixTypeOp(Parser *p)
+static NodeIndex Parser_parsePrefixTypeOp0(Parser *p)
 {
     Parser_trace(p);
     if (Parser_eat(p, token_question_mark)) {
         Node *n = Parser_allocNode(p);
         n->tag = node_prefix_type_op_optional;
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_keyword_anyframe)) {
         Node *n = Parser_allocNode(p);
         n->tag = node_prefix_type_op_anyframe;
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
-    Node *slice_type_start = Parser_parseSliceTypeStart(p);
+    NodeIndex slice_type_start = Parser_parseSliceTypeStart(p);
     if (slice_type_start) {
-        Node *bytealign = NULL;
-        Node *addrspace = NULL;
+        NodeIndex bytealign = NODE_NONE;
+        NodeIndex addrspace = NODE_NONE;
         tTypePointerModifiers modifiers = 0;
 
-        int c = 0;
-        while (c++ < LOOP_MAX) {
+        uint32_t at = TOKEN_NONE;
+        while (Parser_progress(p, &at)) {
             bytealign = Parser_parseByteAlign(p);
             if (bytealign) {
                 continue;
@@ -1637,7 +2380,6 @@ static Node* Parser_parsePrefixTypeOp(Parser *p)
 
             break;
         }
-        if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
 
         Node *n = Parser_allocNode(p);
         n->tag = node_prefix_type_op_slice;
@@ -1647,17 +2389,17 @@ static Node* Parser_parsePrefixTypeOp(Parser *p)
             .addrspace = addrspace,
             .modifiers = modifiers,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
-    Node *ptr_type_start = Parser_parsePtrTypeStart(p);
+    NodeIndex ptr_type_start = Parser_parsePtrTypeStart(p);
     if (ptr_type_start) {
-        Node *addrspace = NULL;
-        Node *align = NULL;
+        NodeIndex addrspace = NODE_NONE;
+        NodeIndex align = NODE_NONE;
         tTypePointerModifiers modifiers = 0;
 
-        int c = 0;
-        while (c++ < LOOP_MAX) {
+        uint32_t at = TOKEN_NONE;
+        while (Parser_progress(p, &at)) {
             addrspace = Parser_parseAddrSpace(p);
             if (addrspace) {
                 continue;
@@ -1685,7 +2427,6 @@ static Node* Parser_parsePrefixTypeOp(Parser *p)
 
             break;
         }
-        if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
 
         Node *n = Parser_allocNode(p);
         n->tag = node_prefix_type_op_ptr;
@@ -1695,20 +2436,28 @@ static Node* Parser_parsePrefixTypeOp(Parser *p)
             .addrspace = addrspace,
             .modifiers = modifiers,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
-    Node *array = Parser_parseArrayTypeStart(p);
+    NodeIndex array = Parser_parseArrayTypeStart(p);
     if (array) {
         Node *n = Parser_allocNode(p);
         n->tag = node_prefix_type_op_array;
         n->data.prefix_type_array = (NodeDataPrefixTypeArray){
             .array = array,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
-    return NULL;
+    return NODE_NONE;
+}
+
+static NodeIndex Parser_parsePrefixTypeOp(Parser *p)
+{
+    NodeIndex n;
+    if (Parser_memoGet(p, parser_rule_prefix_type_op, &n)) return n;
+    uint32_t start = p->index;
+    return Parser_memoPut(p, parser_rule_prefix_type_op, start, Parser_parsePrefixTypeOp0(p));
 }
 
 // PrefixOp
@@ -1721,14 +2470,14 @@ static Node* Parser_parsePrefixTypeOp(Parser *p)
 static TokenTag Parser_eatPrefixOp(Parser *p)
 {
     Parser_trace(p);
-    switch (p->tokens[p->index].tag) {
+    switch (Parser_tag(p, p->index)) {
         case token_bang:
         case token_minus:
         case token_tilde:
         case token_minus_percent:
         case token_ampersand:
         case token_keyword_try:
-            return p->tokens[p->index++].tag;
+            return Parser_tag(p, p->index++);
         default:
             return token_invalid;
     }
@@ -1756,7 +2505,7 @@ static TokenTag Parser_eatPrefixOp(Parser *p)
 static TokenTag Parser_eatAssignOp(Parser *p)
 {
     Parser_trace(p);
-    switch (p->tokens[p->index].tag) {
+    switch (Parser_tag(p, p->index)) {
         case token_asterisk_equal:
         case token_asterisk_pipe_equal:
         case token_slash_equal:
@@ -1775,20 +2524,20 @@ static TokenTag Parser_eatAssignOp(Parser *p)
         case token_plus_percent_equal:
         case token_minus_percent_equal:
         case token_equal:
-            return p->tokens[p->index++].tag;
+            return Parser_tag(p, p->index++);
         default:
             return token_invalid;
     }
 }
 
 // ForItem <- Expr (DOT2 Expr?)?
-static Node* Parser_parseForItem(Parser *p)
+static NodeIndex Parser_parseForItem(Parser *p)
 {
     Parser_trace(p);
-    Node *for_start = Parser_parseExpr(p);
-    if (!for_start) return NULL;
+    NodeIndex for_start = Parser_parseExpr(p);
+    if (!for_start) return NODE_NONE;
 
-    Node *for_end = NULL;
+    NodeIndex for_end = NODE_NONE;
     bool is_range = false;
     if (Parser_eat(p, token_ellipsis2)) {
         for_end = Parser_parseExpr(p);
@@ -1802,41 +2551,39 @@ static Node* Parser_parseForItem(Parser *p)
         .for_end = for_end,
         .is_range = is_range,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // ForArgumentsList <- ForItem (COMMA ForItem)* COMMA?
-static Node* Parser_parseForArgumentsList(Parser *p)
+static NodeIndex Parser_parseForArgumentsList(Parser *p)
 {
     Parser_trace(p);
-    NodeArray args;
-    NodeArray_init(&args);
+    ParserList args = Parser_startList(p);
 
-    int c = 0;
-    while (c++ < LOOP_MAX) {
-        Node *arg = Parser_parseForItem(p);
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at)) {
+        NodeIndex arg = Parser_parseForItem(p);
         if (!arg) break;
         Parser_eat(p, token_comma);
-        NodeArray_append(&args, arg);
+        Parser_listAppend(p, &args, arg);
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
 
     Node *n = Parser_allocNode(p);
     n->tag = node_for_args;
     n->data.for_args = (NodeDataForArgs){
-        .args = args.data,
+        .args = Parser_finishList(p, &args),
         .args_len = args.len,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // SwitchItem <- Expr (DOT3 Expr)?
-static Node* Parser_parseSwitchItem(Parser *p)
+static NodeIndex Parser_parseSwitchItem(Parser *p)
 {
     Parser_trace(p);
-    Node *start = Parser_parseExpr(p);
-    if (!start) return NULL;
-    Node *end = NULL;
+    NodeIndex start = Parser_parseExpr(p);
+    if (!start) return NODE_NONE;
+    NodeIndex end = NODE_NONE;
     if (Parser_eat(p, token_ellipsis3)) {
         end = Parser_parseExpr(p);
         if (!end) Parser_fail(p, "expected expression after ...");
@@ -1848,13 +2595,13 @@ static Node* Parser_parseSwitchItem(Parser *p)
         .start = start,
         .end = end,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // SwitchCase
 //     <- SwitchItem (COMMA SwitchItem)* COMMA?
 //      / KEYWORD_else
-static Node* Parser_parseSwitchCase(Parser *p)
+static NodeIndex Parser_parseSwitchCase(Parser *p)
 {
     Parser_trace(p);
     if (Parser_eat(p, token_keyword_else)) {
@@ -1863,46 +2610,44 @@ static Node* Parser_parseSwitchCase(Parser *p)
         n->data.switch_case = (NodeDataSwitchCase){
             .is_else = true,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
-    NodeArray cases;
-    NodeArray_init(&cases);
+    ParserList cases = Parser_startList(p);
 
-    int c = 0;
-    while (c++ < LOOP_MAX && !Parser_peek(p, token_equal_angle_bracket_right)) {
-        Node *item = Parser_parseSwitchItem(p);
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at) && !Parser_peek(p, token_equal_angle_bracket_right)) {
+        NodeIndex item = Parser_parseSwitchItem(p);
         if (!item) break;
         Parser_eat(p, token_comma);
-        NodeArray_append(&cases, item);
+        Parser_listAppend(p, &cases, item);
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
 
     Node *n = Parser_allocNode(p);
     n->tag = node_switch_case;
     n->data.switch_case = (NodeDataSwitchCase){
         .is_else = false,
-        .cases = cases.data,
+        .cases = Parser_finishList(p, &cases),
         .cases_len = cases.len,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
-static Node* Parser_parsePtrIndexPayload(Parser *p);
-static Node* Parser_parseSingleAssignExpr(Parser *p);
+static NodeIndex Parser_parsePtrIndexPayload(Parser *p);
+static NodeIndex Parser_parseSingleAssignExpr(Parser *p);
 // SwitchProng <- KEYWORD_inline? SwitchCase EQUALRARROW PtrIndexPayload? SingleAssignExpr
-static Node* Parser_parseSwitchProng(Parser *p)
+static NodeIndex Parser_parseSwitchProng(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
     bool is_inline = Parser_eat(p, token_keyword_inline);
-    Node *sc = Parser_parseSwitchCase(p);
+    NodeIndex sc = Parser_parseSwitchCase(p);
     if (!sc) goto fail;
     if (!Parser_eat(p, token_equal_angle_bracket_right)) goto fail;
 
-    Node *payload = Parser_parsePtrIndexPayload(p);
-    Node *expr = Parser_parseSingleAssignExpr(p);
+    NodeIndex payload = Parser_parsePtrIndexPayload(p);
+    NodeIndex expr = Parser_parseSingleAssignExpr(p);
     if (!expr) goto fail;
 
     Node *n = Parser_allocNode(p);
@@ -1913,59 +2658,54 @@ static Node* Parser_parseSwitchProng(Parser *p)
         .payload = payload,
         .expr = expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // PtrListPayload <- PIPE ASTERISK? IDENTIFIER (COMMA ASTERISK? IDENTIFIER)* COMMA? PIPE
-static Node* Parser_parsePtrListPayload(Parser *p)
+static NodeIndex Parser_parsePtrListPayload(Parser *p)
 {
     Parser_trace(p);
-    NodeArray a;
-    NodeArray_init(&a);
+    ParserList a = Parser_startList(p);
 
     Parser_expect(p, token_pipe);
-    int c = 0;
-    while (c++ < LOOP_MAX) {
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at)) {
         bool is_pointer = Parser_eat(p, token_asterisk);
-        Buffer name = Parser_expectIdentifier(p);
+        TokenIndex name = Parser_expectIdentifier(p);
         Node *n = Parser_allocNode(p);
         n->tag = node_payload;
         n->data.payload = (NodeDataPayload){
             .name = name,
             .is_pointer = is_pointer,
         };
-        NodeArray_append(&a, n);
+        Parser_listAppend(p, &a, Parser_nodeIndex(p, n));
         if (!Parser_eat(p, token_comma)) break;
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
     Parser_eat(p, token_comma);
     Parser_expect(p, token_pipe);
 
     Node *n = Parser_allocNode(p);
     n->tag = node_payload_list;
     n->data.payload_list = (NodeDataPayloadList){
-        .payloads = a.data,
+        .payloads = Parser_finishList(p, &a),
         .payloads_len = a.len,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // PtrIndexPayload <- PIPE ASTERISK? IDENTIFIER (COMMA IDENTIFIER)? PIPE
-static Node* Parser_parsePtrIndexPayload(Parser *p)
+static NodeIndex Parser_parsePtrIndexPayload(Parser *p)
 {
     Parser_trace(p);
-    NodeArray a;
-    NodeArray_init(&a);
-
-    if (!Parser_eat(p, token_pipe)) return NULL;
+    if (!Parser_eat(p, token_pipe)) return NODE_NONE;
     bool is_pointer = Parser_eat(p, token_asterisk);
-    Buffer name = Parser_expectIdentifier(p);
+    TokenIndex name = Parser_expectIdentifier(p);
 
-    Buffer name_index = Buffer_empty();
+    TokenIndex name_index = TOKEN_NONE;
     if (Parser_eat(p, token_comma)) {
         name_index = Parser_expectIdentifier(p);
     }
@@ -1978,16 +2718,16 @@ static Node* Parser_parsePtrIndexPayload(Parser *p)
         .is_pointer = is_pointer,
         .name_index = name_index,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // PtrPayload <- PIPE ASTERISK? IDENTIFIER PIPE
-static Node* Parser_parsePtrPayload(Parser *p)
+static NodeIndex Parser_parsePtrPayload(Parser *p)
 {
     Parser_trace(p);
-    if (!Parser_eat(p, token_pipe)) return NULL;
+    if (!Parser_eat(p, token_pipe)) return NODE_NONE;
     bool is_pointer = Parser_eat(p, token_asterisk);
-    Buffer name = Parser_expectIdentifier(p);
+    TokenIndex name = Parser_expectIdentifier(p);
     Parser_expect(p, token_pipe);
 
     Node *n = Parser_allocNode(p);
@@ -1996,28 +2736,28 @@ static Node* Parser_parsePtrPayload(Parser *p)
         .name = name,
         .is_pointer = is_pointer,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // Payload <- PIPE IDENTIFIER PIPE
-static Buffer Parser_parsePayload(Parser *p)
+static TokenIndex Parser_parsePayload(Parser *p)
 {
     Parser_trace(p);
-    if (!Parser_eat(p, token_pipe)) return Buffer_empty();
-    Buffer name = Parser_expectIdentifier(p);
+    if (!Parser_eat(p, token_pipe)) return TOKEN_NONE;
+    TokenIndex name = Parser_expectIdentifier(p);
     Parser_expect(p, token_pipe);
     return name;
 }
 
 // ForPrefix <- KEYWORD_for LPAREN ForArgumentsList RPAREN PtrListPayload
-static Node* Parser_parseForPrefix(Parser *p)
+static NodeIndex Parser_parseForPrefix(Parser *p)
 {
     Parser_trace(p);
-    if (!Parser_eat(p, token_keyword_for)) return NULL;
+    if (!Parser_eat(p, token_keyword_for)) return NODE_NONE;
     Parser_expect(p, token_l_paren);
-    Node *for_args = Parser_parseForArgumentsList(p);
+    NodeIndex for_args = Parser_parseForArgumentsList(p);
     Parser_expect(p, token_r_paren);
-    Node *ptr_list_payload = Parser_parsePtrListPayload(p);
+    NodeIndex ptr_list_payload = Parser_parsePtrListPayload(p);
 
     Node *n = Parser_allocNode(p);
     n->tag = node_for_prefix;
@@ -2025,20 +2765,20 @@ static Node* Parser_parseForPrefix(Parser *p)
         .for_args = for_args,
         .ptr_list_payload = ptr_list_payload,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
-static Node* Parser_parseWhileContinueExpr(Parser *p);
+static NodeIndex Parser_parseWhileContinueExpr(Parser *p);
 // WhilePrefix <- KEYWORD_while LPAREN Expr RPAREN PtrPayload? WhileContinueExpr?
-static Node* Parser_parseWhilePrefix(Parser *p)
+static NodeIndex Parser_parseWhilePrefix(Parser *p)
 {
     Parser_trace(p);
-    if (!Parser_eat(p, token_keyword_while)) return NULL;
+    if (!Parser_eat(p, token_keyword_while)) return NODE_NONE;
     Parser_expect(p, token_l_paren);
-    Node *condition = Parser_parseExpr(p);
+    NodeIndex condition = Parser_parseExpr(p);
     Parser_expect(p, token_r_paren);
-    Node *ptr_payload = Parser_parsePtrPayload(p);
-    Node *while_continue_expr = Parser_parseWhileContinueExpr(p);
+    NodeIndex ptr_payload = Parser_parsePtrPayload(p);
+    NodeIndex while_continue_expr = Parser_parseWhileContinueExpr(p);
 
     Node *n = Parser_allocNode(p);
     n->tag = node_while_prefix;
@@ -2047,18 +2787,18 @@ static Node* Parser_parseWhilePrefix(Parser *p)
         .ptr_payload = ptr_payload,
         .while_continue_expr = while_continue_expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // IfPrefix <- KEYWORD_if LPAREN Expr RPAREN PtrPayload?
-static Node* Parser_parseIfPrefix(Parser *p)
+static NodeIndex Parser_parseIfPrefix(Parser *p)
 {
     Parser_trace(p);
-    if (!Parser_eat(p, token_keyword_if)) return NULL;
+    if (!Parser_eat(p, token_keyword_if)) return NODE_NONE;
     Parser_expect(p, token_l_paren);
-    Node *condition = Parser_parseExpr(p);
+    NodeIndex condition = Parser_parseExpr(p);
     Parser_expect(p, token_r_paren);
-    Node *ptr_payload = Parser_parsePtrPayload(p);
+    NodeIndex ptr_payload = Parser_parsePtrPayload(p);
 
     Node *n = Parser_allocNode(p);
     n->tag = node_if_prefix;
@@ -2066,21 +2806,21 @@ static Node* Parser_parseIfPrefix(Parser *p)
         .condition = condition,
         .ptr_payload = ptr_payload,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
-static Node* Parser_parseTypeExpr(Parser *p);
+static NodeIndex Parser_parseTypeExpr(Parser *p);
 // ParamType
 //     <- KEYWORD_anytype
 //      / TypeExpr
-static Node* Parser_parseParamType(Parser *p)
+static NodeIndex Parser_parseParamType(Parser *p)
 {
     Parser_trace(p);
     if (Parser_eat(p, token_keyword_anytype)) {
         Node *n = Parser_allocNode(p);
         n->tag = node_primary_type_expr;
         n->data.primary_type_expr.tag = node_primary_type_anytype;
-        return n;
+        return Parser_nodeIndex(p, n);
     }
     return Parser_parseTypeExpr(p);
 }
@@ -2088,29 +2828,30 @@ static Node* Parser_parseParamType(Parser *p)
 // ParamDecl
 //     <- doc_comment? (KEYWORD_noalias / KEYWORD_comptime)? (IDENTIFIER COLON)? ParamType
 //      / DOT3
-static Node* Parser_parseParamDecl(Parser *p)
+static NodeIndex Parser_parseParamDecl(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
     if (Parser_eat(p, token_ellipsis3)) {
         Node *n = Parser_allocNode(p);
         n->tag = node_param_decl;
         n->data.param_decl = (NodeDataParamDecl){
             .is_varargs = true,
+            .identifier = TOKEN_NONE,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
     while (Parser_eat(p, token_doc_comment)) {}
     TokenTag modifier = Parser_eatOneOf(p, (TokenTag[]){ token_keyword_noalias, token_keyword_comptime }, 2);
     // This may actually be the ParamType. Reset if no colon follows.
-    Buffer identifier = Parser_eatIdentifier(p);
-    if (identifier.len != 0 && !Parser_eat(p, token_colon)) {
-        identifier = Buffer_empty();
+    TokenIndex identifier = Parser_eatIdentifier(p);
+    if (identifier != TOKEN_NONE && !Parser_eat(p, token_colon)) {
+        identifier = TOKEN_NONE;
         p->index--;
     }
-    Node *type = Parser_parseParamType(p);
+    NodeIndex type = Parser_parseParamType(p);
     if (!type) goto fail;
 
     Node *n = Parser_allocNode(p);
@@ -2121,69 +2862,69 @@ static Node* Parser_parseParamDecl(Parser *p)
         .identifier = identifier,
         .type = type,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // CallConv <- KEYWORD_callconv LPAREN Expr RPAREN
-static Node* Parser_parseCallConv(Parser *p)
+static NodeIndex Parser_parseCallConv(Parser *p)
 {
     Parser_trace(p);
-    if (!Parser_eat(p, token_keyword_callconv)) return NULL;
+    if (!Parser_eat(p, token_keyword_callconv)) return NODE_NONE;
     Parser_expect(p, token_l_paren);
-    Node *n = Parser_parseExpr(p);
+    NodeIndex n = Parser_parseExpr(p);
     Parser_expect(p, token_r_paren);
     return n;
 }
 
 // AddrSpace <- KEYWORD_addrspace LPAREN Expr RPAREN
-static Node* Parser_parseAddrSpace(Parser *p)
+static NodeIndex Parser_parseAddrSpace(Parser *p)
 {
     Parser_trace(p);
-    if (!Parser_eat(p, token_keyword_addrspace)) return NULL;
+    if (!Parser_eat(p, token_keyword_addrspace)) return NODE_NONE;
     Parser_expect(p, token_l_paren);
-    Node *n = Parser_parseExpr(p);
+    NodeIndex n = Parser_parseExpr(p);
     Parser_expect(p, token_r_paren);
     return n;
 }
 
 // LinkSection <- KEYWORD_linksection LPAREN Expr RPAREN
-static Node* Parser_parseLinkSection(Parser *p)
+static NodeIndex Parser_parseLinkSection(Parser *p)
 {
     Parser_trace(p);
-    if (!Parser_eat(p, token_keyword_linksection)) return NULL;
+    if (!Parser_eat(p, token_keyword_linksection)) return NODE_NONE;
     Parser_expect(p, token_l_paren);
-    Node *n = Parser_parseExpr(p);
+    NodeIndex n = Parser_parseExpr(p);
     Parser_expect(p, token_r_paren);
     return n;
 }
 
-static Node* Parser_parseAssignExpr(Parser *p);
+static NodeIndex Parser_parseAssignExpr(Parser *p);
 // WhileContinueExpr <- COLON LPAREN AssignExpr RPAREN
-static Node* Parser_parseWhileContinueExpr(Parser *p)
+static NodeIndex Parser_parseWhileContinueExpr(Parser *p)
 {
     Parser_trace(p);
-    if (!Parser_eat(p, token_colon)) return NULL;
+    if (!Parser_eat(p, token_colon)) return NODE_NONE;
     Parser_expect(p, token_l_paren);
-    Node *expr = Parser_parseAssignExpr(p);
+    NodeIndex expr = Parser_parseAssignExpr(p);
     Parser_expect(p, token_r_paren);
     return expr;
 }
 
 // FieldInit <- DOT IDENTIFIER EQUAL Expr
-static Node* Parser_parseFieldInit(Parser *p)
+static NodeIndex Parser_parseFieldInit(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
-    if (!Parser_eat(p, token_period)) return NULL;
-    Buffer name = Parser_eatIdentifier(p);
-    if (name.len == 0) goto fail;
+    if (!Parser_eat(p, token_period)) return NODE_NONE;
+    TokenIndex name = Parser_eatIdentifier(p);
+    if (name == TOKEN_NONE) goto fail;
     if (!Parser_eat(p, token_equal)) goto fail;
-    Node *expr = Parser_parseExpr(p);
+    NodeIndex expr = Parser_parseExpr(p);
     if (!expr) Parser_fail(p, "expected expression");
 
     Node *n = Parser_allocNode(p);
@@ -2192,61 +2933,62 @@ static Node* Parser_parseFieldInit(Parser *p)
         .name = name,
         .expr = expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // BlockLabel <- IDENTIFIER COLON
-static Buffer Parser_parseBlockLabel(Parser *p)
+static TokenIndex Parser_parseBlockLabel(Parser *p)
 {
     Parser_trace(p);
-    if (p->tokens[p->index].tag == token_identifier && p->tokens[p->index + 1].tag == token_colon) {
-        Buffer name = Parser_tokenSlice(p);
+    if (Parser_tag(p, p->index) == token_identifier && Parser_tag(p, p->index + 1) == token_colon) {
+        TokenIndex name = p->index;
         p->index += 2;
         return name;
     }
 
-    return Buffer_empty();
+    return TOKEN_NONE;
 }
 
 // BreakLabel <- COLON IDENTIFIER
-static Buffer Parser_parseBreakLabel(Parser *p)
+static TokenIndex Parser_parseBreakLabel(Parser *p)
 {
     Parser_trace(p);
-    if (p->tokens[p->index].tag == token_colon && p->tokens[p->index + 1].tag == token_identifier) {
+    if (Parser_tag(p, p->index) == token_colon && Parser_tag(p, p->index + 1) == token_identifier) {
         p->index++;
-        Buffer name = Parser_tokenSlice(p);
+        TokenIndex name = p->index;
         p->index++;
         return name;
     }
 
-    return Buffer_empty();
+    return TOKEN_NONE;
 }
 
-static Node* Parser_parseExpr(Parser *p);
+static NodeIndex Parser_parseExpr(Parser *p);
 // AsmClobbers <- COLON Expr
-static Node* Parser_parseAsmClobbers(Parser *p)
+static NodeIndex Parser_parseAsmClobbers(Parser *p)
 {
     Parser_trace(p);
-    if (!Parser_eat(p, token_colon)) return NULL;
-    Node *n = Parser_parseExpr(p);
+    if (!Parser_eat(p, token_colon)) return NODE_NONE;
+    NodeIndex n = Parser_parseExpr(p);
     if (!n) Parser_fail(p, "expected expression");
     return n;
 }
 
 // AsmInputItem <- LBRACKET IDENTIFIER RBRACKET STRINGLITERAL LPAREN Expr RPAREN
-static Node* Parser_parseAsmInputItem(Parser *p)
+static NodeIndex Parser_parseAsmInputItem(Parser *p)
 {
-    if (!Parser_eat(p, token_l_bracket)) return NULL;
-    Buffer name = Parser_expectIdentifier(p);
+    Parser_trace(p);
+    if (!Parser_eat(p, token_l_bracket)) return NODE_NONE;
+    TokenIndex name = Parser_expectIdentifier(p);
     Parser_expect(p, token_r_bracket);
-    Buffer lit = Parser_tokenSlice(p);
+    TokenIndex lit = p->index;
     if (!Parser_eat(p, token_string_literal)) Parser_fail(p, "expected string literal");
     Parser_expect(p, token_l_paren);
-    Node *expr = Parser_parseExpr(p);
+    NodeIndex expr = Parser_parseExpr(p);
     Parser_expect(p, token_r_paren);
 
     Node *n = Parser_allocNode(p);
@@ -2256,16 +2998,17 @@ static Node* Parser_parseAsmInputItem(Parser *p)
         .lit = lit,
         .input_expr = expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // AsmInput <- COLON AsmInputList AsmClobbers?
-static Node* Parser_parseAsmInput(Parser *p)
+static NodeIndex Parser_parseAsmInput(Parser *p)
 {
-    if (!Parser_eat(p, token_colon)) return NULL;
-    Node *asm_input_list = Parser_parseAsmInputList(p);
+    Parser_trace(p);
+    if (!Parser_eat(p, token_colon)) return NODE_NONE;
+    NodeIndex asm_input_list = Parser_parseAsmInputList(p);
     if (!asm_input_list) Parser_fail(p, "expected asm input list");
-    Node *clobbers = Parser_parseAsmClobbers(p);
+    NodeIndex clobbers = Parser_parseAsmClobbers(p);
 
     Node *n = Parser_allocNode(p);
     n->tag = node_asm_input;
@@ -2273,49 +3016,55 @@ static Node* Parser_parseAsmInput(Parser *p)
         .asm_input_list = asm_input_list,
         .clobbers = clobbers,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // AsmOutputItem <- LBRACKET IDENTIFIER RBRACKET STRINGLITERAL LPAREN (MINUSRARROW TypeExpr / IDENTIFIER) RPAREN
-static Node* Parser_parseAsmOutputItem(Parser *p)
+static NodeIndex Parser_parseAsmOutputItem(Parser *p)
 {
-    if (!Parser_eat(p, token_l_bracket)) return NULL;
-    Buffer name = Parser_expectIdentifier(p);
+    Parser_trace(p);
+    if (!Parser_eat(p, token_l_bracket)) return NODE_NONE;
+    TokenIndex name = Parser_expectIdentifier(p);
     Parser_expect(p, token_r_bracket);
-    Buffer lit = Parser_tokenSlice(p);
+    TokenIndex lit = p->index;
     if (!Parser_eat(p, token_string_literal)) Parser_fail(p, "expected string literal");
     Parser_expect(p, token_l_paren);
 
-    Node *output_expr = Parser_allocNode(p);
-    output_expr->tag = node_type_or_name;
+    NodeDataTypeOrName type_or_name = { .type = NODE_NONE, .name = TOKEN_NONE };
     if (Parser_eat(p, token_arrow)) {
-        Node *expr = Parser_parseTypeExpr(p);
+        NodeIndex expr = Parser_parseTypeExpr(p);
         if (!expr) Parser_fail(p, "expected type expression");
-        output_expr->data.type_or_name.is_type = true;
-        output_expr->data.type_or_name.type = expr;
+        type_or_name.is_type = true;
+        type_or_name.type = expr;
     } else {
-        output_expr->data.type_or_name.is_type = false;
-        output_expr->data.type_or_name.name = Parser_expectIdentifier(p);
+        type_or_name.is_type = false;
+        type_or_name.name = Parser_expectIdentifier(p);
     }
     Parser_expect(p, token_r_paren);
 
+    Node *output_expr = Parser_allocNode(p);
+    output_expr->tag = node_type_or_name;
+    output_expr->data.type_or_name = type_or_name;
+    NodeIndex output = Parser_nodeIndex(p, output_expr);
+
     Node *n = Parser_allocNode(p);
     n->tag = node_asm_output_item;
     n->data.asm_output_item = (NodeDataAsmOutputItem){
         .name = name,
         .lit = lit,
-        .output_expr = output_expr,
+        .output_expr = output,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // AsmOutput <- COLON AsmOutputList AsmInput?
-static Node* Parser_parseAsmOutput(Parser *p)
+static NodeIndex Parser_parseAsmOutput(Parser *p)
 {
-    if (!Parser_eat(p, token_colon)) return NULL;
-    Node *asm_output_list = Parser_parseAsmOutputList(p);
+    Parser_trace(p);
+    if (!Parser_eat(p, token_colon)) return NODE_NONE;
+    NodeIndex asm_output_list = Parser_parseAsmOutputList(p);
     if (!asm_output_list) Parser_fail(p, "expected asm output list");
-    Node *asm_input = Parser_parseAsmInput(p);
+    NodeIndex asm_input = Parser_parseAsmInput(p);
 
     Node *n = Parser_allocNode(p);
     n->tag = node_asm_output;
@@ -2323,18 +3072,19 @@ static Node* Parser_parseAsmOutput(Parser *p)
         .asm_output_list = asm_output_list,
         .asm_input = asm_input,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // AsmExpr <- KEYWORD_asm KEYWORD_volatile? LPAREN Expr AsmOutput? RPAREN
-static Node* Parser_parseAsmExpr(Parser *p)
+static NodeIndex Parser_parseAsmExpr(Parser *p)
 {
-    if (!Parser_eat(p, token_keyword_asm)) return NULL;
+    Parser_trace(p);
+    if (!Parser_eat(p, token_keyword_asm)) return NODE_NONE;
     bool is_volatile = Parser_eat(p, token_keyword_volatile);
     Parser_expect(p, token_l_paren);
-    Node *expr = Parser_parseExpr(p);
+    NodeIndex expr = Parser_parseExpr(p);
     if (!expr) Parser_fail(p, "expected expression");
-    Node *asm_output = Parser_parseAsmOutput(p);
+    NodeIndex asm_output = Parser_parseAsmOutput(p);
     Parser_expect(p, token_r_paren);
 
     Node *n = Parser_allocNode(p);
@@ -2344,18 +3094,19 @@ static Node* Parser_parseAsmExpr(Parser *p)
         .expr = expr,
         .asm_output = asm_output,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // SwitchExpr <- KEYWORD_switch LPAREN Expr RPAREN LBRACE SwitchProngList RBRACE
-static Node* Parser_parseSwitchExpr(Parser *p)
+static NodeIndex Parser_parseSwitchExpr(Parser *p)
 {
-    if (!Parser_eat(p, token_keyword_switch)) return NULL;
+    Parser_trace(p);
+    if (!Parser_eat(p, token_keyword_switch)) return NODE_NONE;
     Parser_expect(p, token_l_paren);
-    Node *expr = Parser_parseExpr(p);
+    NodeIndex expr = Parser_parseExpr(p);
     Parser_expect(p, token_r_paren);
     Parser_expect(p, token_l_brace);
-    Node *switch_prong_list = Parser_parseSwitchProngList(p);
+    NodeIndex switch_prong_list = Parser_parseSwitchProngList(p);
     Parser_expect(p, token_r_brace);
 
     Node *n = Parser_allocNode(p);
@@ -2364,22 +3115,23 @@ static Node* Parser_parseSwitchExpr(Parser *p)
         .expr = expr,
         .switch_prong_list = switch_prong_list,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // WhileTypeExpr <- WhilePrefix TypeExpr (KEYWORD_else Payload? TypeExpr)?
-static Node* Parser_parseWhileTypeExpr(Parser *p)
+static NodeIndex Parser_parseWhileTypeExpr(Parser *p)
 {
-    uint32_t index = p->index;
+    Parser_trace(p);
+    ParserMark mark = Parser_mark(p);
 
-    Node *while_prefix = Parser_parseWhilePrefix(p);
+    NodeIndex while_prefix = Parser_parseWhilePrefix(p);
     if (!while_prefix) goto fail;
 
-    Node *type_expr = Parser_parseTypeExpr(p);
+    NodeIndex type_expr = Parser_parseTypeExpr(p);
     if (!type_expr) goto fail;
 
-    Buffer else_payload_name = Buffer_empty();
-    Node *else_payload_type_expr = NULL;
+    TokenIndex else_payload_name = TOKEN_NONE;
+    NodeIndex else_payload_type_expr = NODE_NONE;
     if (Parser_eat(p, token_keyword_else)) {
         else_payload_name = Parser_parsePayload(p);
         else_payload_type_expr = Parser_parseTypeExpr(p);
@@ -2393,22 +3145,22 @@ static Node* Parser_parseWhileTypeExpr(Parser *p)
         .else_payload_name = else_payload_name,
         .else_payload_type_expr = else_payload_type_expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // ForTypeExpr <- ForPrefix TypeExpr (KEYWORD_else TypeExpr)?
-static Node* Parser_parseForTypeExpr(Parser *p)
+static NodeIndex Parser_parseForTypeExpr(Parser *p)
 {
     Parser_trace(p);
-    Node *for_prefix = Parser_parseForPrefix(p);
-    if (!for_prefix) return NULL;
+    NodeIndex for_prefix = Parser_parseForPrefix(p);
+    if (!for_prefix) return NODE_NONE;
 
-    Node *expr = Parser_parseTypeExpr(p);
-    Node *else_expr = NULL;
+    NodeIndex expr = Parser_parseTypeExpr(p);
+    NodeIndex else_expr = NODE_NONE;
     if (Parser_eat(p, token_keyword_else)) {
         else_expr = Parser_parseTypeExpr(p);
     }
@@ -2420,14 +3172,14 @@ static Node* Parser_parseForTypeExpr(Parser *p)
         .expr = expr,
         .else_expr = else_expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // LoopTypeExpr <- KEYWORD_inline? (ForTypeExpr / WhileTypeExpr)
-static Node* Parser_parseLoopTypeExpr(Parser *p)
+static NodeIndex Parser_parseLoopTypeExpr(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
     bool is_inline = Parser_eat(p, token_keyword_inline);
     (void)is_inline;
@@ -2437,25 +3189,25 @@ static Node* Parser_parseLoopTypeExpr(Parser *p)
         return Parser_parseWhileTypeExpr(p); // TODO: inline
     }
 
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
-static Node* Parser_parseBlock(Parser *p);
-static Node* Parser_parseSwitchExpr(Parser *p);
+static NodeIndex Parser_parseBlock(Parser *p);
+static NodeIndex Parser_parseSwitchExpr(Parser *p);
 // LabeledTypeExpr
 //     <- BlockLabel Block
 //      / BlockLabel? LoopTypeExpr
 //      / BlockLabel? SwitchExpr
-static Node* Parser_parseLabeledTypeExpr(Parser *p)
+static NodeIndex Parser_parseLabeledTypeExpr(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
-    Buffer label = Parser_parseBlockLabel(p);
+    TokenIndex label = Parser_parseBlockLabel(p);
 
     if (Parser_peek(p, token_l_brace)) {
-        Node *block = Parser_parseBlock(p);
+        NodeIndex block = Parser_parseBlock(p);
         if (!block) goto fail;
         Node *n = Parser_allocNode(p);
         n->tag = node_labeled_block;
@@ -2463,11 +3215,11 @@ static Node* Parser_parseLabeledTypeExpr(Parser *p)
             .label = label,
             .node = block,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_peek(p, token_keyword_inline)
         || Parser_peek(p, token_keyword_for)
         || Parser_peek(p, token_keyword_while)) {
-        Node *loop_type_expr = Parser_parseLoopTypeExpr(p);
+        NodeIndex loop_type_expr = Parser_parseLoopTypeExpr(p);
         if (loop_type_expr) goto fail;
 
         Node *n = Parser_allocNode(p);
@@ -2476,9 +3228,9 @@ static Node* Parser_parseLabeledTypeExpr(Parser *p)
             .label = label,
             .node = loop_type_expr,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_peek(p, token_keyword_switch)) {
-        Node *switch_expr = Parser_parseSwitchExpr(p);
+        NodeIndex switch_expr = Parser_parseSwitchExpr(p);
         if (!switch_expr) goto fail;
 
         Node *n = Parser_allocNode(p);
@@ -2487,27 +3239,28 @@ static Node* Parser_parseLabeledTypeExpr(Parser *p)
             .label = label,
             .node = switch_expr,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // IfTypeExpr <- IfPrefix TypeExpr (KEYWORD_else Payload? TypeExpr)?
-static Node* Parser_parseIfTypeExpr(Parser *p)
+static NodeIndex Parser_parseIfTypeExpr(Parser *p)
 {
-    uint32_t index = p->index;
+    Parser_trace(p);
+    ParserMark mark = Parser_mark(p);
 
-    Node *if_prefix = Parser_parseIfPrefix(p);
+    NodeIndex if_prefix = Parser_parseIfPrefix(p);
     if (!if_prefix) goto fail;
 
-    Node *type_expr = Parser_parseTypeExpr(p);
+    NodeIndex type_expr = Parser_parseTypeExpr(p);
     if (!type_expr) goto fail;
 
-    Buffer else_payload_name = Buffer_empty();
-    Node *else_payload_type_expr = NULL;
+    TokenIndex else_payload_name = TOKEN_NONE;
+    NodeIndex else_payload_type_expr = NODE_NONE;
     if (Parser_eat(p, token_keyword_else)) {
         else_payload_name = Parser_parsePayload(p);
         else_payload_type_expr = Parser_parseTypeExpr(p);
@@ -2521,58 +3274,58 @@ static Node* Parser_parseIfTypeExpr(Parser *p)
         .else_payload_name = else_payload_name,
         .else_payload_type_expr = else_payload_type_expr,
     };
-    return n;;
+    return Parser_nodeIndex(p, n);;
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
-static Node* Parser_parseExpr(Parser *p);
+static NodeIndex Parser_parseExpr(Parser *p);
 // GroupedExpr <- LPAREN Expr RPAREN
-static Node* Parser_parseGroupedExpr(Parser *p)
+static NodeIndex Parser_parseGroupedExpr(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
     if (!Parser_eat(p, token_l_paren)) goto fail;
-    Node *n = Parser_parseExpr(p);
-    if (!n) return NULL;
+    NodeIndex n = Parser_parseExpr(p);
+    if (!n) return NODE_NONE;
     Parser_expect(p, token_r_paren);
     return n;
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // ErrorSetDecl <- KEYWORD_error LBRACE IdentifierList RBRACE
-static Node* Parser_parseErrorSetDecl(Parser *p)
+static NodeIndex Parser_parseErrorSetDecl(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
     if (!Parser_eat(p, token_keyword_error)) goto fail;
     if (!Parser_eat(p, token_l_brace)) goto fail;
-    Node *n = Parser_parseIdentifierList(p);
+    NodeIndex n = Parser_parseIdentifierList(p);
     if (!n) goto fail;
     Parser_expect(p, token_r_brace);
     return n;
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // ContainerDecl <- (KEYWORD_extern / KEYWORD_packed)? ContainerDeclAuto
-static Node* Parser_parseContainerDecl(Parser *p)
+static NodeIndex Parser_parseContainerDecl(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
     bool is_extern = Parser_eat(p, token_keyword_extern);
     bool is_packed = Parser_eat(p, token_keyword_packed);
-    Node *container_decl = Parser_parseContainerDeclAuto(p);
+    NodeIndex container_decl = Parser_parseContainerDeclAuto(p);
     if (!container_decl) goto fail;
 
     Node *n = Parser_allocNode(p);
@@ -2582,15 +3335,15 @@ static Node* Parser_parseContainerDecl(Parser *p)
         .is_packed = is_packed,
         .container_decl = container_decl,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
-static Node* Parser_parseInitList(Parser *p);
-static Node* Parser_expectFnProto(Parser *p);
+static NodeIndex Parser_parseInitList(Parser *p);
+static NodeIndex Parser_expectFnProto(Parser *p);
 // PrimaryTypeExpr
 //     <- BUILTINIDENTIFIER FnCallArguments
 //      / CHAR_LITERAL
@@ -2610,19 +3363,19 @@ static Node* Parser_expectFnProto(Parser *p);
 //      / KEYWORD_anyframe
 //      / KEYWORD_unreachable
 //      / STRINGLITERAL
-static Node* Parser_parsePrimaryTypeExpr(Parser *p)
+static NodeIndex Parser_parsePrimaryTypeExpr0(Parser *p)
 {
     Parser_trace(p);
-    NodeDataPrimaryTypeExpr expr;
-    Token tok = p->tokens[p->index];
-    Buffer raw = Buffer_slice(p->source, tok.loc.start, tok.loc.end);
+    NodeDataPrimaryTypeExpr expr = { 0 };
+    uint32_t token = p->index;
+    if (!Parser_peekFirst(p, first_PrimaryTypeExpr)) return NODE_NONE;
 
     if (Parser_eat(p, token_builtin)) {
-        Node *args = Parser_parseFnCallArguments(p);
+        NodeIndex args = Parser_parseFnCallArguments(p);
         expr.tag = node_primary_type_builtin;
         expr.data = (NodePrimaryTypeData){
             .builtin = (NodePrimaryTypeDataBuiltin){
-                .name = raw,
+                .name = token,
                 .args = args,
             },
         };
@@ -2630,47 +3383,47 @@ static Node* Parser_parsePrimaryTypeExpr(Parser *p)
     }
     if (Parser_eat(p, token_char_literal)) {
         expr.tag = node_primary_type_char_literal;
-        expr.data = (NodePrimaryTypeData){ .raw = raw };
+        expr.data = (NodePrimaryTypeData){ .raw = token };
         goto done;
     }
-    Node *container_decl = Parser_parseContainerDecl(p);
+    NodeIndex container_decl = Parser_peekFirst(p, first_ContainerDecl) ? Parser_parseContainerDecl(p) : NODE_NONE;
     if (container_decl) {
         expr.tag = node_primary_type_container_decl;
         expr.data = (NodePrimaryTypeData){ .node = container_decl };
         goto done;
     }
     if (Parser_eat(p, token_period)) {
-        raw = Parser_eatIdentifier(p);
-        if (raw.len != 0) {
+        TokenIndex raw = Parser_eatIdentifier(p);
+        if (raw != TOKEN_NONE) {
             expr.tag = node_primary_type_dot_identifier;
             expr.data = (NodePrimaryTypeData){ .raw = raw };
             goto done;
         }
-        Node *initlist = Parser_parseInitList(p);
+        NodeIndex initlist = Parser_parseInitList(p);
         if (!initlist) Parser_fail(p, "expected initlist");
         expr.tag = node_primary_type_dot_initlist;
         expr.data = (NodePrimaryTypeData){ .node = initlist };
         goto done;
     }
-    Node *error_set_decl = Parser_parseErrorSetDecl(p);
+    NodeIndex error_set_decl = Parser_peekFirst(p, first_ErrorSetDecl) ? Parser_parseErrorSetDecl(p) : NODE_NONE;
     if (error_set_decl) {
         expr.tag = node_primary_type_error_set_decl;
         expr.data = (NodePrimaryTypeData){ .node = error_set_decl };
         goto done;
     }
     if (Parser_peek(p, token_keyword_fn)) {
-        Node *fn_proto = Parser_expectFnProto(p);
+        NodeIndex fn_proto = Parser_expectFnProto(p);
         expr.tag = node_primary_type_fn_proto;
         expr.data = (NodePrimaryTypeData){ .node = fn_proto };
         goto done;
     }
-    Node *grouped_expr = Parser_parseGroupedExpr(p);
+    NodeIndex grouped_expr = Parser_peekFirst(p, first_GroupedExpr) ? Parser_parseGroupedExpr(p) : NODE_NONE;
     if (grouped_expr) {
         expr.tag = node_primary_type_grouped_expr;
         expr.data = (NodePrimaryTypeData){ .node = grouped_expr };
         goto done;
     }
-    Node *labeled_type_expr = Parser_parseLabeledTypeExpr(p);
+    NodeIndex labeled_type_expr = Parser_peekFirst(p, first_LabeledTypeExpr) ? Parser_parseLabeledTypeExpr(p) : NODE_NONE;
     if (labeled_type_expr) {
         expr.tag = node_primary_type_labeled_type_expr;
         expr.data = (NodePrimaryTypeData){ .node = labeled_type_expr };
@@ -2678,10 +3431,10 @@ static Node* Parser_parsePrimaryTypeExpr(Parser *p)
     }
     if (Parser_eat(p, token_identifier)) {
         expr.tag = node_primary_type_identifier;
-        expr.data = (NodePrimaryTypeData){ .raw = raw };
+        expr.data = (NodePrimaryTypeData){ .raw = token };
         goto done;
     }
-    Node *if_type_expr = Parser_parseIfTypeExpr(p);
+    NodeIndex if_type_expr = Parser_peekFirst(p, first_IfTypeExpr) ? Parser_parseIfTypeExpr(p) : NODE_NONE;
     if (if_type_expr) {
         expr.tag = node_primary_type_if_type_expr;
         expr.data = (NodePrimaryTypeData){ .node = if_type_expr };
@@ -2689,18 +3442,18 @@ static Node* Parser_parsePrimaryTypeExpr(Parser *p)
     }
     if (Parser_eat(p, token_number_literal)) {
         expr.tag = node_primary_type_number_literal;
-        expr.data = (NodePrimaryTypeData){ .raw = raw };
+        expr.data = (NodePrimaryTypeData){ .raw = token };
         goto done;
     }
     if (Parser_eat(p, token_keyword_comptime)) {
-        Node *type_expr = Parser_parseTypeExpr(p);
+        NodeIndex type_expr = Parser_parseTypeExpr(p);
         expr.tag = node_primary_type_comptime_type_expr;
         expr.data = (NodePrimaryTypeData){ .node = type_expr };
         goto done;
     }
     if (Parser_eat(p, token_keyword_error)) {
         Parser_expect(p, token_period);
-        Buffer raw = Parser_expectIdentifier(p);
+        TokenIndex raw = Parser_expectIdentifier(p);
         expr.tag = node_primary_type_error;
         expr.data = (NodePrimaryTypeData){ .raw = raw };
         goto done;
@@ -2715,7 +3468,7 @@ static Node* Parser_parsePrimaryTypeExpr(Parser *p)
     }
     if (Parser_eat(p, token_string_literal)) {
         expr.tag = node_primary_type_string_literal;
-        expr.data = (NodePrimaryTypeData){ .raw = raw };
+        expr.data = (NodePrimaryTypeData){ .raw = token };
         goto done;
     }
     // TODO: could merge multiline literals.
@@ -2724,66 +3477,73 @@ static Node* Parser_parsePrimaryTypeExpr(Parser *p)
         while (Parser_eat(p, token_multiline_string_literal_line)) {}
 
         expr.tag = node_primary_type_string_literal;
-        expr.data = (NodePrimaryTypeData){ .raw = raw };
+        expr.data = (NodePrimaryTypeData){ .raw = token };
         goto done;
     }
 
-    return NULL;
+    return NODE_NONE;
 
     Node *n;
 done:
     n = Parser_allocNode(p);
     n->tag = node_primary_type_expr;
     n->data.primary_type_expr = expr;
-    return n;
+    return Parser_nodeIndex(p, n);
+}
+
+static NodeIndex Parser_parsePrimaryTypeExpr(Parser *p)
+{
+    NodeIndex n;
+    if (Parser_memoGet(p, parser_rule_primary_type_expr, &n)) return n;
+    uint32_t start = p->index;
+    return Parser_memoPut(p, parser_rule_primary_type_expr, start, Parser_parsePrimaryTypeExpr0(p));
 }
 
 // SuffixExpr
 //     <- PrimaryTypeExpr (SuffixOp / FnCallArguments)*
-static Node* Parser_parseSuffixExpr(Parser *p)
+static NodeIndex Parser_parseSuffixExpr(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
-    Node *primary_type_expr = Parser_parsePrimaryTypeExpr(p);
+    NodeIndex primary_type_expr = Parser_parsePrimaryTypeExpr(p);
     if (!primary_type_expr) goto fail;
 
-    NodeArray a;
-    NodeArray_init(&a);
+    ParserList a = Parser_startList(p);
 
-    int c = 0;
-    while (c++ < LOOP_MAX) {
-        Node *suffix = Parser_parseSuffixOp(p);
-        if (!suffix) suffix = Parser_parseFnCallArguments(p);
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at)) {
+        NodeIndex suffix = NODE_NONE;
+        if (Parser_peekFirst(p, first_SuffixOp)) suffix = Parser_parseSuffixOp(p);
+        if (!suffix && Parser_peekFirst(p, first_FnCallArguments)) suffix = Parser_parseFnCallArguments(p);
         if (!suffix) break;
-        NodeArray_append(&a, suffix);
+        Parser_listAppend(p, &a, suffix);
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
 
     Node *n = Parser_allocNode(p);
     n->tag = node_suffix_expr;
     n->data.suffix_expr = (NodeDataSuffixExpr){
         .expr = primary_type_expr,
-        .suffixes = a.data,
+        .suffixes = Parser_finishList(p, &a),
         .suffixes_len = a.len,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // ErrorUnionExpr <- SuffixExpr (EXCLAMATIONMARK TypeExpr)?
-static Node* Parser_parseErrorUnionExpr(Parser *p)
+static NodeIndex Parser_parseErrorUnionExpr(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
-    Node *suffix_expr = Parser_parseSuffixExpr(p);
+    NodeIndex suffix_expr = Parser_parseSuffixExpr(p);
     if (!suffix_expr) goto fail;
 
-    Node *error_type_expr = NULL;
+    NodeIndex error_type_expr = NODE_NONE;
     if (Parser_eat(p, token_bang)) {
         error_type_expr = Parser_parseTypeExpr(p);
     }
@@ -2794,92 +3554,95 @@ static Node* Parser_parseErrorUnionExpr(Parser *p)
         .suffix_expr = suffix_expr,
         .error_type_expr = error_type_expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // TypeExpr <- PrefixTypeOp* ErrorUnionExpr
-static Node* Parser_parseTypeExpr(Parser *p)
+static NodeIndex Parser_parseTypeExpr0(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
-    NodeArray a;
-    NodeArray_init(&a);
+    ParserList a = Parser_startList(p);
 
-    int c = 0;
-    while (c++ < LOOP_MAX) {
-        Node *prefix_type_op = Parser_parsePrefixTypeOp(p);
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at) && Parser_peekFirst(p, first_PrefixTypeOp)) {
+        NodeIndex prefix_type_op = Parser_parsePrefixTypeOp(p);
         if (!prefix_type_op) break;
-        NodeArray_append(&a, prefix_type_op);
+        Parser_listAppend(p, &a, prefix_type_op);
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
 
-    Node *error_union_expr = Parser_parseErrorUnionExpr(p);
+    NodeIndex error_union_expr = Parser_parseErrorUnionExpr(p);
     if (!error_union_expr) goto fail;
 
     Node *n = Parser_allocNode(p);
     n->tag = node_type_expr;
     n->data.type_expr = (NodeDataTypeExpr){
-        .prefix_type_ops = a.data,
+        .prefix_type_ops = Parser_finishList(p, &a),
         .prefix_type_ops_len = a.len,
         .type_expr = error_union_expr
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
+}
+
+static NodeIndex Parser_parseTypeExpr(Parser *p)
+{
+    NodeIndex n;
+    if (Parser_memoGet(p, parser_rule_type_expr, &n)) return n;
+    uint32_t start = p->index;
+    return Parser_memoPut(p, parser_rule_type_expr, start, Parser_parseTypeExpr0(p));
 }
 
 // InitList
 //     <- LBRACE FieldInit (COMMA FieldInit)* COMMA? RBRACE
 //      / LBRACE Expr (COMMA Expr)* COMMA? RBRACE
 //      / LBRACE RBRACE
-static Node* Parser_parseInitList(Parser *p)
+static NodeIndex Parser_parseInitList(Parser *p)
 {
     Parser_trace(p);
-    if (!Parser_eat(p, token_l_brace)) return NULL;
+    if (!Parser_eat(p, token_l_brace)) return NODE_NONE;
 
     if (Parser_eat(p, token_r_brace)) {
         Node *n = Parser_allocNode(p);
         n->tag = node_init_list_empty;
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
-    NodeArray a;
-    NodeArray_init(&a);
+    ParserList a = Parser_startList(p);
     NodeTag tag = node_invalid;
 
-    Node *field_init = Parser_parseFieldInit(p);
+    NodeIndex field_init = Parser_parseFieldInit(p);
     if (field_init) {
         tag = node_init_list_field;
-        NodeArray_append(&a, field_init);
+        Parser_listAppend(p, &a, field_init);
 
-        int c = 0;
-        while (c++ < LOOP_MAX && Parser_eat(p, token_comma)) {
-            Node *field_init = Parser_parseFieldInit(p);
+        uint32_t at = TOKEN_NONE;
+        while (Parser_progress(p, &at) && Parser_eat(p, token_comma)) {
+            NodeIndex field_init = Parser_parseFieldInit(p);
             if (!field_init) break;
-            NodeArray_append(&a, field_init);
+            Parser_listAppend(p, &a, field_init);
         }
-        if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
     }
 
-    Node *expr = Parser_parseExpr(p);
+    NodeIndex expr = Parser_parseExpr(p);
     if (expr) {
         tag = node_init_list_expr;
-        NodeArray_append(&a, expr);
+        Parser_listAppend(p, &a, expr);
 
-        int c = 0;
-        while (c++ < LOOP_MAX && Parser_eat(p, token_comma)) {
-            Node *expr = Parser_parseExpr(p);
+        uint32_t at = TOKEN_NONE;
+        while (Parser_progress(p, &at) && Parser_eat(p, token_comma)) {
+            NodeIndex expr = Parser_parseExpr(p);
             if (!expr) break;
-            NodeArray_append(&a, expr);
+            Parser_listAppend(p, &a, expr);
         }
-        if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
     }
 
     if (tag == node_invalid) Parser_fail(p, "expected field_init or expr in init list");
@@ -2890,19 +3653,19 @@ static Node* Parser_parseInitList(Parser *p)
     Node *n = Parser_allocNode(p);
     n->tag = tag;
     n->data.init_list_expr = (NodeDataInitList){
-        .nodes = a.data,
+        .nodes = Parser_finishList(p, &a),
         .nodes_len = a.len,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // CurlySuffixExpr <- TypeExpr InitList?
-static Node* Parser_parseCurlySuffixExpr(Parser *p)
+static NodeIndex Parser_parseCurlySuffixExpr(Parser *p)
 {
     Parser_trace(p);
-    Node *type = Parser_parseTypeExpr(p);
-    if (!type) return NULL;
-    Node *initlist = Parser_parseInitList(p);
+    NodeIndex type = Parser_parseTypeExpr(p);
+    if (!type) return NODE_NONE;
+    NodeIndex initlist = Parser_parseInitList(p);
     if (!initlist) return type;
 
     Node *n = Parser_allocNode(p);
@@ -2911,21 +3674,21 @@ static Node* Parser_parseCurlySuffixExpr(Parser *p)
         .type = type,
         .initlist = initlist,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // WhileExpr <- WhilePrefix Expr (KEYWORD_else Payload? Expr)?
-static Node* Parser_parseWhileExpr(Parser *p)
+static NodeIndex Parser_parseWhileExpr(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
-    Node *while_expr = Parser_parseWhilePrefix(p);
+    NodeIndex while_expr = Parser_parseWhilePrefix(p);
     if (!while_expr) goto fail;
-    Node *expr = Parser_parseExpr(p);
+    NodeIndex expr = Parser_parseExpr(p);
     if (!expr) goto fail;
-    Buffer else_payload_name = Buffer_empty();
-    Node *else_expr = NULL;
+    TokenIndex else_payload_name = TOKEN_NONE;
+    NodeIndex else_expr = NODE_NONE;
     if (Parser_eat(p, token_keyword_else)) {
         else_payload_name = Parser_parsePayload(p);
         else_expr = Parser_parseExpr(p);
@@ -2939,24 +3702,24 @@ static Node* Parser_parseWhileExpr(Parser *p)
         .else_payload_name = else_payload_name,
         .else_expr = else_expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // ForExpr <- ForPrefix Expr (KEYWORD_else Expr)?
-static Node* Parser_parseForExpr(Parser *p)
+static NodeIndex Parser_parseForExpr(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
-    Node *for_prefix = Parser_parseForPrefix(p);
+    NodeIndex for_prefix = Parser_parseForPrefix(p);
     if (!for_prefix) goto fail;
-    Node *expr = Parser_parseExpr(p);
+    NodeIndex expr = Parser_parseExpr(p);
     if (!expr) goto fail;
-    Node *else_expr = NULL;
+    NodeIndex else_expr = NODE_NONE;
     if (Parser_eat(p, token_keyword_else)) {
         else_expr = Parser_parseExpr(p);
     }
@@ -2968,67 +3731,104 @@ static Node* Parser_parseForExpr(Parser *p)
         .expr = expr,
         .else_expr = else_expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // LoopExpr <- KEYWORD_inline? (ForExpr / WhileExpr)
-static Node* Parser_parseLoopExpr(Parser *p)
+static NodeIndex Parser_parseLoopExpr(Parser *p)
 {
     Parser_trace(p);
     bool is_inline = Parser_eat(p, token_keyword_inline);
     (void)is_inline;    // TODO
 
-    Node *for_expr = Parser_parseForExpr(p);
+    NodeIndex for_expr = Parser_parseForExpr(p);
     if (for_expr) return for_expr;
 
-    Node *while_expr = Parser_parseWhileExpr(p);
+    NodeIndex while_expr = Parser_parseWhileExpr(p);
     if (while_expr) return while_expr;
 
-    return NULL;
+    return NODE_NONE;
 }
 
-static Node* Parser_parseStatement(Parser *p);
+static NodeIndex Parser_parseStatement(Parser *p);
 // Block <- LBRACE Statement* RBRACE
-static Node* Parser_parseBlock(Parser *p)
+static NodeIndex Parser_parseBlock(Parser *p)
 {
     Parser_trace(p);
-    if (!Parser_eat(p, token_l_brace)) return NULL;
+    if (!Parser_eat(p, token_l_brace)) return NODE_NONE;
 
-    NodeArray a;
-    NodeArray_init(&a);
+    ParserList a = Parser_startList(p);
 
-    int c = 0;
-    while (c++ < LOOP_MAX && !Parser_peek(p, token_r_brace)) {
-        Node *n = Parser_parseStatement(p);
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at) && !Parser_peek(p, token_r_brace)) {
+        NodeIndex n = Parser_parseStatement(p);
         if (!n) break;
-        NodeArray_append(&a, n);
+        Parser_listAppend(p, &a, n);
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
     Parser_expect(p, token_r_brace);
 
     Node *n = Parser_allocNode(p);
     n->tag = node_block;
     n->data.block = (NodeDataBlock){
-        .statements = a.data,
+        .statements = Parser_finishList(p, &a),
         .statements_len = a.len,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
+}
+
+// In lazy mode a function body is not parsed, only its token range is recorded. The matching
+// brace is known from the tokenizer so skipping it is O(1).
+static NodeIndex Parser_skipBlock(Parser *p)
+{
+    Parser_trace(p);
+    if (!Parser_peek(p, token_l_brace)) return NODE_NONE;
+
+    TokenIndex l_brace = p->index;
+    TokenIndex r_brace = TokenStream_matchBrace(p->stream, l_brace);
+    if (r_brace == TOKEN_MATCH_NONE) return Parser_parseBlock(p); // unbalanced, report it as usual
+    Parser_fill(p, r_brace + 1);
+    p->index = r_brace + 1;
+
+    Node *n = Parser_allocNode(p);
+    n->tag = node_lazy_block;
+    n->data.lazy_block = (NodeDataLazyBlock){
+        .l_brace = l_brace,
+        .r_brace = r_brace,
+    };
+    return Parser_nodeIndex(p, n);
+}
+
+// Parse a body skipped by Parser_skipBlock. The lazy node is overwritten with the block, so
+// anything referring to it sees a node_block afterwards.
+static void Parser_parseLazyBlock(Parser *p, NodeIndex index)
+{
+    NodeDataLazyBlock lazy = Ast_node(&p->ast, index)->data.lazy_block;
+    uint32_t saved = p->index;
+    p->index = lazy.l_brace;
+
+    NodeIndex block = Parser_parseBlock(p);
+    assume(block == p->ast.nodes.len - 1 && p->index == lazy.r_brace + 1);
+    p->ast.nodes.data[index] = p->ast.nodes.data[block];
+    p->ast.nodes.len--;
+
+    p->index = saved;
+    p->lazy_parsed++;
 }
 
 // IfExpr <- IfPrefix Expr (KEYWORD_else Payload? Expr)?
-static Node* Parser_parseIfExpr(Parser *p)
+static NodeIndex Parser_parseIfExpr(Parser *p)
 {
     Parser_trace(p);
-    Node *if_prefix = Parser_parseIfPrefix(p);
-    if (!if_prefix) return NULL;
-    Node *expr = Parser_parseExpr(p);
+    NodeIndex if_prefix = Parser_parseIfPrefix(p);
+    if (!if_prefix) return NODE_NONE;
+    NodeIndex expr = Parser_parseExpr(p);
     if (!expr) Parser_fail(p, "expected expression");
-    Buffer else_payload_name = Buffer_empty();
-    Node *else_payload_expr = NULL;
+    TokenIndex else_payload_name = TOKEN_NONE;
+    NodeIndex else_payload_expr = NODE_NONE;
 
     if (Parser_eat(p, token_keyword_else)) {
         else_payload_name = Parser_parsePayload(p);
@@ -3044,10 +3844,10 @@ static Node* Parser_parseIfExpr(Parser *p)
         .else_payload_name = else_payload_name,
         .else_payload_expr = else_payload_expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
-static Node* Parser_parseExpr(Parser *p);
+static NodeIndex Parser_parseExpr(Parser *p);
 // PrimaryExpr
 //     <- AsmExpr
 //      / IfExpr
@@ -3060,81 +3860,79 @@ static Node* Parser_parseExpr(Parser *p);
 //      / BlockLabel? LoopExpr
 //      / Block
 //      / CurlySuffixExpr
-static Node* Parser_parsePrimaryExpr(Parser *p)
+static NodeIndex Parser_parsePrimaryExpr(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
     if (Parser_peek(p, token_keyword_asm)) {
         return Parser_parseAsmExpr(p);
     } else if (Parser_peek(p, token_keyword_if)) {
         return Parser_parseIfExpr(p);
     } else if (Parser_eat(p, token_keyword_break)) {
-        Buffer label = Parser_parseBreakLabel(p);
-        Node *expr = Parser_parseExpr(p);
+        TokenIndex label = Parser_parseBreakLabel(p);
+        NodeIndex expr = Parser_parseExpr(p);
         Node *n = Parser_allocNode(p);
         n->tag = node_break_expr;
         n->data.break_expr = (NodeDataBreakExpr){
             .label = label,
             .expr = expr,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_keyword_comptime)) {
-        Node *expr = Parser_parseExpr(p);
+        NodeIndex expr = Parser_parseExpr(p);
         if (!expr) Parser_fail(p, "expected expression after comptime keyword");
         Node *n = Parser_allocNode(p);
         n->tag = node_comptime_expr;
         n->data.comptime_expr = expr;
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_keyword_nosuspend)) {
-        Node *expr = Parser_parseExpr(p);
+        NodeIndex expr = Parser_parseExpr(p);
         if (!expr) Parser_fail(p, "expected expression after nosuspend keyword");
         Node *n = Parser_allocNode(p);
         n->data.comptime_expr = expr;
         n->tag = node_nosuspend_expr;
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_keyword_continue)) {
-        Buffer label = Parser_parseBreakLabel(p);
-        Node *expr = Parser_parseExpr(p);
+        TokenIndex label = Parser_parseBreakLabel(p);
+        NodeIndex expr = Parser_parseExpr(p);
         Node *n = Parser_allocNode(p);
         n->tag = node_continue_expr;
         n->data.continue_expr = (NodeDataContinueExpr){
             .label = label,
             .expr = expr,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_keyword_resume)) {
-        Node *expr = Parser_parseExpr(p);
+        NodeIndex expr = Parser_parseExpr(p);
         if (!expr) Parser_fail(p, "expected expression after resume keyword");
         Node *n = Parser_allocNode(p);
         n->tag = node_resume_expr;
         n->data.resume_expr = expr;
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_keyword_return)) {
-        Node *expr = Parser_parseExpr(p);
+        NodeIndex expr = Parser_parseExpr(p);
         Node *n = Parser_allocNode(p);
         n->tag = node_return_expr;
         n->data.return_expr = expr;
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
-    int c = 0;
-    while (c++ < LOOP_MAX) {
-        Buffer label = Parser_parseBlockLabel(p);
-        Node *loop_expr = Parser_parseLoopExpr(p);
-        if (!loop_expr) break;
-
-        Node *n = Parser_allocNode(p);
-        n->tag = node_loop_expr;
-        n->data.loop_expr = (NodeDataLoopExpr) {
-            .label = label,
-            .loop_expr = loop_expr,
-        };
-        return n;
+    if (Parser_peek(p, token_identifier) || Parser_peekFirst(p, first_LoopExpr)) {
+        TokenIndex label = Parser_parseBlockLabel(p);
+        NodeIndex loop_expr = Parser_parseLoopExpr(p);
+        if (loop_expr) {
+            Node *n = Parser_allocNode(p);
+            n->tag = node_loop_expr;
+            n->data.loop_expr = (NodeDataLoopExpr) {
+                .label = label,
+                .loop_expr = loop_expr,
+            };
+            return Parser_nodeIndex(p, n);
+        }
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
 
-    p->index = index; // reset possible block label (may not be needed)
+    Parser_reset(p, mark); // reset possible block label (may not be needed)
 
     if (Parser_peek(p, token_l_brace)) {
         return Parser_parseBlock(p);
@@ -3144,37 +3942,35 @@ static Node* Parser_parsePrimaryExpr(Parser *p)
 }
 
 // PrefixExpr <- PrefixOp* PrimaryExpr
-static Node* Parser_parsePrefixExpr(Parser *p)
+static NodeIndex Parser_parsePrefixExpr(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
-    TokenTagArray a;
-    TokenTagArray_init(&a);
+    ParserList a = Parser_startList(p);
 
-    int c = 0;
-    while (c++ < LOOP_MAX) {
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at)) {
         TokenTag prefixOp = Parser_eatPrefixOp(p);
         if (prefixOp == token_invalid) break;
-        TokenTagArray_append(&a, prefixOp);
+        Parser_listAppend(p, &a, prefixOp);
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
 
-    Node *expr = Parser_parsePrimaryExpr(p);
+    NodeIndex expr = Parser_parsePrimaryExpr(p);
     if (!expr) goto fail;
 
     Node *n = Parser_allocNode(p);
     n->tag = node_unary_expr;
     n->data.unary_expr = (NodeDataUnaryExpr){
-        .ops = a.data,
+        .ops = Parser_finishList(p, &a),
         .ops_len = a.len,
         .expr = expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // x() x[] x.y x.* x.?
@@ -3189,164 +3985,109 @@ fail:
 // and
 // or
 // = *= *%= *|= /= %= += +%= +|= -= -%= -|= <<= <<|= >>= &= ^= |=
-static int Parser_binOpPrecedence(BinOp op)
-{
-    switch (op) {
-        case binop_or:
-            return 2;
-        case binop_and:
-            return 3;
-        case binop_eq:
-        case binop_neq:
-        case binop_lt:
-        case binop_gt:
-        case binop_lt_eq:
-        case binop_gt_eq:
-            return 4;
-        case binop_bit_and:
-        case binop_bit_or:
-        case binop_bit_xor:
-        case binop_orelse:
-        case binop_catch:
-            return 5;
-        case binop_shl:
-        case binop_shr:
-        case binop_shl_saturate:
-            return 6;
-        case binop_add:
-        case binop_add_wrap:
-        case binop_add_saturate:
-        case binop_sub:
-        case binop_sub_wrap:
-        case binop_sub_saturate:
-        case binop_array_concat:
-            return 7;
-        case binop_mul:
-        case binop_mul_wrap:
-        case binop_mul_saturate:
-        case binop_div:
-        case binop_mod:
-        case binop_array_spread:
-        case binop_error_set_merge:
-            return 8;
-
-        case binop_invalid:
-            assume(false);
-            return -1;
-    }
-}
+//
+// Binary operators by token (excluding assignment operators). A precedence of 0 marks a token
+// that is not a binary operator.
+typedef struct BinOpInfo {
+    uint8_t op;     // BinOp
+    uint8_t prec;
+} BinOpInfo;
+
+#define BINOP_PREC_MAX 8
+
+static const BinOpInfo binop_infos[token_keyword_while + 1] = {
+    [token_keyword_or]                          = { binop_or, 2 },
+    [token_keyword_and]                         = { binop_and, 3 },
+    [token_equal_equal]                         = { binop_eq, 4 },
+    [token_bang_equal]                          = { binop_neq, 4 },
+    [token_angle_bracket_left]                  = { binop_lt, 4 },
+    [token_angle_bracket_right]                 = { binop_gt, 4 },
+    [token_angle_bracket_left_equal]            = { binop_lt_eq, 4 },
+    [token_angle_bracket_right_equal]           = { binop_gt_eq, 4 },
+    [token_ampersand]                           = { binop_bit_and, 5 },
+    [token_pipe]                                = { binop_bit_or, 5 },
+    [token_caret]                               = { binop_bit_xor, 5 },
+    [token_keyword_orelse]                      = { binop_orelse, 5 },
+    [token_keyword_catch]                       = { binop_catch, 5 },
+    [token_angle_bracket_angle_bracket_left]    = { binop_shl, 6 },
+    [token_angle_bracket_angle_bracket_right]   = { binop_shr, 6 },
+    [token_angle_bracket_angle_bracket_left_pipe] = { binop_shl_saturate, 6 },
+    [token_plus]                                = { binop_add, 7 },
+    [token_plus_percent]                        = { binop_add_wrap, 7 },
+    [token_plus_pipe]                           = { binop_add_saturate, 7 },
+    [token_minus]                               = { binop_sub, 7 },
+    [token_minus_percent]                       = { binop_sub_wrap, 7 },
+    [token_minus_pipe]                          = { binop_sub_saturate, 7 },
+    [token_plus_plus]                           = { binop_array_concat, 7 },
+    [token_asterisk]                            = { binop_mul, 8 },
+    [token_asterisk_percent]                    = { binop_mul_wrap, 8 },
+    [token_asterisk_pipe]                       = { binop_mul_saturate, 8 },
+    [token_slash]                               = { binop_div, 8 },
+    [token_percent]                             = { binop_mod, 8 },
+    [token_asterisk_asterisk]                   = { binop_array_spread, 8 },
+    [token_pipe_pipe]                           = { binop_error_set_merge, 8 },
+};
 
-// Peek a binary op (excluding assignment operators)
-static BinOp Parser_peekBinOp(Parser *p)
-{
-    Parser_trace(p);
-    switch (p->tokens[p->index].tag) {
-        case token_keyword_or:
-            return binop_or;
-        case token_keyword_and:
-            return binop_and;
-        case token_equal_equal:
-            return binop_eq;
-        case token_bang_equal:
-            return binop_neq;
-        case token_angle_bracket_left:
-            return binop_lt;
-        case token_angle_bracket_right:
-            return binop_gt;
-        case token_angle_bracket_left_equal:
-            return binop_lt_eq;
-        case token_angle_bracket_right_equal:
-            return binop_gt_eq;
-        case token_ampersand:
-            return binop_bit_and;
-        case token_pipe:
-            return binop_bit_or;
-        case token_caret:
-            return binop_bit_xor;
-        case token_keyword_orelse:
-            return binop_orelse;
-        case token_keyword_catch:
-            return binop_catch;
-        case token_angle_bracket_angle_bracket_left:
-            return binop_shl;
-        case token_angle_bracket_angle_bracket_right:
-            return binop_shr;
-        case token_angle_bracket_angle_bracket_left_pipe:
-            return binop_shl_saturate;
-        case token_plus:
-            return binop_add;
-        case token_plus_percent:
-            return binop_add_wrap;
-        case token_plus_pipe:
-            return binop_add_saturate;
-        case token_minus:
-            return binop_sub;
-        case token_minus_percent:
-            return binop_sub_wrap;
-        case token_minus_pipe:
-            return binop_sub_saturate;
-        case token_asterisk_asterisk:
-            return binop_array_spread;
-        case token_plus_plus:
-            return binop_array_concat;
-        case token_asterisk:
-            return binop_mul;
-        case token_asterisk_percent:
-            return binop_mul_wrap;
-        case token_asterisk_pipe:
-            return binop_mul_saturate;
-        case token_slash:
-            return binop_div;
-        case token_percent:
-            return binop_mod;
-        case token_pipe_pipe:
-            return binop_error_set_merge;
-        default:
-            return binop_invalid;
-    }
-}
+// An operator waiting for its right operand.
+typedef struct BinOpFrame {
+    NodeIndex lhs;
+    BinOp op;
+    int prec;
+} BinOpFrame;
 
 // Expr <- BoolOrExpr
-static Node* Parser_parseExpr0(Parser *p, int min_prec)
+//
+// Precedence climbing with an explicit stack. An operator is only pushed when it binds tighter
+// than the one below it, so the stack never holds more than one frame per precedence level and
+// long left-associative chains run in constant space. Nodes are allocated in the same order as
+// the recursive formulation.
+static NodeIndex Parser_parseExpr0(Parser *p, int min_prec)
 {
-    Node *lhs = Parser_parsePrefixExpr(p);
-
-    int c = 0;
-    while (c++ < LOOP_MAX) {
-        BinOp op = Parser_peekBinOp(p);
-        if (op == binop_invalid) return lhs;
-        int prec = Parser_binOpPrecedence(op);
-        if (prec < min_prec) break;
-        p->index++;
+    BinOpFrame stack[BINOP_PREC_MAX];
+    uint32_t stack_len = 0;
+
+    NodeIndex lhs = Parser_parsePrefixExpr(p);
+    while (true) {
+        BinOpInfo info = binop_infos[Parser_tag(p, p->index)];
+        int prec = stack_len ? stack[stack_len - 1].prec + 1 : min_prec;
+        if (info.prec != 0 && info.prec >= prec) {
+            assume(stack_len < BINOP_PREC_MAX);
+            stack[stack_len++] = (BinOpFrame){ .lhs = lhs, .op = (BinOp)info.op, .prec = info.prec };
+            p->index++;
+            lhs = Parser_parsePrefixExpr(p);
+            continue;
+        }
+        if (stack_len == 0) return lhs;
 
-        Node *rhs = Parser_parseExpr0(p, prec + 1);
+        BinOpFrame f = stack[--stack_len];
         Node *n = Parser_allocNode(p);
         n->tag = node_binary_expr;
         n->data.binary_expr = (NodeDataBinaryExpr){
-            .op = op,
-            .lhs = lhs,
-            .rhs = rhs,
+            .op = f.op,
+            .lhs = f.lhs,
+            .rhs = lhs,
         };
-        lhs = n;
+        lhs = Parser_nodeIndex(p, n);
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
-
-    return lhs;
 }
-static Node* Parser_parseExpr(Parser *p)
+static NodeIndex Parser_parseExpr(Parser *p)
 {
     Parser_trace(p);
-    return Parser_parseExpr0(p, 0);
+    if (!Parser_peekFirst(p, first_Expr)) return NODE_NONE;
+    NodeIndex n;
+    if (Parser_memoGet(p, parser_rule_expr, &n)) return n;
+    uint32_t start = p->index;
+    return Parser_memoPut(p, parser_rule_expr, start, Parser_parseExpr0(p, 0));
 }
 
 // SingleAssignExpr <- Expr (AssignOp Expr)?
-static Node* Parser_parseSingleAssignExpr(Parser *p)
+static NodeIndex Parser_parseSingleAssignExpr(Parser *p)
 {
     Parser_trace(p);
-    Node *lhs = Parser_parseExpr(p);
+    NodeIndex lhs = Parser_parseExpr(p);
     TokenTag assign_op = Parser_eatAssignOp(p);
     if (assign_op == token_invalid) return lhs;
-    Node *rhs = Parser_parseExpr(p);
+    NodeIndex rhs = Parser_parseExpr(p);
     if (!rhs) Parser_fail(p, "expected expression");
 
     Node *n = Parser_allocNode(p);
@@ -3356,17 +4097,17 @@ static Node* Parser_parseSingleAssignExpr(Parser *p)
         .assign_op = assign_op,
         .rhs = rhs,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // AssignExpr <- Expr (AssignOp Expr / (COMMA Expr)+ EQUAL Expr)?
-static Node* Parser_parseAssignExpr(Parser *p)
+static NodeIndex Parser_parseAssignExpr(Parser *p)
 {
     Parser_trace(p);
-    Node *lhs = Parser_parseExpr(p);
+    NodeIndex lhs = Parser_parseExpr(p);
     TokenTag assign_op = Parser_eatAssignOp(p);
     if (assign_op != token_invalid) {
-        Node *rhs = Parser_parseExpr(p);
+        NodeIndex rhs = Parser_parseExpr(p);
         if (!rhs) Parser_fail(p, "expected expression");
 
         Node *n = Parser_allocNode(p);
@@ -3376,22 +4117,20 @@ static Node* Parser_parseAssignExpr(Parser *p)
             .assign_op = assign_op,
             .rhs = rhs,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
     if (!Parser_peek(p, token_comma)) return lhs;
 
-    NodeArray a;
-    NodeArray_init(&a);
+    ParserList a = Parser_startList(p);
 
-    int c = 0;
-    while (c++ < LOOP_MAX && Parser_eat(p, token_comma)) {
-        Node *expr = Parser_parseExpr(p);
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at) && Parser_eat(p, token_comma)) {
+        NodeIndex expr = Parser_parseExpr(p);
         if (!expr) Parser_fail(p, "expected expression");
-        NodeArray_append(&a, expr);
+        Parser_listAppend(p, &a, expr);
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
     Parser_expect(p, token_equal);
-    Node *rhs = Parser_parseExpr(p);
+    NodeIndex rhs = Parser_parseExpr(p);
     if (!rhs) Parser_fail(p, "expected expression");
     Parser_expect(p, token_semicolon);
 
@@ -3399,40 +4138,38 @@ static Node* Parser_parseAssignExpr(Parser *p)
     n->tag = node_multi_assign_expr;
     n->data.multi_assign_expr = (NodeDataMultiAssignExpr){
         .lhs = lhs,
-        .lhs_additional = a.data,
+        .lhs_additional = Parser_finishList(p, &a),
         .lhs_additional_len = a.len,
         .expr = rhs,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
-static Node* Parser_parseVarDeclProto(Parser *p);
+static NodeIndex Parser_parseVarDeclProto(Parser *p);
 // VarDeclExprStatement
 //     <- VarDeclProto (COMMA (VarDeclProto / Expr))* EQUAL Expr SEMICOLON
 //      / Expr (AssignOp Expr / (COMMA (VarDeclProto / Expr))+ EQUAL Expr)? SEMICOLON
-static Node* Parser_parseVarDeclExprStatement(Parser *p)
+static NodeIndex Parser_parseVarDeclExprStatement(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
-    NodeArray a;
-    NodeArray_init(&a);
+    ParserList a = Parser_startList(p);
 
     if (Parser_peek(p, token_keyword_const) || Parser_peek(p, token_keyword_var)) {;
-        Node *proto = Parser_parseVarDeclProto(p);
+        NodeIndex proto = Parser_parseVarDeclProto(p);
         if (!proto) goto fail;
 
-        int c = 0;
-        while (c++ < LOOP_MAX && Parser_eat(p, token_comma)) {
-            Node *proto_or_expr = NULL;
+        uint32_t at = TOKEN_NONE;
+        while (Parser_progress(p, &at) && Parser_eat(p, token_comma)) {
+            NodeIndex proto_or_expr = NODE_NONE;
             proto_or_expr = Parser_parseVarDeclProto(p);
             if (!proto_or_expr) proto_or_expr = Parser_parseExpr(p);
             if (!proto_or_expr) goto fail;
-            NodeArray_append(&a, proto_or_expr);
+            Parser_listAppend(p, &a, proto_or_expr);
         }
-        if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
         if (!Parser_eat(p, token_equal)) goto fail;
-        Node *expr = Parser_parseExpr(p);
+        NodeIndex expr = Parser_parseExpr(p);
         if (!expr) goto fail;
         if (!Parser_eat(p, token_semicolon)) goto fail;
 
@@ -3440,14 +4177,14 @@ static Node* Parser_parseVarDeclExprStatement(Parser *p)
         n->tag = node_var_decl_statement;
         n->data.var_decl_statement = (NodeDataVarDeclStatement){
             .var_decl = proto,
-            .var_decl_additional = a.data,
+            .var_decl_additional = Parser_finishList(p, &a),
             .var_decl_additional_len = a.len,
             .expr = expr,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
-    Node *lhs_expr = Parser_parseExpr(p);
+    NodeIndex lhs_expr = Parser_parseExpr(p);
     if (!lhs_expr) goto fail;
     if (Parser_eat(p, token_semicolon)) {
         return lhs_expr;
@@ -3455,7 +4192,7 @@ static Node* Parser_parseVarDeclExprStatement(Parser *p)
 
     TokenTag assign_op = Parser_eatAssignOp(p);
     if (assign_op != token_invalid) {
-        Node *rhs_expr = Parser_parseExpr(p);
+        NodeIndex rhs_expr = Parser_parseExpr(p);
         if (!Parser_eat(p, token_semicolon)) goto fail;
         Node *n = Parser_allocNode(p);
         n->tag = node_single_assign_expr;
@@ -3464,22 +4201,21 @@ static Node* Parser_parseVarDeclExprStatement(Parser *p)
             .assign_op = assign_op,
             .rhs = rhs_expr,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
     if (!Parser_peek(p, token_comma)) goto fail;
 
-    int c = 0;
-    while (c++ < LOOP_MAX && Parser_eat(p, token_comma)) {
-        Node *proto_or_expr = NULL;
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at) && Parser_eat(p, token_comma)) {
+        NodeIndex proto_or_expr = NODE_NONE;
         proto_or_expr = Parser_parseVarDeclProto(p);
         if (!proto_or_expr) proto_or_expr = Parser_parseExpr(p);
         if (!proto_or_expr) goto fail;
-        NodeArray_append(&a, proto_or_expr);
+        Parser_listAppend(p, &a, proto_or_expr);
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
     if (!Parser_eat(p, token_equal)) goto fail;
-    Node *expr = Parser_parseExpr(p);
+    NodeIndex expr = Parser_parseExpr(p);
     if (!expr) goto fail;
     if (!Parser_eat(p, token_semicolon)) goto fail;
 
@@ -3487,27 +4223,27 @@ static Node* Parser_parseVarDeclExprStatement(Parser *p)
     n->tag = node_var_decl_statement;
     n->data.var_decl_statement = (NodeDataVarDeclStatement){
         .var_decl = lhs_expr,
-        .var_decl_additional = a.data,
+        .var_decl_additional = Parser_finishList(p, &a),
         .var_decl_additional_len = a.len,
         .expr = expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // BlockExpr <- BlockLabel? Block
-static Node* Parser_parseBlockExpr(Parser *p)
+static NodeIndex Parser_parseBlockExpr(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
-    Buffer label = Parser_parseBlockLabel(p);
-    Node *block = Parser_parseBlock(p);
-    if (block == NULL) goto fail;
-    if (label.len == 0) return block;
+    TokenIndex label = Parser_parseBlockLabel(p);
+    NodeIndex block = Parser_parseBlock(p);
+    if (!block) goto fail;
+    if (label == TOKEN_NONE) return block;
 
     Node *n = Parser_allocNode(p);
     n->tag = node_labeled_block;
@@ -3515,23 +4251,23 @@ static Node* Parser_parseBlockExpr(Parser *p)
         .label = label,
         .node = block,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // BlockExprStatement
 //     <- BlockExpr
 //      / AssignExpr SEMICOLON
-static Node* Parser_expectBlockExprStatement(Parser *p)
+static NodeIndex Parser_expectBlockExprStatement(Parser *p)
 {
     Parser_trace(p);
-    Node *block_expr = Parser_parseBlockExpr(p);
+    NodeIndex block_expr = Parser_parseBlockExpr(p);
     if (block_expr) return block_expr;
 
-    Node *assign_expr = Parser_parseAssignExpr(p);
+    NodeIndex assign_expr = Parser_parseAssignExpr(p);
     Parser_expect(p, token_semicolon);
     return assign_expr;
 }
@@ -3539,14 +4275,14 @@ static Node* Parser_expectBlockExprStatement(Parser *p)
 // WhileStatement
 //     <- WhilePrefix BlockExpr ( KEYWORD_else Payload? Statement )?
 //      / WhilePrefix AssignExpr ( SEMICOLON / KEYWORD_else Payload? Statement )
-static Node* Parser_parseWhileStatement(Parser *p)
+static NodeIndex Parser_parseWhileStatement(Parser *p)
 {
     Parser_trace(p);
-    Node *while_prefix = Parser_parseWhilePrefix(p);
-    Buffer else_payload_name = Buffer_empty();
-    Node *else_statement = NULL;
+    NodeIndex while_prefix = Parser_parseWhilePrefix(p);
+    TokenIndex else_payload_name = TOKEN_NONE;
+    NodeIndex else_statement = NODE_NONE;
 
-    Node *block_expr = Parser_parseBlockExpr(p);
+    NodeIndex block_expr = Parser_parseBlockExpr(p);
     if (block_expr) {
         if (Parser_eat(p, token_keyword_else)) {
             else_payload_name = Parser_parsePayload(p);
@@ -3561,10 +4297,10 @@ static Node* Parser_parseWhileStatement(Parser *p)
             .else_payload_name = else_payload_name,
             .else_statement = else_statement,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
-    Node *assign_expr = Parser_parseAssignExpr(p);
+    NodeIndex assign_expr = Parser_parseAssignExpr(p);
     if (assign_expr) {
         if (!Parser_eat(p, token_semicolon)) {
             if (!Parser_eat(p, token_keyword_else)) {
@@ -3582,7 +4318,7 @@ static Node* Parser_parseWhileStatement(Parser *p)
             .else_payload_name = else_payload_name,
             .else_statement = else_statement,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
     Parser_fail(p, "expected block or assignment");
@@ -3591,13 +4327,13 @@ static Node* Parser_parseWhileStatement(Parser *p)
 // ForStatement
 //     <- ForPrefix BlockExpr ( KEYWORD_else Statement )?
 //      / ForPrefix AssignExpr ( SEMICOLON / KEYWORD_else Statement )
-static Node* Parser_parseForStatement(Parser *p)
+static NodeIndex Parser_parseForStatement(Parser *p)
 {
     Parser_trace(p);
-    Node *for_prefix = Parser_parseForPrefix(p);
-    Node *else_statement = NULL;
+    NodeIndex for_prefix = Parser_parseForPrefix(p);
+    NodeIndex else_statement = NODE_NONE;
 
-    Node *block_expr = Parser_parseBlockExpr(p);
+    NodeIndex block_expr = Parser_parseBlockExpr(p);
     if (block_expr) {
         if (Parser_eat(p, token_keyword_else)) {
             else_statement = Parser_parseStatement(p);
@@ -3610,10 +4346,10 @@ static Node* Parser_parseForStatement(Parser *p)
             .block = block_expr,
             .else_statement = else_statement,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
-    Node *assign_expr = Parser_parseAssignExpr(p);
+    NodeIndex assign_expr = Parser_parseAssignExpr(p);
     if (assign_expr) {
         if (!Parser_eat(p, token_semicolon)) {
             if (!Parser_eat(p, token_keyword_else)) {
@@ -3629,24 +4365,24 @@ static Node* Parser_parseForStatement(Parser *p)
             .block = assign_expr,
             .else_statement = else_statement,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
     Parser_fail(p, "expected block or assignment");
 }
 
 // LoopStatement <- KEYWORD_inline? (ForStatement / WhileStatement)
-static Node* Parser_parseLoopStatement(Parser *p)
+static NodeIndex Parser_parseLoopStatement(Parser *p)
 {
     Parser_trace(p);
     bool is_inline = Parser_eat(p, token_keyword_inline);
-    Node *statement = NULL;
+    NodeIndex statement = NODE_NONE;
     if (Parser_peek(p, token_keyword_for)) {
         statement = Parser_parseForStatement(p);
     } else if (Parser_peek(p, token_keyword_while)) {
         statement = Parser_parseWhileStatement(p);
     } else {
-        return NULL;
+        return NODE_NONE;
     }
 
     Node *n = Parser_allocNode(p);
@@ -3655,15 +4391,15 @@ static Node* Parser_parseLoopStatement(Parser *p)
         .is_inline = is_inline,
         .statement = statement,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // LabeledStatement <- BlockLabel? (Block / LoopStatement / SwitchExpr)
-static Node* Parser_parseLabeledStatement(Parser *p)
+static NodeIndex Parser_parseLabeledStatement(Parser *p)
 {
     Parser_trace(p);
-    Buffer label = Parser_parseBlockLabel(p);
-    Node *block = NULL;
+    TokenIndex label = Parser_parseBlockLabel(p);
+    NodeIndex block = NODE_NONE;
 
     if (Parser_peek(p, token_l_brace)) {
         block = Parser_parseBlock(p);
@@ -3674,7 +4410,7 @@ static Node* Parser_parseLabeledStatement(Parser *p)
     } else if (Parser_peek(p, token_keyword_switch)) {
         block = Parser_parseSwitchExpr(p);
     } else {
-        return NULL;
+        return NODE_NONE;
     }
 
     Node *n = Parser_allocNode(p);
@@ -3683,20 +4419,20 @@ static Node* Parser_parseLabeledStatement(Parser *p)
         .label = label,
         .statement = block,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // IfStatement
 //     <- IfPrefix BlockExpr ( KEYWORD_else Payload? Statement )?
 //      / IfPrefix AssignExpr ( SEMICOLON / KEYWORD_else Payload? Statement )
-static Node* Parser_expectIfStatement(Parser *p)
+static NodeIndex Parser_expectIfStatement(Parser *p)
 {
     Parser_trace(p);
-    Node *if_prefix = Parser_parseIfPrefix(p);
-    Buffer else_payload_name = Buffer_empty();
-    Node *else_statement = NULL;
+    NodeIndex if_prefix = Parser_parseIfPrefix(p);
+    TokenIndex else_payload_name = TOKEN_NONE;
+    NodeIndex else_statement = NODE_NONE;
 
-    Node *block_expr = Parser_parseBlockExpr(p);
+    NodeIndex block_expr = Parser_parseBlockExpr(p);
     if (block_expr) {
         if (Parser_eat(p, token_keyword_else)) {
             else_payload_name = Parser_parsePayload(p);
@@ -3711,10 +4447,10 @@ static Node* Parser_expectIfStatement(Parser *p)
             .else_payload_name = else_payload_name,
             .else_statement = else_statement,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
-    Node *assign_expr = Parser_parseAssignExpr(p);
+    NodeIndex assign_expr = Parser_parseAssignExpr(p);
     if (assign_expr) {
         if (!Parser_eat(p, token_semicolon)) {
             if (!Parser_eat(p, token_keyword_else)) {
@@ -3732,7 +4468,7 @@ static Node* Parser_expectIfStatement(Parser *p)
             .else_payload_name = else_payload_name,
             .else_statement = else_statement,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
     Parser_fail(p, "expected block or assignment");
@@ -3741,13 +4477,13 @@ static Node* Parser_expectIfStatement(Parser *p)
 // ComptimeStatement
 //     <- BlockExpr
 //      / VarDeclExprStatement
-static Node* Parser_expectComptimeStatement(Parser *p)
+static NodeIndex Parser_expectComptimeStatement(Parser *p)
 {
     Parser_trace(p);
-    Node *block_expr = Parser_parseBlockExpr(p);
+    NodeIndex block_expr = Parser_parseBlockExpr(p);
     if (block_expr) return block_expr;
 
-    Node *var_decl_expr = Parser_parseVarDeclExprStatement(p);
+    NodeIndex var_decl_expr = Parser_parseVarDeclExprStatement(p);
     if (var_decl_expr) return var_decl_expr;
 
     Parser_fail(p, "expected block expression or var/decl/expression");
@@ -3762,46 +4498,46 @@ static Node* Parser_expectComptimeStatement(Parser *p)
 //      / IfStatement
 //      / LabeledStatement
 //      / VarDeclExprStatement
-static Node* Parser_parseStatement(Parser *p)
+static NodeIndex Parser_parseStatement0(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
     if (Parser_eat(p, token_keyword_comptime)) {
-        Node *comptime_statement = Parser_expectComptimeStatement(p);
+        NodeIndex comptime_statement = Parser_expectComptimeStatement(p);
         Node *n = Parser_allocNode(p);
         n->tag = node_comptime_statement;
         n->data.comptime_statement = (NodeDataComptimeStatement){
             .comptime_statement = comptime_statement,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_keyword_nosuspend)) {
-        Node *block_expr = Parser_expectBlockExprStatement(p);
+        NodeIndex block_expr = Parser_expectBlockExprStatement(p);
         Node *n = Parser_allocNode(p);
         n->tag = node_nosuspend_statement;
         n->data.nosuspend_statement = (NodeDataBlockExprStatement){
             .block_expr = block_expr,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_keyword_suspend)) {
-        Node *block_expr = Parser_expectBlockExprStatement(p);
+        NodeIndex block_expr = Parser_expectBlockExprStatement(p);
         Node *n = Parser_allocNode(p);
         n->tag = node_suspend_statement;
         n->data.suspend_statement = (NodeDataBlockExprStatement){
             .block_expr = block_expr,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_keyword_defer)) {
-        Node *block_expr = Parser_expectBlockExprStatement(p);
+        NodeIndex block_expr = Parser_expectBlockExprStatement(p);
         Node *n = Parser_allocNode(p);
         n->tag = node_defer_statement;
         n->data.defer_statement = (NodeDataBlockExprStatement){
             .block_expr = block_expr,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_eat(p, token_keyword_errdefer)) {
-        Buffer payload_name = Parser_parsePayload(p);
-        Node *block_expr = Parser_expectBlockExprStatement(p);
+        TokenIndex payload_name = Parser_parsePayload(p);
+        NodeIndex block_expr = Parser_expectBlockExprStatement(p);
 
         Node *n = Parser_allocNode(p);
         n->tag = node_errdefer_statement;
@@ -3809,41 +4545,49 @@ static Node* Parser_parseStatement(Parser *p)
             .payload_name = payload_name,
             .block_expr = block_expr,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     } else if (Parser_peek(p, token_keyword_if)) {
         return Parser_expectIfStatement(p);
     }
 
-    Node *ls = Parser_parseLabeledStatement(p);
+    NodeIndex ls = Parser_peekFirst(p, first_LabeledStatement) ? Parser_parseLabeledStatement(p) : NODE_NONE;
     if (ls) return ls;
 
-    Node *vde = Parser_parseVarDeclExprStatement(p);
+    NodeIndex vde = Parser_parseVarDeclExprStatement(p);
     if (vde) return vde;
 
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
+}
+
+static NodeIndex Parser_parseStatement(Parser *p)
+{
+    NodeIndex n;
+    if (Parser_memoGet(p, parser_rule_statement, &n)) return n;
+    uint32_t start = p->index;
+    return Parser_memoPut(p, parser_rule_statement, start, Parser_parseStatement0(p));
 }
 
 // ContainerField <- doc_comment? KEYWORD_comptime? !KEYWORD_fn (IDENTIFIER COLON)? TypeExpr ByteAlign? (EQUAL Expr)?
-static Node* Parser_parseContainerField(Parser *p)
+static NodeIndex Parser_parseContainerField(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
     while (Parser_eat(p, token_doc_comment)) {}
     bool is_comptime = Parser_eat(p, token_keyword_comptime);
     if (Parser_peek(p, token_keyword_fn)) goto fail;
 
-    Buffer name = Parser_eatIdentifier(p);
-    if (name.len != 0) {
+    TokenIndex name = Parser_eatIdentifier(p);
+    if (name != TOKEN_NONE) {
         if (!Parser_eat(p, token_colon)) p->index--;    // reset, this is not a label
     }
 
-    Node *type_expr = Parser_parseTypeExpr(p);
+    NodeIndex type_expr = Parser_parseTypeExpr(p);
     if (!type_expr) goto fail;
-    Node *bytealign = Parser_parseByteAlign(p);
+    NodeIndex bytealign = Parser_parseByteAlign(p);
 
-    Node *expr = NULL;
+    NodeIndex expr = NODE_NONE;
     if (Parser_eat(p, token_equal)) {
         expr = Parser_parseExpr(p);
     }
@@ -3857,22 +4601,22 @@ static Node* Parser_parseContainerField(Parser *p)
         .expr = expr,
         .is_comptime = is_comptime,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
-static Node* Parser_parseVarDeclProto(Parser *p);
+static NodeIndex Parser_parseVarDeclProto(Parser *p);
 // GlobalVarDecl <- VarDeclProto (EQUAL Expr)? SEMICOLON
-static Node* Parser_parseGlobalVarDecl(Parser *p)
+static NodeIndex Parser_parseGlobalVarDecl(Parser *p)
 {
     Parser_trace(p);
-    Node *var_decl_proto = Parser_parseVarDeclProto(p);
-    if (!var_decl_proto) return NULL;
+    NodeIndex var_decl_proto = Parser_parseVarDeclProto(p);
+    if (!var_decl_proto) return NODE_NONE;
 
-    Node *expr = NULL;
+    NodeIndex expr = NODE_NONE;
     if (Parser_eat(p, token_equal)) {
         expr = Parser_parseExpr(p);
         if (!expr) Parser_fail(p, "failed to parse var decl expression");
@@ -3885,26 +4629,26 @@ static Node* Parser_parseGlobalVarDecl(Parser *p)
         .var_decl_proto = var_decl_proto,
         .expr = expr,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // VarDeclProto <- (KEYWORD_const / KEYWORD_var) IDENTIFIER (COLON TypeExpr)? ByteAlign? AddrSpace? LinkSection?
-static Node* Parser_parseVarDeclProto(Parser *p)
+static NodeIndex Parser_parseVarDeclProto(Parser *p)
 {
     Parser_trace(p);
     TokenTag tag = Parser_eatOneOf(p, (TokenTag[]){ token_keyword_const, token_keyword_var }, 2);
-    if (tag == token_invalid) return NULL;
-    Buffer name = Parser_expectIdentifier(p);
+    if (tag == token_invalid) return NODE_NONE;
+    TokenIndex name = Parser_expectIdentifier(p);
 
-    Node *type = NULL;
+    NodeIndex type = NODE_NONE;
     if (Parser_eat(p, token_colon)) {
         type = Parser_parseTypeExpr(p);
         if (!type) Parser_fail(p, "expected type after ';'");
     }
 
-    Node *bytealign = Parser_parseByteAlign(p);
-    Node *addrspace = Parser_parseAddrSpace(p);
-    Node *linksection = Parser_parseLinkSection(p);
+    NodeIndex bytealign = Parser_parseByteAlign(p);
+    NodeIndex addrspace = Parser_parseAddrSpace(p);
+    NodeIndex linksection = Parser_parseLinkSection(p);
 
     Node *n = Parser_allocNode(p);
     n->tag = node_var_decl_proto;
@@ -3916,37 +4660,38 @@ static Node* Parser_parseVarDeclProto(Parser *p)
         .addrspace = addrspace,
         .linksection = linksection,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // FnProto <- KEYWORD_fn IDENTIFIER? LPAREN ParamDeclList RPAREN ByteAlign? AddrSpace? LinkSection? CallConv? EXCLAMATIONMARK? TypeExpr
-static Node* Parser_expectFnProto(Parser *p)
+static NodeIndex Parser_expectFnProto(Parser *p)
 {
     Parser_trace(p);
     Parser_expect(p, token_keyword_fn);
-    Buffer name = Parser_eatIdentifier(p);
+    TokenIndex name = Parser_eatIdentifier(p);
     Parser_expect(p, token_l_paren);
-    Node *params = NULL;
+    NodeIndex params = NODE_NONE;
     if (!Parser_peek(p, token_r_paren)) params = Parser_parseParamDeclList(p);
     Parser_expect(p, token_r_paren);
-    Node *bytealign = Parser_parseByteAlign(p);
-    Node *addrspace = Parser_parseAddrSpace(p);
-    Node *linksection = Parser_parseLinkSection(p);
-    Node *callconv = Parser_parseCallConv(p);
+    NodeIndex bytealign = Parser_parseByteAlign(p);
+    NodeIndex addrspace = Parser_parseAddrSpace(p);
+    NodeIndex linksection = Parser_parseLinkSection(p);
+    NodeIndex callconv = Parser_parseCallConv(p);
     bool is_return_type_error = Parser_eat(p, token_bang);
-    Node *return_type = Parser_parseTypeExpr(p);
+    NodeIndex return_type = Parser_parseTypeExpr(p);
     if (!return_type) Parser_fail(p, "expected type expression");
 
-    Node *extra = NULL;
+    NodeIndex extra = NODE_NONE;
     if (bytealign || addrspace || linksection || callconv) {
-        extra = Parser_allocNode(p);
-        extra->tag = node_fn_proto_extra;
-        extra->data.fn_proto_extra = (NodeDataFnProtoExtra){
+        Node *e = Parser_allocNode(p);
+        e->tag = node_fn_proto_extra;
+        e->data.fn_proto_extra = (NodeDataFnProtoExtra){
             .bytealign = bytealign,
             .addrspace = addrspace,
             .linksection = linksection,
             .callconv = callconv,
         };
+        extra = Parser_nodeIndex(p, e);
     }
 
     Node *n = Parser_allocNode(p);
@@ -3958,22 +4703,22 @@ static Node* Parser_expectFnProto(Parser *p)
         .extra_data = extra,
         .is_return_type_error = is_return_type_error,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // Decl
 //     <- (KEYWORD_export / KEYWORD_extern STRINGLITERALSINGLE? / KEYWORD_inline / KEYWORD_noinline)? FnProto (SEMICOLON / Block)
 //      / (KEYWORD_export / KEYWORD_extern STRINGLITERALSINGLE?)? KEYWORD_threadlocal? GlobalVarDecl
-static Node* Parser_parseDecl(Parser *p)
+static NodeIndex Parser_parseDecl(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
 
     uint32_t modifiers = 0;
-    Buffer extern_name = Buffer_empty();
+    TokenIndex extern_name = TOKEN_NONE;
 
     // can be stricter with this chain
-    switch (p->tokens[p->index].tag) {
+    switch (Parser_tag(p, p->index)) {
         case token_keyword_export:
             p->index++;
             modifiers |= decl_modifier_export;
@@ -3982,8 +4727,8 @@ static Node* Parser_parseDecl(Parser *p)
         case token_keyword_extern:
             p->index++;
             modifiers |= decl_modifier_extern;
-            extern_name = Parser_tokenSlice(p);
-            if (!Parser_eat(p, token_string_literal)) extern_name = Buffer_empty();
+            extern_name = p->index;
+            if (!Parser_eat(p, token_string_literal)) extern_name = TOKEN_NONE;
             break;
 
         case token_keyword_inline:
@@ -4009,9 +4754,9 @@ static Node* Parser_parseDecl(Parser *p)
     }
 
     if (Parser_peek(p, token_keyword_fn)) {
-        Node *fn_proto = Parser_expectFnProto(p);
-        Node *block = NULL;
-        if (!Parser_eat(p, token_semicolon)) block = Parser_parseBlock(p);
+        NodeIndex fn_proto = Parser_expectFnProto(p);
+        NodeIndex block = NODE_NONE;
+        if (!Parser_eat(p, token_semicolon)) block = p->lazy ? Parser_skipBlock(p) : Parser_parseBlock(p);
 
         Node *n = Parser_allocNode(p);
         n->tag = node_decl_fn;
@@ -4021,9 +4766,9 @@ static Node* Parser_parseDecl(Parser *p)
             .modifiers = modifiers,
             .extern_name = extern_name,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     } else {
-        Node *global_var_decl = Parser_parseGlobalVarDecl(p);
+        NodeIndex global_var_decl = Parser_parseGlobalVarDecl(p);
         if (!global_var_decl) goto fail;
 
         Node *n = Parser_allocNode(p);
@@ -4033,39 +4778,39 @@ static Node* Parser_parseDecl(Parser *p)
             .modifiers = modifiers,
             .extern_name = extern_name,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
 }
 
 // ComptimeDecl <- KEYWORD_comptime Block
-static Node* Parser_expectComptimeDecl(Parser *p)
+static NodeIndex Parser_expectComptimeDecl(Parser *p)
 {
     Parser_trace(p);
     Parser_expect(p, token_keyword_comptime);
-    Node *block = Parser_parseBlock(p);
+    NodeIndex block = Parser_parseBlock(p);
 
     Node *n = Parser_allocNode(p);
     n->tag = node_comptime_decl;
     n->data.comptime_decl = (NodeDataComptimeDecl){
         .block = block,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // TestDecl <- KEYWORD_test (STRINGLITERALSINGLE / IDENTIFIER)? Block
-static Node* Parser_expectTestDecl(Parser *p)
+static NodeIndex Parser_expectTestDecl(Parser *p)
 {
     Parser_trace(p);
     Parser_expect(p, token_keyword_test);
 
-    Buffer name = Parser_tokenSlice(p);
+    TokenIndex name = p->index;
     TokenTag tag = Parser_eatOneOf(p, (TokenTag[]){ token_string_literal, token_identifier }, 2);
-    if (tag == token_invalid) name = Buffer_empty();
-    Node *block = Parser_parseBlock(p);
+    if (tag == token_invalid) name = TOKEN_NONE;
+    NodeIndex block = Parser_parseBlock(p);
     if (!block) Parser_fail(p, "expected block");
 
     Node *n = Parser_allocNode(p);
@@ -4075,14 +4820,15 @@ static Node* Parser_expectTestDecl(Parser *p)
         .is_ident = tag == token_identifier,
         .block = block,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // ContainerDeclaration <- TestDecl / ComptimeDecl / doc_comment? KEYWORD_pub? Decl
-static Node* Parser_parseContainerDeclaration(Parser *p)
+static NodeIndex Parser_parseContainerDeclaration(Parser *p)
 {
     Parser_trace(p);
-    uint32_t index = p->index;
+    ParserMark mark = Parser_mark(p);
+    if (!Parser_peekFirst(p, first_ContainerDeclaration)) return NODE_NONE;
 
     if (Parser_peek(p, token_keyword_test)) {
         return Parser_expectTestDecl(p);
@@ -4091,7 +4837,7 @@ static Node* Parser_parseContainerDeclaration(Parser *p)
     } else {
         while (Parser_eat(p, token_doc_comment)) {}
         bool is_pub = Parser_eat(p, token_keyword_pub);
-        Node *decl = Parser_parseDecl(p);
+        NodeIndex decl = Parser_parseDecl(p);
         if (!decl) goto fail;
 
         Node *n = Parser_allocNode(p);
@@ -4100,76 +4846,262 @@ static Node* Parser_parseContainerDeclaration(Parser *p)
             .decl = decl,
             .is_pub = is_pub,
         };
-        return n;
+        return Parser_nodeIndex(p, n);
     }
 
 fail:
-    p->index = index;
-    return NULL;
+    Parser_reset(p, mark);
+    return NODE_NONE;
+}
+
+// Name of a declaration from Parser_parseContainerDeclaration, TOKEN_NONE if it has none.
+static TokenIndex Parser_declName(Parser *p, NodeIndex index)
+{
+    const Node *n = Ast_node(&p->ast, index);
+    if (n->tag == node_test_decl) return n->data.test_decl.name;
+    if (n->tag != node_top_level_decl) return TOKEN_NONE;
+    n = Ast_node(&p->ast, n->data.top_level_decl.decl);
+    if (n->tag == node_decl_fn) {
+        return Ast_node(&p->ast, n->data.decl_fn.fn_proto)->data.fn_proto.name;
+    } else if (n->tag == node_decl_global_var_decl) {
+        n = Ast_node(&p->ast, n->data.decl_global_var_decl.global_var_decl);
+        return Ast_node(&p->ast, n->data.global_var_decl.var_decl_proto)->data.var_decl_proto.name;
+    }
+    return TOKEN_NONE;
+}
+
+// A declaration of the root container, traced with its name.
+static NodeIndex Parser_parseRootDeclaration(Parser *p)
+{
+    uint64_t trace_start = Trace_begin(p->trace);
+    NodeIndex n = Parser_parseContainerDeclaration(p);
+    if (n && p->trace) {
+        TokenIndex name = Parser_declName(p, n);
+        uint32_t start = name == TOKEN_NONE ? 0 : Parser_tokenStart(p, name);
+        uint32_t end = name == TOKEN_NONE ? 0 : Tokenizer_tokenEnd(p->source, start);
+        Trace_end(p->trace, trace_start, "parse decl", trace_arg_source, start, end - start);
+    }
+    return n;
+}
+
+// Top-level declarations are independent, so with threads > 1 the root is cut into token ranges at
+// likely declaration boundaries and each range is parsed by a worker into its own Ast. A range is
+// only kept if every range before it was kept and it ends exactly where the next one starts,
+// which makes the result identical to the serial parse. From the first range that does not fit,
+// the serial loop takes over.
+#define PARSER_CHUNK_MIN 16384      // tokens per worker
+
+typedef struct ParserWorker {
+    Parser p;
+    uint32_t end;
+    ParserList decls;           // on the scratch stack of p
+    bool ok;
+} ParserWorker;
+
+static bool Parser_isDeclStart(TokenTag tag)
+{
+    switch (tag) {
+        case token_doc_comment:
+        case token_keyword_pub:
+        case token_keyword_test:
+        case token_keyword_comptime:
+        case token_keyword_fn:
+        case token_keyword_const:
+        case token_keyword_var:
+        case token_keyword_export:
+        case token_keyword_extern:
+        case token_keyword_inline:
+        case token_keyword_noinline:
+        case token_keyword_threadlocal:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void Parser_initWorker(ParserWorker *w, const Parser *p, uint32_t start, uint32_t end)
+{
+    w->p = *p;
+    w->p.index = start;
+    w->p.nodes_discarded = 0;
+    w->p.threads = 1;
+    w->p.bail = NULL;
+    w->p.memo = p->memo ? ParserMemo_create() : NULL;
+    IndexArray_init(&w->p.scratch);
+    w->p.profile = p->profile ? ParserProfile_create() : NULL;
+    w->p.profile_frame = NULL;
+    w->p.trace = NULL;
+    Ast_init(&w->p.ast, p->source);
+    w->end = end;
+    w->decls = Parser_startList(&w->p);
+    w->ok = false;
+}
+
+static void Parser_parseDeclsWorker(void *arg)
+{
+    ParserWorker *w = arg;
+    Parser *p = &w->p;
+    void *bail[5];
+    p->bail = bail;
+    if (__builtin_setjmp(bail)) return;
+
+    while (p->index < w->end) {
+        NodeIndex n = Parser_parseRootDeclaration(p);
+        if (!n) break;
+        Parser_listAppend(p, &w->decls, n);
+    }
+    w->ok = p->index == w->end;
+}
+
+// Parse a prefix of the top-level declarations across threads, appending them to decls.
+static void Parser_parseDeclsParallel(Parser *p, ParserList *decls)
+{
+    // Lex everything and match all braces on this thread, the workers only read the token list.
+    Parser_fill(p, UINT32_MAX);
+    assume(p->stream->done);
+    uint32_t start = p->index;
+    uint32_t end = p->tokens_len - 1;   // the final eof or invalid token
+    uint32_t threads = p->threads;
+    if (start >= end) return;
+    if (threads > (end - start) / PARSER_CHUNK_MIN) threads = (end - start) / PARSER_CHUNK_MIN;
+    if (threads <= 1) return;
+
+    ParserWorker *workers = std_malloc(sizeof(ParserWorker) * threads);
+    void **handles = std_malloc(sizeof(void*) * threads);
+    if (!workers || !handles) std_panic("oom");
+
+    // Cut where a declaration keyword follows a ';' or '}' outside any brackets.
+    uint32_t workers_len = 0;
+    uint32_t step = (end - start) / threads;
+    int depth = 0;
+    for (uint32_t i = start; i < end && workers_len + 1 < threads; i++) {
+        TokenTag tag = p->tags[i];
+        switch (tag) {
+            case token_l_paren:
+            case token_l_bracket:
+            case token_l_brace:
+                depth++;
+                break;
+            case token_r_paren:
+            case token_r_bracket:
+            case token_r_brace:
+                depth--;
+                break;
+            default:
+                break;
+        }
+        if (i + 1 - start >= step && depth == 0 && (tag == token_semicolon || tag == token_r_brace)
+                && Parser_isDeclStart(p->tags[i + 1])) {
+            Parser_initWorker(&workers[workers_len++], p, start, i + 1);
+            start = i + 1;
+        }
+    }
+    Parser_initWorker(&workers[workers_len++], p, start, end);
+
+    // worker 0 runs on this thread
+    if (p->trace) {
+        workers[0].p.trace = p->trace;
+        for (uint32_t i = 1; i < workers_len; i++) workers[i].p.trace = Trace_newBuffer(p->trace->trace, "parse worker");
+    }
+    for (uint32_t i = 1; i < workers_len; i++) {
+        handles[i] = std_threadSpawn(Parser_parseDeclsWorker, &workers[i]);
+        if (!handles[i]) Parser_parseDeclsWorker(&workers[i]);
+    }
+    Parser_parseDeclsWorker(&workers[0]);
+    for (uint32_t i = 1; i < workers_len; i++) {
+        if (handles[i]) std_threadJoin(handles[i]);
+    }
+
+    bool merging = true;
+    for (uint32_t i = 0; i < workers_len; i++) {
+        ParserWorker *w = &workers[i];
+        merging = merging && w->ok;
+        if (merging) {
+            uint32_t *roots = w->p.scratch.data + w->decls.top;
+            Ast_append(&p->ast, &w->p.ast, roots, w->decls.len);
+            for (uint32_t j = 0; j < w->decls.len; j++) Parser_listAppend(p, decls, roots[j]);
+            p->nodes_discarded += w->p.nodes_discarded;
+            p->index = w->end;
+        }
+        if (w->p.memo) {
+            for (uint32_t r = 0; r < parser_rule_count; r++) {
+                p->memo->hits[r] += w->p.memo->hits[r];
+                p->memo->misses[r] += w->p.memo->misses[r];
+            }
+            ParserMemo_destroy(w->p.memo);
+        }
+        if (w->p.profile) {
+            ParserProfile_merge(p->profile, w->p.profile);
+            std_free(w->p.profile);
+        }
+        std_free(w->p.ast.nodes.data);
+        std_free(w->p.ast.extra.data);
+        std_free(w->p.scratch.data);
+    }
+
+    std_free(handles);
+    std_free(workers);
 }
 
 // ContainerMembers <- container_doc_comment? ContainerDeclaration* (ContainerField COMMA)* (ContainerField / ContainerDeclaration*)
-static Node* Parser_expectContainerMembers(Parser *p)
+static NodeIndex Parser_expectContainerMembers(Parser *p, bool is_root)
 {
     Parser_trace(p);
 
     // TODO: tokenizer should combine doc comment here, and not generate multiple
     while (Parser_eat(p, token_container_doc_comment)) {}
 
-    NodeArray decls;
-    NodeArray_init(&decls);
-
-    NodeArray fields;
-    NodeArray_init(&fields);
+    ParserList decls = Parser_startList(p);
+    if (is_root && p->threads > 1) Parser_parseDeclsParallel(p, &decls);
 
-    int c = 0;
-    while (c++ < LOOP_MAX && !Parser_peek(p, token_eof)) {
-        Node *n = Parser_parseContainerDeclaration(p);
+    uint32_t at = TOKEN_NONE;
+    while (Parser_progress(p, &at) && !Parser_peek(p, token_eof)) {
+        NodeIndex n = is_root ? Parser_parseRootDeclaration(p) : Parser_parseContainerDeclaration(p);
         if (!n) break;
-        NodeArray_append(&decls, n);
+        Parser_listAppend(p, &decls, n);
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
 
-    c = 0;
-    while (c++ < LOOP_MAX && !Parser_peek(p, token_eof)) {
-        Node *n = Parser_parseContainerField(p);
+    // The fields sit above the leading declarations on the stack, so they are finished first.
+    ParserList fields = Parser_startList(p);
+    at = TOKEN_NONE;
+    while (Parser_progress(p, &at) && !Parser_peek(p, token_eof)) {
+        NodeIndex n = Parser_parseContainerField(p);
         if (!n) break;
-        NodeArray_append(&fields, n);
+        Parser_listAppend(p, &fields, n);
         if (!Parser_eat(p, token_comma)) break;
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
+    ExtraIndex fields_list = Parser_finishList(p, &fields);
 
-    c = 0;
-    while (c++ < LOOP_MAX && !Parser_peek(p, token_eof)) {
-        Node *n = Parser_parseContainerDeclaration(p);
+    at = TOKEN_NONE;
+    while (Parser_progress(p, &at) && !Parser_peek(p, token_eof)) {
+        NodeIndex n = is_root ? Parser_parseRootDeclaration(p) : Parser_parseContainerDeclaration(p);
         if (!n) break;
-        NodeArray_append(&decls, n);
+        Parser_listAppend(p, &decls, n);
     }
-    if (c >= LOOP_MAX) Parser_fail(p, "infinite loop");
 
     Node *n = Parser_allocNode(p);
     n->tag = node_container_members;
     n->data.container_members = (NodeDataContainerMembers){
-        .decls = decls.data,
+        .decls = Parser_finishList(p, &decls),
         .decls_len = decls.len,
-        .fields = fields.data,
+        .fields = fields_list,
         .fields_len = fields.len,
     };
-    return n;
+    return Parser_nodeIndex(p, n);
 }
 
 // Root <- skip ContainerMembers eof
-static Node* Parser_expectRoot(Parser *p)
+static NodeIndex Parser_expectRoot(Parser *p)
 {
     Parser_trace(p);
-    Node *n = Parser_expectContainerMembers(p);
+    NodeIndex n = Parser_expectContainerMembers(p, true);
     Parser_expect(p, token_eof);
     return n;
 }
 
-static Node* Parser_parse(Parser *p)
+static Ast* Parser_parse(Parser *p)
 {
-    return Parser_expectRoot(p);
+    p->ast.root = Parser_expectRoot(p);
+    p->ast.token_starts = p->stream->tokens->starts;
+    return &p->ast;
 }
-
-#undef LOOP_MAX
\ No newline at end of file
@@ -0,0 +1,609 @@
+// Generated by tools/gen_first.c from src/grammar.peg, do not edit.
+//
+// FIRST set of each syntax rule: the tokens a match can start with. A nullable rule can also
+// match nothing, so a token outside its set does not rule it out.
+
+// Root: identifier string_literal multiline_string_literal_line char_literal eof builtin
+//     l_paren l_bracket period asterisk asterisk_asterisk question_mark number_literal
+//     doc_comment container_doc_comment keyword_anyframe keyword_comptime keyword_const
+//     keyword_enum keyword_error keyword_export keyword_extern keyword_fn keyword_for
+//     keyword_if keyword_inline keyword_noinline keyword_opaque keyword_packed keyword_pub
+//     keyword_struct keyword_switch keyword_test keyword_threadlocal keyword_union
+//     keyword_unreachable keyword_var keyword_while
+__attribute__((unused))
+static const TokenSet first_Root = {{ 0x04005000028100fcull, 0x005dd195fd1821c0ull }};
+
+// ContainerMembers (nullable): identifier string_literal multiline_string_literal_line
+//     char_literal builtin l_paren l_bracket period asterisk asterisk_asterisk question_mark
+//     number_literal doc_comment container_doc_comment keyword_anyframe keyword_comptime
+//     keyword_const keyword_enum keyword_error keyword_export keyword_extern keyword_fn
+//     keyword_for keyword_if keyword_inline keyword_noinline keyword_opaque keyword_packed
+//     keyword_pub keyword_struct keyword_switch keyword_test keyword_threadlocal keyword_union
+//     keyword_unreachable keyword_var keyword_while
+__attribute__((unused))
+static const TokenSet first_ContainerMembers = {{ 0x04005000028100bcull, 0x005dd195fd1821c0ull }};
+
+// ContainerDeclaration: doc_comment keyword_comptime keyword_const keyword_export
+//     keyword_extern keyword_fn keyword_inline keyword_noinline keyword_pub keyword_test
+//     keyword_threadlocal keyword_var
+__attribute__((unused))
+static const TokenSet first_ContainerDeclaration = {{ 0x0000000000000000ull, 0x0011810538180080ull }};
+
+// TestDecl: keyword_test
+__attribute__((unused))
+static const TokenSet first_TestDecl = {{ 0x0000000000000000ull, 0x0000800000000000ull }};
+
+// ComptimeDecl: keyword_comptime
+__attribute__((unused))
+static const TokenSet first_ComptimeDecl = {{ 0x0000000000000000ull, 0x0000000000080000ull }};
+
+// Decl: keyword_const keyword_export keyword_extern keyword_fn keyword_inline keyword_noinline
+//     keyword_threadlocal keyword_var
+__attribute__((unused))
+static const TokenSet first_Decl = {{ 0x0000000000000000ull, 0x0011000538100000ull }};
+
+// FnProto: keyword_fn
+__attribute__((unused))
+static const TokenSet first_FnProto = {{ 0x0000000000000000ull, 0x0000000020000000ull }};
+
+// VarDeclProto: keyword_const keyword_var
+__attribute__((unused))
+static const TokenSet first_VarDeclProto = {{ 0x0000000000000000ull, 0x0010000000100000ull }};
+
+// GlobalVarDecl: keyword_const keyword_var
+__attribute__((unused))
+static const TokenSet first_GlobalVarDecl = {{ 0x0000000000000000ull, 0x0010000000100000ull }};
+
+// ContainerField: identifier string_literal multiline_string_literal_line char_literal builtin
+//     l_paren l_bracket period asterisk asterisk_asterisk question_mark number_literal
+//     doc_comment keyword_anyframe keyword_comptime keyword_enum keyword_error keyword_extern
+//     keyword_fn keyword_for keyword_if keyword_inline keyword_opaque keyword_packed
+//     keyword_struct keyword_switch keyword_union keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_ContainerField = {{ 0x04005000028100bcull, 0x004c5091f50820c0ull }};
+
+// Statement: identifier string_literal multiline_string_literal_line char_literal builtin bang
+//     l_paren l_brace l_bracket period minus minus_percent asterisk asterisk_asterisk ampersand
+//     question_mark tilde number_literal keyword_anyframe keyword_asm keyword_break
+//     keyword_comptime keyword_const keyword_continue keyword_defer keyword_enum
+//     keyword_errdefer keyword_error keyword_extern keyword_fn keyword_for keyword_if
+//     keyword_inline keyword_nosuspend keyword_opaque keyword_packed keyword_resume
+//     keyword_return keyword_struct keyword_suspend keyword_switch keyword_try keyword_union
+//     keyword_unreachable keyword_var keyword_while
+__attribute__((unused))
+static const TokenSet first_Statement = {{ 0x0500514002a101bcull, 0x005e7699f779a060ull }};
+
+// ComptimeStatement: identifier string_literal multiline_string_literal_line char_literal
+//     builtin bang l_paren l_brace l_bracket period minus minus_percent asterisk
+//     asterisk_asterisk ampersand question_mark tilde number_literal keyword_anyframe
+//     keyword_asm keyword_break keyword_comptime keyword_const keyword_continue keyword_enum
+//     keyword_error keyword_extern keyword_fn keyword_for keyword_if keyword_inline
+//     keyword_nosuspend keyword_opaque keyword_packed keyword_resume keyword_return
+//     keyword_struct keyword_switch keyword_try keyword_union keyword_unreachable keyword_var
+//     keyword_while
+__attribute__((unused))
+static const TokenSet first_ComptimeStatement = {{ 0x0500514002a101bcull, 0x005e5699f539a060ull }};
+
+// IfStatement: keyword_if
+__attribute__((unused))
+static const TokenSet first_IfStatement = {{ 0x0000000000000000ull, 0x0000000080000000ull }};
+
+// LabeledStatement: identifier l_brace keyword_for keyword_inline keyword_switch keyword_while
+__attribute__((unused))
+static const TokenSet first_LabeledStatement = {{ 0x0000000000200004ull, 0x0040400140000000ull }};
+
+// LoopStatement: keyword_for keyword_inline keyword_while
+__attribute__((unused))
+static const TokenSet first_LoopStatement = {{ 0x0000000000000000ull, 0x0040000140000000ull }};
+
+// ForStatement: keyword_for
+__attribute__((unused))
+static const TokenSet first_ForStatement = {{ 0x0000000000000000ull, 0x0000000040000000ull }};
+
+// WhileStatement: keyword_while
+__attribute__((unused))
+static const TokenSet first_WhileStatement = {{ 0x0000000000000000ull, 0x0040000000000000ull }};
+
+// BlockExprStatement: identifier string_literal multiline_string_literal_line char_literal
+//     builtin bang l_paren l_brace l_bracket period minus minus_percent asterisk
+//     asterisk_asterisk ampersand question_mark tilde number_literal keyword_anyframe
+//     keyword_asm keyword_break keyword_comptime keyword_continue keyword_enum keyword_error
+//     keyword_extern keyword_fn keyword_for keyword_if keyword_inline keyword_nosuspend
+//     keyword_opaque keyword_packed keyword_resume keyword_return keyword_struct keyword_switch
+//     keyword_try keyword_union keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_BlockExprStatement = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
+
+// BlockExpr: identifier l_brace
+__attribute__((unused))
+static const TokenSet first_BlockExpr = {{ 0x0000000000200004ull, 0x0000000000000000ull }};
+
+// VarDeclExprStatement: identifier string_literal multiline_string_literal_line char_literal
+//     builtin bang l_paren l_brace l_bracket period minus minus_percent asterisk
+//     asterisk_asterisk ampersand question_mark tilde number_literal keyword_anyframe
+//     keyword_asm keyword_break keyword_comptime keyword_const keyword_continue keyword_enum
+//     keyword_error keyword_extern keyword_fn keyword_for keyword_if keyword_inline
+//     keyword_nosuspend keyword_opaque keyword_packed keyword_resume keyword_return
+//     keyword_struct keyword_switch keyword_try keyword_union keyword_unreachable keyword_var
+//     keyword_while
+__attribute__((unused))
+static const TokenSet first_VarDeclExprStatement = {{ 0x0500514002a101bcull, 0x005e5699f539a060ull }};
+
+// AssignExpr: identifier string_literal multiline_string_literal_line char_literal builtin bang
+//     l_paren l_brace l_bracket period minus minus_percent asterisk asterisk_asterisk ampersand
+//     question_mark tilde number_literal keyword_anyframe keyword_asm keyword_break
+//     keyword_comptime keyword_continue keyword_enum keyword_error keyword_extern keyword_fn
+//     keyword_for keyword_if keyword_inline keyword_nosuspend keyword_opaque keyword_packed
+//     keyword_resume keyword_return keyword_struct keyword_switch keyword_try keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_AssignExpr = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
+
+// SingleAssignExpr: identifier string_literal multiline_string_literal_line char_literal
+//     builtin bang l_paren l_brace l_bracket period minus minus_percent asterisk
+//     asterisk_asterisk ampersand question_mark tilde number_literal keyword_anyframe
+//     keyword_asm keyword_break keyword_comptime keyword_continue keyword_enum keyword_error
+//     keyword_extern keyword_fn keyword_for keyword_if keyword_inline keyword_nosuspend
+//     keyword_opaque keyword_packed keyword_resume keyword_return keyword_struct keyword_switch
+//     keyword_try keyword_union keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_SingleAssignExpr = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
+
+// Expr: identifier string_literal multiline_string_literal_line char_literal builtin bang
+//     l_paren l_brace l_bracket period minus minus_percent asterisk asterisk_asterisk ampersand
+//     question_mark tilde number_literal keyword_anyframe keyword_asm keyword_break
+//     keyword_comptime keyword_continue keyword_enum keyword_error keyword_extern keyword_fn
+//     keyword_for keyword_if keyword_inline keyword_nosuspend keyword_opaque keyword_packed
+//     keyword_resume keyword_return keyword_struct keyword_switch keyword_try keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_Expr = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
+
+// BoolOrExpr: identifier string_literal multiline_string_literal_line char_literal builtin bang
+//     l_paren l_brace l_bracket period minus minus_percent asterisk asterisk_asterisk ampersand
+//     question_mark tilde number_literal keyword_anyframe keyword_asm keyword_break
+//     keyword_comptime keyword_continue keyword_enum keyword_error keyword_extern keyword_fn
+//     keyword_for keyword_if keyword_inline keyword_nosuspend keyword_opaque keyword_packed
+//     keyword_resume keyword_return keyword_struct keyword_switch keyword_try keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_BoolOrExpr = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
+
+// BoolAndExpr: identifier string_literal multiline_string_literal_line char_literal builtin
+//     bang l_paren l_brace l_bracket period minus minus_percent asterisk asterisk_asterisk
+//     ampersand question_mark tilde number_literal keyword_anyframe keyword_asm keyword_break
+//     keyword_comptime keyword_continue keyword_enum keyword_error keyword_extern keyword_fn
+//     keyword_for keyword_if keyword_inline keyword_nosuspend keyword_opaque keyword_packed
+//     keyword_resume keyword_return keyword_struct keyword_switch keyword_try keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_BoolAndExpr = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
+
+// CompareExpr: identifier string_literal multiline_string_literal_line char_literal builtin
+//     bang l_paren l_brace l_bracket period minus minus_percent asterisk asterisk_asterisk
+//     ampersand question_mark tilde number_literal keyword_anyframe keyword_asm keyword_break
+//     keyword_comptime keyword_continue keyword_enum keyword_error keyword_extern keyword_fn
+//     keyword_for keyword_if keyword_inline keyword_nosuspend keyword_opaque keyword_packed
+//     keyword_resume keyword_return keyword_struct keyword_switch keyword_try keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_CompareExpr = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
+
+// BitwiseExpr: identifier string_literal multiline_string_literal_line char_literal builtin
+//     bang l_paren l_brace l_bracket period minus minus_percent asterisk asterisk_asterisk
+//     ampersand question_mark tilde number_literal keyword_anyframe keyword_asm keyword_break
+//     keyword_comptime keyword_continue keyword_enum keyword_error keyword_extern keyword_fn
+//     keyword_for keyword_if keyword_inline keyword_nosuspend keyword_opaque keyword_packed
+//     keyword_resume keyword_return keyword_struct keyword_switch keyword_try keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_BitwiseExpr = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
+
+// BitShiftExpr: identifier string_literal multiline_string_literal_line char_literal builtin
+//     bang l_paren l_brace l_bracket period minus minus_percent asterisk asterisk_asterisk
+//     ampersand question_mark tilde number_literal keyword_anyframe keyword_asm keyword_break
+//     keyword_comptime keyword_continue keyword_enum keyword_error keyword_extern keyword_fn
+//     keyword_for keyword_if keyword_inline keyword_nosuspend keyword_opaque keyword_packed
+//     keyword_resume keyword_return keyword_struct keyword_switch keyword_try keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_BitShiftExpr = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
+
+// AdditionExpr: identifier string_literal multiline_string_literal_line char_literal builtin
+//     bang l_paren l_brace l_bracket period minus minus_percent asterisk asterisk_asterisk
+//     ampersand question_mark tilde number_literal keyword_anyframe keyword_asm keyword_break
+//     keyword_comptime keyword_continue keyword_enum keyword_error keyword_extern keyword_fn
+//     keyword_for keyword_if keyword_inline keyword_nosuspend keyword_opaque keyword_packed
+//     keyword_resume keyword_return keyword_struct keyword_switch keyword_try keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_AdditionExpr = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
+
+// MultiplyExpr: identifier string_literal multiline_string_literal_line char_literal builtin
+//     bang l_paren l_brace l_bracket period minus minus_percent asterisk asterisk_asterisk
+//     ampersand question_mark tilde number_literal keyword_anyframe keyword_asm keyword_break
+//     keyword_comptime keyword_continue keyword_enum keyword_error keyword_extern keyword_fn
+//     keyword_for keyword_if keyword_inline keyword_nosuspend keyword_opaque keyword_packed
+//     keyword_resume keyword_return keyword_struct keyword_switch keyword_try keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_MultiplyExpr = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
+
+// PrefixExpr: identifier string_literal multiline_string_literal_line char_literal builtin bang
+//     l_paren l_brace l_bracket period minus minus_percent asterisk asterisk_asterisk ampersand
+//     question_mark tilde number_literal keyword_anyframe keyword_asm keyword_break
+//     keyword_comptime keyword_continue keyword_enum keyword_error keyword_extern keyword_fn
+//     keyword_for keyword_if keyword_inline keyword_nosuspend keyword_opaque keyword_packed
+//     keyword_resume keyword_return keyword_struct keyword_switch keyword_try keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_PrefixExpr = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
+
+// PrimaryExpr: identifier string_literal multiline_string_literal_line char_literal builtin
+//     l_paren l_brace l_bracket period asterisk asterisk_asterisk question_mark number_literal
+//     keyword_anyframe keyword_asm keyword_break keyword_comptime keyword_continue keyword_enum
+//     keyword_error keyword_extern keyword_fn keyword_for keyword_if keyword_inline
+//     keyword_nosuspend keyword_opaque keyword_packed keyword_resume keyword_return
+//     keyword_struct keyword_switch keyword_union keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_PrimaryExpr = {{ 0x0400500002a100bcull, 0x004c5699f529a040ull }};
+
+// IfExpr: keyword_if
+__attribute__((unused))
+static const TokenSet first_IfExpr = {{ 0x0000000000000000ull, 0x0000000080000000ull }};
+
+// Block: l_brace
+__attribute__((unused))
+static const TokenSet first_Block = {{ 0x0000000000200000ull, 0x0000000000000000ull }};
+
+// LoopExpr: keyword_for keyword_inline keyword_while
+__attribute__((unused))
+static const TokenSet first_LoopExpr = {{ 0x0000000000000000ull, 0x0040000140000000ull }};
+
+// ForExpr: keyword_for
+__attribute__((unused))
+static const TokenSet first_ForExpr = {{ 0x0000000000000000ull, 0x0000000040000000ull }};
+
+// WhileExpr: keyword_while
+__attribute__((unused))
+static const TokenSet first_WhileExpr = {{ 0x0000000000000000ull, 0x0040000000000000ull }};
+
+// CurlySuffixExpr: identifier string_literal multiline_string_literal_line char_literal builtin
+//     l_paren l_bracket period asterisk asterisk_asterisk question_mark number_literal
+//     keyword_anyframe keyword_comptime keyword_enum keyword_error keyword_extern keyword_fn
+//     keyword_for keyword_if keyword_inline keyword_opaque keyword_packed keyword_struct
+//     keyword_switch keyword_union keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_CurlySuffixExpr = {{ 0x04005000028100bcull, 0x004c5091f5082040ull }};
+
+// InitList: l_brace
+__attribute__((unused))
+static const TokenSet first_InitList = {{ 0x0000000000200000ull, 0x0000000000000000ull }};
+
+// TypeExpr: identifier string_literal multiline_string_literal_line char_literal builtin
+//     l_paren l_bracket period asterisk asterisk_asterisk question_mark number_literal
+//     keyword_anyframe keyword_comptime keyword_enum keyword_error keyword_extern keyword_fn
+//     keyword_for keyword_if keyword_inline keyword_opaque keyword_packed keyword_struct
+//     keyword_switch keyword_union keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_TypeExpr = {{ 0x04005000028100bcull, 0x004c5091f5082040ull }};
+
+// ErrorUnionExpr: identifier string_literal multiline_string_literal_line char_literal builtin
+//     l_paren period number_literal keyword_anyframe keyword_comptime keyword_enum
+//     keyword_error keyword_extern keyword_fn keyword_for keyword_if keyword_inline
+//     keyword_opaque keyword_packed keyword_struct keyword_switch keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_ErrorUnionExpr = {{ 0x00000000020100bcull, 0x004c5091f5082040ull }};
+
+// SuffixExpr: identifier string_literal multiline_string_literal_line char_literal builtin
+//     l_paren period number_literal keyword_anyframe keyword_comptime keyword_enum
+//     keyword_error keyword_extern keyword_fn keyword_for keyword_if keyword_inline
+//     keyword_opaque keyword_packed keyword_struct keyword_switch keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_SuffixExpr = {{ 0x00000000020100bcull, 0x004c5091f5082040ull }};
+
+// PrimaryTypeExpr: identifier string_literal multiline_string_literal_line char_literal builtin
+//     l_paren period number_literal keyword_anyframe keyword_comptime keyword_enum
+//     keyword_error keyword_extern keyword_fn keyword_for keyword_if keyword_inline
+//     keyword_opaque keyword_packed keyword_struct keyword_switch keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_PrimaryTypeExpr = {{ 0x00000000020100bcull, 0x004c5091f5082040ull }};
+
+// ContainerDecl: keyword_enum keyword_extern keyword_opaque keyword_packed keyword_struct
+//     keyword_union
+__attribute__((unused))
+static const TokenSet first_ContainerDecl = {{ 0x0000000000000000ull, 0x0004109011000000ull }};
+
+// ErrorSetDecl: keyword_error
+__attribute__((unused))
+static const TokenSet first_ErrorSetDecl = {{ 0x0000000000000000ull, 0x0000000004000000ull }};
+
+// GroupedExpr: l_paren
+__attribute__((unused))
+static const TokenSet first_GroupedExpr = {{ 0x0000000000010000ull, 0x0000000000000000ull }};
+
+// IfTypeExpr: keyword_if
+__attribute__((unused))
+static const TokenSet first_IfTypeExpr = {{ 0x0000000000000000ull, 0x0000000080000000ull }};
+
+// LabeledTypeExpr: identifier keyword_for keyword_inline keyword_switch keyword_while
+__attribute__((unused))
+static const TokenSet first_LabeledTypeExpr = {{ 0x0000000000000004ull, 0x0040400140000000ull }};
+
+// LoopTypeExpr: keyword_for keyword_inline keyword_while
+__attribute__((unused))
+static const TokenSet first_LoopTypeExpr = {{ 0x0000000000000000ull, 0x0040000140000000ull }};
+
+// ForTypeExpr: keyword_for
+__attribute__((unused))
+static const TokenSet first_ForTypeExpr = {{ 0x0000000000000000ull, 0x0000000040000000ull }};
+
+// WhileTypeExpr: keyword_while
+__attribute__((unused))
+static const TokenSet first_WhileTypeExpr = {{ 0x0000000000000000ull, 0x0040000000000000ull }};
+
+// SwitchExpr: keyword_switch
+__attribute__((unused))
+static const TokenSet first_SwitchExpr = {{ 0x0000000000000000ull, 0x0000400000000000ull }};
+
+// AsmExpr: keyword_asm
+__attribute__((unused))
+static const TokenSet first_AsmExpr = {{ 0x0000000000000000ull, 0x0000000000008000ull }};
+
+// AsmOutput: colon
+__attribute__((unused))
+static const TokenSet first_AsmOutput = {{ 0x0010000000000000ull, 0x0000000000000000ull }};
+
+// AsmOutputItem: l_bracket
+__attribute__((unused))
+static const TokenSet first_AsmOutputItem = {{ 0x0000000000800000ull, 0x0000000000000000ull }};
+
+// AsmInput: colon
+__attribute__((unused))
+static const TokenSet first_AsmInput = {{ 0x0010000000000000ull, 0x0000000000000000ull }};
+
+// AsmInputItem: l_bracket
+__attribute__((unused))
+static const TokenSet first_AsmInputItem = {{ 0x0000000000800000ull, 0x0000000000000000ull }};
+
+// AsmClobbers: colon
+__attribute__((unused))
+static const TokenSet first_AsmClobbers = {{ 0x0010000000000000ull, 0x0000000000000000ull }};
+
+// BreakLabel: colon
+__attribute__((unused))
+static const TokenSet first_BreakLabel = {{ 0x0010000000000000ull, 0x0000000000000000ull }};
+
+// BlockLabel: identifier
+__attribute__((unused))
+static const TokenSet first_BlockLabel = {{ 0x0000000000000004ull, 0x0000000000000000ull }};
+
+// FieldInit: period
+__attribute__((unused))
+static const TokenSet first_FieldInit = {{ 0x0000000002000000ull, 0x0000000000000000ull }};
+
+// WhileContinueExpr: colon
+__attribute__((unused))
+static const TokenSet first_WhileContinueExpr = {{ 0x0010000000000000ull, 0x0000000000000000ull }};
+
+// LinkSection: keyword_linksection
+__attribute__((unused))
+static const TokenSet first_LinkSection = {{ 0x0000000000000000ull, 0x0000080000000000ull }};
+
+// AddrSpace: keyword_addrspace
+__attribute__((unused))
+static const TokenSet first_AddrSpace = {{ 0x0000000000000000ull, 0x0000000000000200ull }};
+
+// CallConv: keyword_callconv
+__attribute__((unused))
+static const TokenSet first_CallConv = {{ 0x0000000000000000ull, 0x0000000000020000ull }};
+
+// ParamDecl: identifier string_literal multiline_string_literal_line char_literal builtin
+//     l_paren l_bracket period ellipsis3 asterisk asterisk_asterisk question_mark
+//     number_literal doc_comment keyword_anyframe keyword_anytype keyword_comptime keyword_enum
+//     keyword_error keyword_extern keyword_fn keyword_for keyword_if keyword_inline
+//     keyword_noalias keyword_opaque keyword_packed keyword_struct keyword_switch keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_ParamDecl = {{ 0x04005000128100bcull, 0x004c5093f50860c0ull }};
+
+// ParamType: identifier string_literal multiline_string_literal_line char_literal builtin
+//     l_paren l_bracket period asterisk asterisk_asterisk question_mark number_literal
+//     keyword_anyframe keyword_anytype keyword_comptime keyword_enum keyword_error
+//     keyword_extern keyword_fn keyword_for keyword_if keyword_inline keyword_opaque
+//     keyword_packed keyword_struct keyword_switch keyword_union keyword_unreachable
+//     keyword_while
+__attribute__((unused))
+static const TokenSet first_ParamType = {{ 0x04005000028100bcull, 0x004c5091f5086040ull }};
+
+// IfPrefix: keyword_if
+__attribute__((unused))
+static const TokenSet first_IfPrefix = {{ 0x0000000000000000ull, 0x0000000080000000ull }};
+
+// WhilePrefix: keyword_while
+__attribute__((unused))
+static const TokenSet first_WhilePrefix = {{ 0x0000000000000000ull, 0x0040000000000000ull }};
+
+// ForPrefix: keyword_for
+__attribute__((unused))
+static const TokenSet first_ForPrefix = {{ 0x0000000000000000ull, 0x0000000040000000ull }};
+
+// Payload: pipe
+__attribute__((unused))
+static const TokenSet first_Payload = {{ 0x0000000000000200ull, 0x0000000000000000ull }};
+
+// PtrPayload: pipe
+__attribute__((unused))
+static const TokenSet first_PtrPayload = {{ 0x0000000000000200ull, 0x0000000000000000ull }};
+
+// PtrIndexPayload: pipe
+__attribute__((unused))
+static const TokenSet first_PtrIndexPayload = {{ 0x0000000000000200ull, 0x0000000000000000ull }};
+
+// PtrListPayload: pipe
+__attribute__((unused))
+static const TokenSet first_PtrListPayload = {{ 0x0000000000000200ull, 0x0000000000000000ull }};
+
+// SwitchProng: identifier string_literal multiline_string_literal_line char_literal builtin
+//     bang l_paren l_brace l_bracket period minus minus_percent asterisk asterisk_asterisk
+//     ampersand question_mark tilde number_literal keyword_anyframe keyword_asm keyword_break
+//     keyword_comptime keyword_continue keyword_else keyword_enum keyword_error keyword_extern
+//     keyword_fn keyword_for keyword_if keyword_inline keyword_nosuspend keyword_opaque
+//     keyword_packed keyword_resume keyword_return keyword_struct keyword_switch keyword_try
+//     keyword_union keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_SwitchProng = {{ 0x0500514002a101bcull, 0x004e5699f5a9a060ull }};
+
+// SwitchCase: identifier string_literal multiline_string_literal_line char_literal builtin bang
+//     l_paren l_brace l_bracket period minus minus_percent asterisk asterisk_asterisk ampersand
+//     question_mark tilde number_literal keyword_anyframe keyword_asm keyword_break
+//     keyword_comptime keyword_continue keyword_else keyword_enum keyword_error keyword_extern
+//     keyword_fn keyword_for keyword_if keyword_inline keyword_nosuspend keyword_opaque
+//     keyword_packed keyword_resume keyword_return keyword_struct keyword_switch keyword_try
+//     keyword_union keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_SwitchCase = {{ 0x0500514002a101bcull, 0x004e5699f5a9a060ull }};
+
+// SwitchItem: identifier string_literal multiline_string_literal_line char_literal builtin bang
+//     l_paren l_brace l_bracket period minus minus_percent asterisk asterisk_asterisk ampersand
+//     question_mark tilde number_literal keyword_anyframe keyword_asm keyword_break
+//     keyword_comptime keyword_continue keyword_enum keyword_error keyword_extern keyword_fn
+//     keyword_for keyword_if keyword_inline keyword_nosuspend keyword_opaque keyword_packed
+//     keyword_resume keyword_return keyword_struct keyword_switch keyword_try keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_SwitchItem = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
+
+// ForArgumentsList: identifier string_literal multiline_string_literal_line char_literal
+//     builtin bang l_paren l_brace l_bracket period minus minus_percent asterisk
+//     asterisk_asterisk ampersand question_mark tilde number_literal keyword_anyframe
+//     keyword_asm keyword_break keyword_comptime keyword_continue keyword_enum keyword_error
+//     keyword_extern keyword_fn keyword_for keyword_if keyword_inline keyword_nosuspend
+//     keyword_opaque keyword_packed keyword_resume keyword_return keyword_struct keyword_switch
+//     keyword_try keyword_union keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_ForArgumentsList = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
+
+// ForItem: identifier string_literal multiline_string_literal_line char_literal builtin bang
+//     l_paren l_brace l_bracket period minus minus_percent asterisk asterisk_asterisk ampersand
+//     question_mark tilde number_literal keyword_anyframe keyword_asm keyword_break
+//     keyword_comptime keyword_continue keyword_enum keyword_error keyword_extern keyword_fn
+//     keyword_for keyword_if keyword_inline keyword_nosuspend keyword_opaque keyword_packed
+//     keyword_resume keyword_return keyword_struct keyword_switch keyword_try keyword_union
+//     keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_ForItem = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
+
+// AssignOp: pipe_equal equal percent_equal caret_equal plus_equal plus_percent_equal
+//     plus_pipe_equal minus_equal minus_percent_equal minus_pipe_equal asterisk_equal
+//     asterisk_percent_equal asterisk_pipe_equal slash_equal ampersand_equal
+//     angle_bracket_angle_bracket_left_equal angle_bracket_angle_bracket_left_pipe_equal
+//     angle_bracket_angle_bracket_right_equal
+__attribute__((unused))
+static const TokenSet first_AssignOp = {{ 0x42452aaa40101800ull, 0x0000000000000011ull }};
+
+// CompareOp: equal_equal bang_equal angle_bracket_left angle_bracket_left_equal
+//     angle_bracket_right angle_bracket_right_equal
+__attribute__((unused))
+static const TokenSet first_CompareOp = {{ 0x180000000000a000ull, 0x0000000000000006ull }};
+
+// BitwiseOp: pipe caret ampersand keyword_catch keyword_orelse
+__attribute__((unused))
+static const TokenSet first_BitwiseOp = {{ 0x0100000020000200ull, 0x0000004000040000ull }};
+
+// BitShiftOp: angle_bracket_angle_bracket_left angle_bracket_angle_bracket_left_pipe
+//     angle_bracket_angle_bracket_right
+__attribute__((unused))
+static const TokenSet first_BitShiftOp = {{ 0xa000000000000000ull, 0x0000000000000008ull }};
+
+// AdditionOp: plus plus_plus plus_percent plus_pipe minus minus_percent minus_pipe
+__attribute__((unused))
+static const TokenSet first_AdditionOp = {{ 0x0000055580000000ull, 0x0000000000000000ull }};
+
+// MultiplyOp: pipe_pipe percent asterisk asterisk_asterisk asterisk_percent asterisk_pipe slash
+__attribute__((unused))
+static const TokenSet first_MultiplyOp = {{ 0x0022d00000080400ull, 0x0000000000000000ull }};
+
+// PrefixOp: bang minus minus_percent ampersand tilde keyword_try
+__attribute__((unused))
+static const TokenSet first_PrefixOp = {{ 0x0100014000000100ull, 0x0002000000000020ull }};
+
+// PrefixTypeOp: l_bracket asterisk asterisk_asterisk question_mark keyword_anyframe
+__attribute__((unused))
+static const TokenSet first_PrefixTypeOp = {{ 0x0400500000800000ull, 0x0000000000002000ull }};
+
+// SuffixOp: l_bracket period period_asterisk
+__attribute__((unused))
+static const TokenSet first_SuffixOp = {{ 0x0000000006800000ull, 0x0000000000000000ull }};
+
+// FnCallArguments: l_paren
+__attribute__((unused))
+static const TokenSet first_FnCallArguments = {{ 0x0000000000010000ull, 0x0000000000000000ull }};
+
+// SliceTypeStart: l_bracket
+__attribute__((unused))
+static const TokenSet first_SliceTypeStart = {{ 0x0000000000800000ull, 0x0000000000000000ull }};
+
+// PtrTypeStart: l_bracket asterisk asterisk_asterisk
+__attribute__((unused))
+static const TokenSet first_PtrTypeStart = {{ 0x0000500000800000ull, 0x0000000000000000ull }};
+
+// ArrayTypeStart: l_bracket
+__attribute__((unused))
+static const TokenSet first_ArrayTypeStart = {{ 0x0000000000800000ull, 0x0000000000000000ull }};
+
+// ContainerDeclAuto: keyword_enum keyword_opaque keyword_struct keyword_union
+__attribute__((unused))
+static const TokenSet first_ContainerDeclAuto = {{ 0x0000000000000000ull, 0x0004101001000000ull }};
+
+// ContainerDeclType: keyword_enum keyword_opaque keyword_struct keyword_union
+__attribute__((unused))
+static const TokenSet first_ContainerDeclType = {{ 0x0000000000000000ull, 0x0004101001000000ull }};
+
+// ByteAlign: keyword_align
+__attribute__((unused))
+static const TokenSet first_ByteAlign = {{ 0x0000000000000000ull, 0x0000000000000400ull }};
+
+// IdentifierList (nullable): identifier doc_comment
+__attribute__((unused))
+static const TokenSet first_IdentifierList = {{ 0x0000000000000004ull, 0x0000000000000080ull }};
+
+// SwitchProngList (nullable): identifier string_literal multiline_string_literal_line
+//     char_literal builtin bang l_paren l_brace l_bracket period minus minus_percent asterisk
+//     asterisk_asterisk ampersand question_mark tilde number_literal keyword_anyframe
+//     keyword_asm keyword_break keyword_comptime keyword_continue keyword_else keyword_enum
+//     keyword_error keyword_extern keyword_fn keyword_for keyword_if keyword_inline
+//     keyword_nosuspend keyword_opaque keyword_packed keyword_resume keyword_return
+//     keyword_struct keyword_switch keyword_try keyword_union keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_SwitchProngList = {{ 0x0500514002a101bcull, 0x004e5699f5a9a060ull }};
+
+// AsmOutputList (nullable): l_bracket
+__attribute__((unused))
+static const TokenSet first_AsmOutputList = {{ 0x0000000000800000ull, 0x0000000000000000ull }};
+
+// AsmInputList (nullable): l_bracket
+__attribute__((unused))
+static const TokenSet first_AsmInputList = {{ 0x0000000000800000ull, 0x0000000000000000ull }};
+
+// ParamDeclList (nullable): identifier string_literal multiline_string_literal_line
+//     char_literal builtin l_paren l_bracket period ellipsis3 asterisk asterisk_asterisk
+//     question_mark number_literal doc_comment keyword_anyframe keyword_anytype
+//     keyword_comptime keyword_enum keyword_error keyword_extern keyword_fn keyword_for
+//     keyword_if keyword_inline keyword_noalias keyword_opaque keyword_packed keyword_struct
+//     keyword_switch keyword_union keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_ParamDeclList = {{ 0x04005000128100bcull, 0x004c5093f50860c0ull }};
+
+// ExprList (nullable): identifier string_literal multiline_string_literal_line char_literal
+//     builtin bang l_paren l_brace l_bracket period minus minus_percent asterisk
+//     asterisk_asterisk ampersand question_mark tilde number_literal keyword_anyframe
+//     keyword_asm keyword_break keyword_comptime keyword_continue keyword_enum keyword_error
+//     keyword_extern keyword_fn keyword_for keyword_if keyword_inline keyword_nosuspend
+//     keyword_opaque keyword_packed keyword_resume keyword_return keyword_struct keyword_switch
+//     keyword_try keyword_union keyword_unreachable keyword_while
+__attribute__((unused))
+static const TokenSet first_ExprList = {{ 0x0500514002a101bcull, 0x004e5699f529a060ull }};
@@ -1,5 +1,7 @@
 static tInternId Sema_resolveBuiltinTypeId(Ctx *ctx, Buffer b)
 {
+    (void)ctx;
+
     typedef struct {
         tTypeTag tag;
         char *name;
@@ -42,55 +44,58 @@ static tInternId Sema_resolveBuiltinTypeId(Ctx *ctx, Buffer b)
 
     for (uint32_t i = 0; i < sizeof(mappings)/sizeof(*mappings); i++) {
         if (Buffer_eql(b, mappings[i].name)) {
-            return Ctx_putType(ctx, (tType){ .tag = mappings[i].tag });
+            return (tInternId)mappings[i].tag; // primitive ids are fixed at Ctx_init
         }
     }
 
     return ty_invalid_id;
 }
 
-static Buffer Sema_evalSymbolName(Ctx *ctx, Node *n)
+static Buffer Sema_evalSymbolName(Ctx *ctx, const Ast *ast, NodeIndex index)
 {
+    const Node *n = Ast_node(ast, index);
     switch (n->tag) {
         case node_type_expr:
-            return Sema_evalSymbolName(ctx, n->data.type_expr.type_expr);
+            return Sema_evalSymbolName(ctx, ast, n->data.type_expr.type_expr);
         case node_primary_type_expr:
             switch (n->data.primary_type_expr.tag) {
                 case node_primary_type_identifier:
-                    return n->data.primary_type_expr.data.raw;
+                    return Ast_tokenSlice(ast, n->data.primary_type_expr.data.raw);
                 default:
                     std_panic("unsupported primary type expr tag");
             }
         case node_error_union_expr:
-            return Sema_evalSymbolName(ctx, n->data.error_union_expr.suffix_expr);
+            return Sema_evalSymbolName(ctx, ast, n->data.error_union_expr.suffix_expr);
         case node_suffix_expr:
-            return Sema_evalSymbolName(ctx, n->data.suffix_expr.expr);
+            return Sema_evalSymbolName(ctx, ast, n->data.suffix_expr.expr);
         case node_unary_expr:
             assume(n->data.unary_expr.ops_len == 0);
-            return Sema_evalSymbolName(ctx, n->data.unary_expr.expr);
+            return Sema_evalSymbolName(ctx, ast, n->data.unary_expr.expr);
         default:
             std_panic("unsupported tag: %s\n", NodeTag_name(n->tag));
     }
 }
 
-// Given a Node*, returns a tTypeId.
-static tInternId Sema_evalTypeName(Ctx *ctx, Node *n)
+// Given a type expression node, returns a tTypeId.
+static tInternId Sema_evalTypeName(Ctx *ctx, const Ast *ast, NodeIndex index)
 {
+    const Node *n = Ast_node(ast, index);
     switch (n->tag) {
         case node_type_expr:
         {
-            tInternId id = Sema_evalTypeName(ctx, n->data.type_expr.type_expr);
+            tInternId id = Sema_evalTypeName(ctx, ast, n->data.type_expr.type_expr);
             for (uint32_t i = 0; i < n->data.type_expr.prefix_type_ops_len; i++) {
-                NodeTag tag = n->data.type_expr.prefix_type_ops[i]->tag;
-                switch (tag) {
+                const Node *op = Ast_node(ast, Ast_list(ast, n->data.type_expr.prefix_type_ops)[i]);
+                switch (op->tag) {
                     case node_prefix_type_op_ptr:
                     {
-                        NodeDataPrefixTypePtr p = n->data.type_expr.prefix_type_ops[i]->data.prefix_type_ptr;
+                        NodeDataPrefixTypePtr p = op->data.prefix_type_ptr;
+                        const Node *ptr = Ast_node(ast, p.ptr);
                         tType ty;
                         ty.data.ptr.modifiers = p.modifiers;
                         ty.data.ptr.child = id;
-                        assume(p.ptr->tag == node_ptr_type_start);
-                        switch (p.ptr->data.ptr_type_start.type)
+                        assume(ptr->tag == node_ptr_type_start);
+                        switch (ptr->data.ptr_type_start.type)
                         {
                             // Ignore all the special types, just lower as-is.
                             case node_ptr_type_c:
@@ -116,17 +121,17 @@ static tInternId Sema_evalTypeName(Ctx *ctx, Node *n)
         }
 
         case node_error_union_expr:
-            return Sema_evalTypeName(ctx, n->data.error_union_expr.suffix_expr);
+            return Sema_evalTypeName(ctx, ast, n->data.error_union_expr.suffix_expr);
         case node_suffix_expr:
-            return Sema_evalTypeName(ctx, n->data.suffix_expr.expr);
+            return Sema_evalTypeName(ctx, ast, n->data.suffix_expr.expr);
         case node_primary_type_expr:
             switch (n->data.primary_type_expr.tag) {
                 case node_primary_type_identifier:
                 {
-                    tInternId id = Sema_resolveBuiltinTypeId(ctx, n->data.primary_type_expr.data.raw);
+                    Buffer name = Ast_tokenSlice(ast, n->data.primary_type_expr.data.raw);
+                    tInternId id = Sema_resolveBuiltinTypeId(ctx, name);
                     if (id == ty_invalid_id) {
-                        std_panic("generic symbols not supported: '"PRIb"'",
-                            Buffer(n->data.primary_type_expr.data.raw));
+                        std_panic("generic symbols not supported: '"PRIb"'", Buffer(name));
                     }
                     return id;
                 }
@@ -137,7 +142,7 @@ static tInternId Sema_evalTypeName(Ctx *ctx, Node *n)
             }
         case node_unary_expr:
             assume(n->data.unary_expr.ops_len == 0);
-            return Sema_evalTypeName(ctx, n->data.unary_expr.expr);
+            return Sema_evalTypeName(ctx, ast, n->data.unary_expr.expr);
         default:
             std_panic("unsupported tag: %s\n", NodeTag_name(n->tag));
     }
@@ -145,10 +150,8 @@ static tInternId Sema_evalTypeName(Ctx *ctx, Node *n)
 static tInternId Sema_peerResolveType(Ctx *ctx, tInternId a_id, tInternId b_id)
 {
     if (a_id == b_id) return a_id;
-    tType a = Ctx_getType(ctx, a_id);
-    tType b = Ctx_getType(ctx, b_id);
-    tTypeInfo a_info = tType_info(a);
-    tTypeInfo b_info = tType_info(b);
+    tTypeInfo a_info = Ctx_getTypeInfo(ctx, a_id);
+    tTypeInfo b_info = Ctx_getTypeInfo(ctx, b_id);
 
     if (a_info.class == class_int && b_info.class == class_int) {
         // for now, choose one of the input types, but can generate types not either a or b
@@ -0,0 +1,212 @@
+// TimeReport records wall time, peak RSS and allocations for each compiler phase, see -time-report.
+// The phases also become spans of the -trace-file timeline.
+//
+// Allocations are those made through std_malloc and std_realloc while the phase was active,
+// including by other threads. Peak RSS is the process high-water mark at the end of the phase.
+// With -report the phases also count hardware events, where the os provides them.
+#define TIME_REPORT_PHASES_MAX 16
+
+typedef struct TimeReportPhase {
+    const char *name;
+    uint64_t ns;
+    uint64_t peak_rss;
+    uint64_t allocs;
+    uint64_t alloc_bytes;
+    uint64_t counters[std_perf_count];
+} TimeReportPhase;
+
+typedef struct TimeReport {
+    bool enabled;               // otherwise all calls are no-ops
+    bool print;
+    const char *json_filename;  // also write the report as JSON, may be NULL
+    TraceBuffer *trace;
+    TimeReportPhase phases[TIME_REPORT_PHASES_MAX];
+    uint32_t phases_len;
+    bool active;
+    uint64_t start_ns;          // of the whole run
+    uint64_t phase_ns;          // counters at the start of the active phase
+    uint64_t phase_allocs;
+    uint64_t phase_alloc_bytes;
+    uint64_t phase_counters[std_perf_count];
+    void *perf;                 // NULL unless counting hardware events
+    const char *perf_error;     // why perf is NULL after TimeReport_enableCounters
+    bool counters_available[std_perf_count];
+} TimeReport;
+
+static void TimeReport_init(TimeReport *tr, bool print, const char *json_filename, TraceBuffer *trace)
+{
+    tr->enabled = print || json_filename || trace;
+    tr->print = print;
+    tr->json_filename = json_filename;
+    tr->trace = trace;
+    tr->phases_len = 0;
+    tr->active = false;
+    tr->start_ns = std_timeNs();
+    tr->perf = NULL;
+    tr->perf_error = NULL;
+}
+
+// Count hardware events per phase. If the os does not allow it the report says so instead.
+static void TimeReport_enableCounters(TimeReport *tr)
+{
+    tr->enabled = true;
+    tr->perf = std_perfOpen(&tr->perf_error);
+    for (uint32_t i = 0; i < std_perf_count; i++) tr->counters_available[i] = tr->perf != NULL;
+}
+
+static void TimeReport_readCounters(TimeReport *tr, uint64_t counters[std_perf_count])
+{
+    if (!tr->perf) return;
+    bool available[std_perf_count];
+    std_perfRead(tr->perf, counters, available);
+    for (uint32_t i = 0; i < std_perf_count; i++) tr->counters_available[i] &= available[i];
+}
+
+static void TimeReport_end(TimeReport *tr)
+{
+    if (!tr->active) return;
+    uint64_t counters[std_perf_count];
+    TimeReport_readCounters(tr, counters);
+    uint64_t allocs, alloc_bytes;
+    std_allocStats(&allocs, &alloc_bytes);
+    TimeReportPhase *ph = &tr->phases[tr->phases_len - 1];
+    Trace_end(tr->trace, tr->phase_ns, ph->name, trace_arg_none, 0, 0);
+    ph->ns = std_timeNs() - tr->phase_ns;
+    ph->peak_rss = std_peakRss();
+    ph->allocs = allocs - tr->phase_allocs;
+    ph->alloc_bytes = alloc_bytes - tr->phase_alloc_bytes;
+    if (tr->perf) {
+        for (uint32_t i = 0; i < std_perf_count; i++) ph->counters[i] = counters[i] - tr->phase_counters[i];
+    }
+    tr->active = false;
+}
+
+// End the active phase, if any, and start the named one.
+static void TimeReport_begin(TimeReport *tr, const char *name)
+{
+    TimeReport_end(tr);
+    if (!tr->enabled) return;
+    if (tr->phases_len == TIME_REPORT_PHASES_MAX) std_panic("too many report phases\n");
+    tr->phases[tr->phases_len++] = (TimeReportPhase){ .name = name };
+    tr->active = true;
+    std_allocStats(&tr->phase_allocs, &tr->phase_alloc_bytes);
+    tr->phase_ns = std_timeNs();
+    TimeReport_readCounters(tr, tr->phase_counters);
+}
+
+static TimeReportPhase TimeReport_total(const TimeReport *tr)
+{
+    TimeReportPhase total = { .name = "total", .ns = std_timeNs() - tr->start_ns, .peak_rss = std_peakRss() };
+    for (uint32_t i = 0; i < tr->phases_len; i++) {
+        total.allocs += tr->phases[i].allocs;
+        total.alloc_bytes += tr->phases[i].alloc_bytes;
+        for (uint32_t j = 0; j < std_perf_count; j++) total.counters[j] += tr->phases[i].counters[j];
+    }
+    return total;
+}
+
+static void TimeReport_printPhase(const TimeReportPhase *ph)
+{
+    std_printf("%-10s %10.3f %12.0f %10llu %12.0f\n", ph->name, ph->ns / 1e6, ph->peak_rss / 1024.0,
+        (unsigned long long)ph->allocs, ph->alloc_bytes / 1024.0);
+}
+
+static void TimeReport_print(TimeReport *tr)
+{
+    std_printf("%-10s %10s %12s %10s %12s\n", "phase", "wall ms", "peak RSS KiB", "allocs", "alloc KiB");
+    for (uint32_t i = 0; i < tr->phases_len; i++) TimeReport_printPhase(&tr->phases[i]);
+    TimeReportPhase total = TimeReport_total(tr);
+    TimeReport_printPhase(&total);
+}
+
+static const char *time_report_counter_names[std_perf_count] = {
+    [std_perf_cycles] = "cycles",
+    [std_perf_instructions] = "instructions",
+    [std_perf_branch_misses] = "branch_misses",
+    [std_perf_l1d_misses] = "l1d_misses",
+    [std_perf_llc_misses] = "llc_misses",
+};
+
+// Print a counter in millions, or - if it is not available.
+static void TimeReport_printCounter(const TimeReport *tr, const TimeReportPhase *ph, StdPerfCounter c)
+{
+    if (tr->counters_available[c]) std_printf(" %10.2f", ph->counters[c] / 1e6);
+    else std_printf(" %10s", "-");
+}
+
+static void TimeReport_printCountersPhase(const TimeReport *tr, const TimeReportPhase *ph)
+{
+    std_printf("%-10s", ph->name);
+    for (uint32_t i = 0; i < std_perf_count; i++) TimeReport_printCounter(tr, ph, i);
+    uint64_t instructions = ph->counters[std_perf_instructions];
+    if (tr->counters_available[std_perf_cycles] && tr->counters_available[std_perf_instructions]
+            && ph->counters[std_perf_cycles]) {
+        std_printf(" %6.2f", (double)instructions / ph->counters[std_perf_cycles]);
+    } else {
+        std_printf(" %6s", "-");
+    }
+    // misses per thousand instructions
+    StdPerfCounter per_ki[] = { std_perf_branch_misses, std_perf_l1d_misses, std_perf_llc_misses };
+    for (uint32_t i = 0; i < 3; i++) {
+        if (tr->counters_available[per_ki[i]] && tr->counters_available[std_perf_instructions] && instructions) {
+            std_printf(" %8.2f", 1000.0 * ph->counters[per_ki[i]] / instructions);
+        } else {
+            std_printf(" %8s", "-");
+        }
+    }
+    std_printf("\n");
+}
+
+static void TimeReport_printCounters(TimeReport *tr)
+{
+    if (!tr->perf) {
+        std_printf("  perf: unavailable (%s)\n", tr->perf_error);
+        return;
+    }
+    std_printf("%-10s %10s %10s %10s %10s %10s %6s %8s %8s %8s\n", "perf", "Mcycles", "Minstr", "Mbr-miss",
+        "ML1d-miss", "MLLC-miss", "IPC", "br/Ki", "L1d/Ki", "LLC/Ki");
+    for (uint32_t i = 0; i < tr->phases_len; i++) TimeReport_printCountersPhase(tr, &tr->phases[i]);
+    TimeReportPhase total = TimeReport_total(tr);
+    TimeReport_printCountersPhase(tr, &total);
+}
+
+static void TimeReport_writeJsonPhase(const TimeReport *tr, void *fh, const TimeReportPhase *ph)
+{
+    std_fprintf(fh, "{\"name\": \"%s\", \"wall_ns\": %llu, \"peak_rss_bytes\": %llu, \"allocs\": %llu, \"alloc_bytes\": %llu",
+        ph->name, (unsigned long long)ph->ns, (unsigned long long)ph->peak_rss,
+        (unsigned long long)ph->allocs, (unsigned long long)ph->alloc_bytes);
+    for (uint32_t i = 0; i < std_perf_count; i++) {
+        if (tr->perf && tr->counters_available[i]) {
+            std_fprintf(fh, ", \"%s\": %llu", time_report_counter_names[i], (unsigned long long)ph->counters[i]);
+        }
+    }
+    std_fprintf(fh, "}");
+}
+
+static void TimeReport_writeJson(TimeReport *tr, const char *filename)
+{
+    void *fh = std_createFile(filename);
+    if (!fh) std_panic("failed to open %s\n", filename);
+    std_fprintf(fh, "{\n  \"phases\": [\n");
+    for (uint32_t i = 0; i < tr->phases_len; i++) {
+        std_fprintf(fh, "    ");
+        TimeReport_writeJsonPhase(tr, fh, &tr->phases[i]);
+        std_fprintf(fh, i + 1 < tr->phases_len ? ",\n" : "\n");
+    }
+    std_fprintf(fh, "  ],\n  \"total\": ");
+    TimeReportPhase total = TimeReport_total(tr);
+    TimeReport_writeJsonPhase(tr, fh, &total);
+    std_fprintf(fh, "\n}\n");
+    std_closeFile(fh);
+}
+
+// End the last phase and output the report.
+static void TimeReport_finish(TimeReport *tr)
+{
+    if (!tr->enabled) return;
+    TimeReport_end(tr);
+    if (tr->print) TimeReport_print(tr);
+    if (tr->perf || tr->perf_error) TimeReport_printCounters(tr);
+    if (tr->json_filename) TimeReport_writeJson(tr, tr->json_filename);
+    if (tr->perf) std_perfClose(tr->perf);
+}
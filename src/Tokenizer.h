@@ -364,6 +364,18 @@ const char* TokenTag_name(TokenTag tag)
     }
 }
 
+// A set of token tags, one bit per tag. The FIRST sets in ParserFirst.h use this layout.
+typedef struct TokenSet {
+    uint64_t bits[2];
+} TokenSet;
+
+typedef char TokenSet_fitsAllTags[token_keyword_while < 128 ? 1 : -1];
+
+static bool TokenSet_has(TokenSet s, TokenTag tag)
+{
+    return (s.bits[tag >> 6] >> (tag & 63)) & 1;
+}
+
 typedef struct TokenLoc {
     uint32_t start;
     uint32_t end;
@@ -384,7 +396,7 @@ typedef struct Keyword {
     TokenTag tag;
 } Keyword;
 
-static Keyword keywords[] = {
+static const Keyword keywords[] = {
     { "addrspace", token_keyword_addrspace },
     { "align", token_keyword_align },
     { "allowzero", token_keyword_allowzero },
@@ -433,22 +445,153 @@ static Keyword keywords[] = {
     { "while", token_keyword_while },
 };
 
+// Perfect hash over keywords[]. The key mixes the first two bytes, last two bytes and length,
+// which is unique for every keyword. The multiplier and keyword_slots come from
+// src/TokenizerKeywords.h, generated by tools/gen_keywords.c (./build.sh keywords).
+static uint32_t Tokenizer_keywordKey(Buffer b)
+{
+    const uint8_t *s = (const uint8_t *)b.data;
+    uint32_t head = (uint32_t)s[0] | (uint32_t)s[1] << 8;
+    uint32_t tail = (uint32_t)s[b.len - 2] << 16 | (uint32_t)s[b.len - 1] << 24;
+    return (head ^ tail) + b.len;
+}
+
+static uint32_t Tokenizer_keywordHash(Buffer b)
+{
+    return Tokenizer_keywordKey(b) * KEYWORD_HASH_MUL >> (32 - KEYWORD_HASH_BITS);
+}
+
 static int Tokenizer_getKeyword(Buffer b)
 {
-    size_t keywords_count = sizeof(keywords) / sizeof(Keyword);
-    for (size_t i = 0; i < keywords_count; i++) {
-        if (Buffer_eql(b, keywords[i].literal)) {
-            return keywords[i].tag;
-        }
+    if (b.len < KEYWORD_MIN_LEN || b.len > KEYWORD_MAX_LEN) return -1;
+
+    uint8_t slot = keyword_slots[Tokenizer_keywordHash(b)];
+    if (slot == 0) return -1;
+
+    const Keyword *kw = &keywords[slot - 1];
+    if (!Buffer_eql(b, kw->literal)) return -1;
+    return kw->tag;
+}
+
+
+// Byte-class scanning.
+//
+// Runs of whitespace, comment bodies and identifier characters make up most of a source
+// file, so these are skipped a vector at a time when the cpu supports it. The implementation
+// is picked once at Tokenizer_init. Vector loads are only issued while a full vector remains
+// before the end of the buffer, the remainder falls back to the scalar loop which stops on
+// the nul sentinel.
+
+typedef enum {
+    char_class_whitespace   = 0x01,
+    char_class_comment      = 0x02,     // any byte allowed in a comment body
+    char_class_identifier   = 0x04,     // identifier continuation
+} TokenizerCharClass;
+
+static const uint8_t Tokenizer_charClass[256] = {
+    ['\t']          = char_class_whitespace,
+    ['\n']          = char_class_whitespace,
+    ['\r']          = char_class_whitespace,
+    [' ']           = char_class_whitespace | char_class_comment,
+    ['!' ... '/']   = char_class_comment,
+    ['0' ... '9']   = char_class_comment | char_class_identifier,
+    [':' ... '@']   = char_class_comment,
+    ['A' ... 'Z']   = char_class_comment | char_class_identifier,
+    ['[' ... '^']   = char_class_comment,
+    ['_']           = char_class_comment | char_class_identifier,
+    ['`']           = char_class_comment,
+    ['a' ... 'z']   = char_class_comment | char_class_identifier,
+    ['{' ... '~']   = char_class_comment,
+    [0x80 ... 0xff] = char_class_comment,
+};
+
+// Returns the index of the first byte at or after i which is not in the class.
+typedef uint32_t (*Tokenizer_SkipFn)(const char *s, uint32_t i, uint32_t len, TokenizerCharClass class);
+
+static uint32_t Tokenizer_skipScalar(const char *s, uint32_t i, uint32_t len, TokenizerCharClass class)
+{
+    (void)len;
+    while (Tokenizer_charClass[(uint8_t)s[i]] & class) i++;
+    return i;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+#define TOKENIZER_SIMD_IMPL(name, target_, vec, width, load, set1, sub, min, cmpeq, or, movemask)    \
+__attribute__((target(target_)))                                                                    \
+static inline vec Tokenizer_##name##InRange(vec v, char lo, char hi)                                \
+{                                                                                                   \
+    vec d = sub(v, set1(lo));                                                                       \
+    return cmpeq(min(d, set1((char)(hi - lo))), d);                                                 \
+}                                                                                                   \
+                                                                                                    \
+/* mask of bytes in the class */                                                                    \
+__attribute__((target(target_)))                                                                    \
+static inline uint32_t Tokenizer_##name##Match(vec v, TokenizerCharClass class)                    \
+{                                                                                                   \
+    switch (class) {                                                                                \
+        case char_class_whitespace:                                                                 \
+            return (uint32_t)movemask(or(or(cmpeq(v, set1(' ')), cmpeq(v, set1('\n'))),            \
+                                         or(cmpeq(v, set1('\t')), cmpeq(v, set1('\r')))));          \
+        case char_class_comment:                                                                    \
+            return ~(uint32_t)movemask(or(Tokenizer_##name##InRange(v, 0x00, 0x1f),                 \
+                                          cmpeq(v, set1(0x7f))));                                   \
+        case char_class_identifier:                                                                 \
+            return (uint32_t)movemask(or(or(Tokenizer_##name##InRange(v, 'a', 'z'),                 \
+                                            Tokenizer_##name##InRange(v, 'A', 'Z')),                \
+                                         or(Tokenizer_##name##InRange(v, '0', '9'),                 \
+                                            cmpeq(v, set1('_')))));                                 \
+    }                                                                                               \
+    return 0;                                                                                       \
+}                                                                                                   \
+                                                                                                    \
+__attribute__((target(target_)))                                                                    \
+static uint32_t Tokenizer_skip##name(const char *s, uint32_t i, uint32_t len, TokenizerCharClass class) \
+{                                                                                                   \
+    const uint32_t all = (uint32_t)((1ull << width) - 1);                                           \
+    while (i + width <= len) {                                                                      \
+        uint32_t miss = ~Tokenizer_##name##Match(load((const vec *)(s + i)), class) & all;         \
+        if (miss) return i + (uint32_t)__builtin_ctz(miss);                                         \
+        i += width;                                                                                 \
+    }                                                                                               \
+    return Tokenizer_skipScalar(s, i, len, class);                                                  \
+}
+
+TOKENIZER_SIMD_IMPL(Sse2, "sse2", __m128i, 16, _mm_loadu_si128, _mm_set1_epi8, _mm_sub_epi8,
+    _mm_min_epu8, _mm_cmpeq_epi8, _mm_or_si128, _mm_movemask_epi8)
+TOKENIZER_SIMD_IMPL(Avx2, "avx2", __m256i, 32, _mm256_loadu_si256, _mm256_set1_epi8, _mm256_sub_epi8,
+    _mm256_min_epu8, _mm256_cmpeq_epi8, _mm256_or_si256, _mm256_movemask_epi8)
+
+#undef TOKENIZER_SIMD_IMPL
+#endif
+
+static Tokenizer_SkipFn Tokenizer_skipImpl = NULL;
+
+static void Tokenizer_initSkip(void)
+{
+    if (Tokenizer_skipImpl) return;
+    Tokenizer_skipImpl = Tokenizer_skipScalar;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        Tokenizer_skipImpl = Tokenizer_skipAvx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        Tokenizer_skipImpl = Tokenizer_skipSse2;
     }
-    return -1;
+#endif
 }
 
+static uint32_t Tokenizer_skip(Tokenizer *t, uint32_t i, TokenizerCharClass class)
+{
+    return Tokenizer_skipImpl(t->buffer.data, i, t->buffer.len, class);
+}
 
 static void Tokenizer_init(Tokenizer *t, Ctx *ctx, Buffer source)
 {
     (void)ctx;
 
+    Tokenizer_initSkip();
     t->buffer = source;
     t->index = (
         (unsigned char)t->buffer.data[0] == 0xef &&
@@ -531,7 +674,8 @@ switch_start:
                 case '\n':
                 case '\t':
                 case '\r':
-                    result.loc.start = ++t->index;
+                    t->index = Tokenizer_skip(t, t->index + 1, char_class_whitespace);
+                    result.loc.start = t->index;
                     CONTINUE(state_start);
 
                 case '"':
@@ -860,6 +1004,7 @@ switch_start:
             break;
 
         case state_identifier:
+            t->index = Tokenizer_skip(t, t->index + 1, char_class_identifier) - 1;
             switch (t->buffer.data[++t->index]) {
                 case 'a' ... 'z':
                 case 'A' ... 'Z':
@@ -878,6 +1023,7 @@ switch_start:
             break;
 
         case state_builtin:
+            t->index = Tokenizer_skip(t, t->index + 1, char_class_identifier) - 1;
             switch (t->buffer.data[++t->index]) {
                 case 'a' ... 'z':
                 case 'A' ... 'Z':
@@ -1325,6 +1471,7 @@ switch_start:
             break;
 
         case state_line_comment:
+            t->index = Tokenizer_skip(t, t->index + 1, char_class_comment) - 1;
             switch (t->buffer.data[++t->index]) {
                 case 0:
                     if (t->index != t->buffer.len) {
@@ -1353,6 +1500,7 @@ switch_start:
             break;
 
         case state_doc_comment:
+            t->index = Tokenizer_skip(t, t->index + 1, char_class_comment) - 1;
             switch (t->buffer.data[++t->index]) {
                 case 0:
                 case '\n':
@@ -1479,3 +1627,250 @@ switch_start:
    result.loc.end = t->index;
    return result;
 }
+
+// Re-lex the token starting at `start` to recover its end offset.
+static uint32_t Tokenizer_tokenEnd(Buffer source, uint32_t start)
+{
+    Tokenizer t = { .buffer = source, .index = start };
+    return Tokenizer_next(&t).loc.end;
+}
+
+// Token stream stored as struct-of-arrays. Tags fit in a byte and end offsets are not stored,
+// they are recomputed with Tokenizer_tokenEnd when a token slice is needed.
+#define TOKEN_MATCH_NONE UINT32_MAX
+
+typedef struct TokenList {
+    uint8_t *tags;
+    uint32_t *starts;
+    uint32_t len;
+    uint32_t cap;
+
+    // Brace matching, only maintained after TokenList_trackBraces.
+    uint32_t *match;        // index of the '}' closing each '{', TOKEN_MATCH_NONE otherwise
+    uint32_t match_cap;
+    uint32_t matched;       // tokens scanned so far
+    uint32_t *open;         // stack of '{' not closed yet
+    uint32_t open_len;
+    uint32_t open_cap;
+} TokenList;
+
+static void TokenList_init(TokenList *l)
+{
+    l->len = 0;
+    l->cap = 64;
+    l->tags = std_malloc(sizeof(uint8_t) * l->cap);
+    l->starts = std_malloc(sizeof(uint32_t) * l->cap);
+    if (!l->tags || !l->starts) std_panic("oom");
+    l->match = NULL;
+    l->match_cap = 0;
+    l->matched = 0;
+    l->open = NULL;
+    l->open_len = 0;
+    l->open_cap = 0;
+}
+
+static uint32_t TokenList_append(TokenList *l, Token token)
+{
+    assume(token.tag <= UINT8_MAX);
+    if (l->len + 1 >= l->cap) {
+        l->cap *= 2;
+        uint8_t *tags = std_realloc(l->tags, sizeof(uint8_t) * l->cap);
+        uint32_t *starts = std_realloc(l->starts, sizeof(uint32_t) * l->cap);
+        if (!tags || !starts) std_panic("oom");
+        l->tags = tags;
+        l->starts = starts;
+    }
+    uint32_t id = l->len++;
+    l->tags[id] = (uint8_t)token.tag;
+    l->starts[id] = token.loc.start;
+    return id;
+}
+
+static void TokenList_trackBraces(TokenList *l)
+{
+    l->match_cap = l->cap;
+    l->match = std_malloc(sizeof(uint32_t) * l->match_cap);
+    l->open_cap = 64;
+    l->open = std_malloc(sizeof(uint32_t) * l->open_cap);
+    if (!l->match || !l->open) std_panic("oom");
+}
+
+// Extend the brace table over the tokens appended since the last call. Each '{' is resolved as
+// soon as its '}' is lexed, so lookups afterwards are a single load.
+static void TokenList_matchBraces(TokenList *l)
+{
+    if (!l->match || l->matched == l->len) return;
+    if (l->match_cap < l->cap) {
+        l->match_cap = l->cap;
+        l->match = std_realloc(l->match, sizeof(uint32_t) * l->match_cap);
+        if (!l->match) std_panic("oom");
+    }
+
+    for (uint32_t i = l->matched; i < l->len; i++) {
+        l->match[i] = TOKEN_MATCH_NONE;
+        if (l->tags[i] == token_l_brace) {
+            if (l->open_len == l->open_cap) {
+                l->open_cap *= 2;
+                l->open = std_realloc(l->open, sizeof(uint32_t) * l->open_cap);
+                if (!l->open) std_panic("oom");
+            }
+            l->open[l->open_len++] = i;
+        } else if (l->tags[i] == token_r_brace && l->open_len != 0) {
+            l->match[l->open[--l->open_len]] = i;
+        }
+    }
+    l->matched = l->len;
+}
+
+// Tokens never span a newline, so the source can be split after any '\n' and each part lexed
+// independently. Every chunk tokenizer walks the full buffer from its own start offset, which
+// keeps lexing identical to the serial path and leaves token offsets absolute.
+#define TOKENIZER_CHUNK_MIN (256 * 1024)    // smaller chunks are not worth a thread
+
+typedef struct TokenizerChunk {
+    Buffer source;
+    uint32_t start;
+    uint32_t end;
+    TokenList tokens;
+} TokenizerChunk;
+
+// Lex all tokens starting in [start, end), stopping early on eof or an invalid token.
+static void Tokenizer_tokenizeChunk(void *arg)
+{
+    TokenizerChunk *c = arg;
+    Tokenizer t;
+    Tokenizer_init(&t, NULL, c->source);
+    if (c->start != 0) t.index = c->start;
+
+    while (true) {
+        Token token = Tokenizer_next(&t);
+        if (token.tag != token_eof && token.loc.start >= c->end) break;
+        TokenList_append(&c->tokens, token);
+        if (token.tag == token_eof || token.tag == token_invalid) break;
+    }
+}
+
+// Tokenize source into l using up to threads workers. The list always ends with the first eof
+// or invalid token, exactly as a single Tokenizer_next loop would produce it.
+static void Tokenizer_tokenize(TokenList *l, Ctx *ctx, Buffer source, uint32_t threads)
+{
+    if (threads > source.len / TOKENIZER_CHUNK_MIN) threads = source.len / TOKENIZER_CHUNK_MIN;
+    if (threads <= 1) {
+        Tokenizer t;
+        Tokenizer_init(&t, ctx, source);
+        while (true) {
+            Token token = Tokenizer_next(&t);
+            TokenList_append(l, token);
+            if (token.tag == token_eof || token.tag == token_invalid) break;
+        }
+        return;
+    }
+
+    // The skip implementation is selected lazily, do it before any worker can race on it.
+    Tokenizer_initSkip();
+
+    TokenizerChunk *chunks = std_malloc(sizeof(TokenizerChunk) * threads);
+    void **workers = std_malloc(sizeof(void*) * threads);
+    if (!chunks || !workers) std_panic("oom");
+
+    uint32_t chunks_len = 0;
+    uint32_t start = 0;
+    for (uint32_t i = 0; i < threads && start < source.len; i++) {
+        uint32_t end = source.len;
+        if (i + 1 < threads) {
+            end = start + (source.len - start) / (threads - i);
+            while (end < source.len && source.data[end - 1] != '\n') end++;
+        }
+        TokenizerChunk *c = &chunks[chunks_len++];
+        c->source = source;
+        c->start = start;
+        c->end = end;
+        TokenList_init(&c->tokens);
+        start = end;
+    }
+
+    // chunk 0 runs on this thread
+    for (uint32_t i = 1; i < chunks_len; i++) {
+        workers[i] = std_threadSpawn(Tokenizer_tokenizeChunk, &chunks[i]);
+        if (!workers[i]) Tokenizer_tokenizeChunk(&chunks[i]);
+    }
+    Tokenizer_tokenizeChunk(&chunks[0]);
+    for (uint32_t i = 1; i < chunks_len; i++) {
+        if (workers[i]) std_threadJoin(workers[i]);
+    }
+
+    bool done = false;
+    for (uint32_t i = 0; i < chunks_len; i++) {
+        TokenList *c = &chunks[i].tokens;
+        if (!done) {
+            if (l->len + c->len >= l->cap) {
+                while (l->len + c->len >= l->cap) l->cap *= 2;
+                uint8_t *tags = std_realloc(l->tags, sizeof(uint8_t) * l->cap);
+                uint32_t *starts = std_realloc(l->starts, sizeof(uint32_t) * l->cap);
+                if (!tags || !starts) std_panic("oom");
+                l->tags = tags;
+                l->starts = starts;
+            }
+            std_memcpy(l->tags + l->len, c->tags, sizeof(uint8_t) * c->len);
+            std_memcpy(l->starts + l->len, c->starts, sizeof(uint32_t) * c->len);
+            l->len += c->len;
+            done = c->len != 0 && (c->tags[c->len - 1] == token_eof || c->tags[c->len - 1] == token_invalid);
+        }
+        std_free(c->tags);
+        std_free(c->starts);
+    }
+
+    std_free(workers);
+    std_free(chunks);
+}
+
+// TokenStream lexes on demand, so the parser can start before the whole source is tokenized.
+// Lexed tokens are appended to a TokenList and kept, as the Ast refers to them by index. A
+// parser checkpoint is therefore just a token index and restoring one never re-lexes.
+#define TOKEN_STREAM_WINDOW 512     // tokens lexed ahead of the requested one per refill
+
+typedef struct TokenStream {
+    Tokenizer t;
+    TokenList *tokens;
+    bool done;      // the final eof or invalid token has been appended
+} TokenStream;
+
+static void TokenStream_init(TokenStream *s, Ctx *ctx, Buffer source, TokenList *tokens)
+{
+    Tokenizer_init(&s->t, ctx, source);
+    s->tokens = tokens;
+    s->done = false;
+}
+
+// Lex until token index is available, or the stream is exhausted.
+static void TokenStream_fill(TokenStream *s, uint32_t index)
+{
+    uint32_t target = index > UINT32_MAX - TOKEN_STREAM_WINDOW ? UINT32_MAX : index + TOKEN_STREAM_WINDOW;
+    while (!s->done && s->tokens->len <= target) {
+        Token token = Tokenizer_next(&s->t);
+        TokenList_append(s->tokens, token);
+        s->done = token.tag == token_eof || token.tag == token_invalid;
+    }
+    TokenList_matchBraces(s->tokens);
+}
+
+// Lex the remainder of the source up front. A stream that has not started yet may be
+// tokenized by multiple threads.
+static void TokenStream_finish(TokenStream *s, Ctx *ctx, uint32_t threads)
+{
+    if (!s->done && s->tokens->len == 0) {
+        Tokenizer_tokenize(s->tokens, ctx, s->t.buffer, threads);
+        s->done = true;
+    }
+    TokenStream_fill(s, UINT32_MAX);
+}
+
+// Index of the '}' closing the '{' at index, lexing ahead until it is seen. Returns
+// TOKEN_MATCH_NONE if the brace is never closed. The list must track braces.
+static uint32_t TokenStream_matchBrace(TokenStream *s, uint32_t index)
+{
+    TokenList *l = s->tokens;
+    assume(l->match && index < l->matched);
+    while (l->match[index] == TOKEN_MATCH_NONE && !s->done) TokenStream_fill(s, l->len);
+    return l->match[index];
+}
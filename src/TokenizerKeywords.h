@@ -0,0 +1,19 @@
+// Generated by tools/gen_keywords.c from keywords[] in src/Tokenizer.h, do not edit.
+//
+// The top 7 bits of Tokenizer_keywordKey * KEYWORD_HASH_MUL differ for every keyword.
+// keyword_slots holds the keywords[] index + 1 of each hash, 0 if no keyword has it.
+#define KEYWORD_MIN_LEN 2
+#define KEYWORD_MAX_LEN 11
+#define KEYWORD_HASH_MUL 0x5244482du
+#define KEYWORD_HASH_BITS 7
+
+static const uint8_t keyword_slots[1 << KEYWORD_HASH_BITS] = {
+    37,  9,  0,  0,  0,  0, 29, 41,  4,  0,  0,  6,  0,  0,  0, 23,
+    36,  0, 44,  0,  0,  0, 42, 30,  0, 14,  0, 28,  0, 16,  0,  0,
+     0,  0,  0,  0,  0, 26, 45,  0, 39,  0,  0,  0,  0,  0,  0,  0,
+    32,  0,  7,  1,  0,  0,  0,  0, 27,  0,  0,  0, 11,  0, 10,  0,
+     0,  0,  3,  0,  0,  0,  0,  0,  5,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  8,  0, 43, 22,  0,  0,  0,  0, 15, 13,  0,  0,
+     0,  0, 25, 24,  0, 46, 18,  0, 38,  0,  0, 12, 31, 21,  0, 20,
+    35, 40,  0,  0,  0,  0, 19,  0,  0, 17,  2,  0,  0, 34, 33,  0,
+};
@@ -0,0 +1,137 @@
+// Trace records timed spans of compiler activity for -trace-file, written out at exit as Chrome
+// trace-event JSON (chrome://tracing, ui.perfetto.dev).
+//
+// Each thread appends to its own TraceBuffer, so recording takes no locks. Buffers are made of
+// fixed-size chunks that are never moved, and the events are only formatted when the trace is
+// written. All functions accept a NULL buffer and then do nothing, which is how tracing is off.
+#define TRACE_CHUNK_EVENTS 1024
+
+typedef enum TraceArg {
+    trace_arg_none,
+    trace_arg_intern,   // value is an sInternId
+    trace_arg_source,   // value and len are a byte range of the source
+} TraceArg;
+
+typedef struct TraceEvent {
+    uint64_t start_ns;
+    uint64_t end_ns;
+    const char *name;
+    uint32_t value;
+    uint32_t len;
+    uint8_t arg;        // TraceArg
+} TraceEvent;
+
+typedef struct TraceChunk {
+    struct TraceChunk *next;
+    uint32_t len;
+    TraceEvent events[TRACE_CHUNK_EVENTS];
+} TraceChunk;
+
+typedef struct TraceBuffer {
+    struct Trace *trace;
+    struct TraceBuffer *next;   // in Trace.buffers
+    const char *thread_name;
+    uint32_t tid;
+    TraceChunk *head;
+    TraceChunk *tail;
+} TraceBuffer;
+
+typedef struct Trace {
+    uint64_t start_ns;
+    TraceBuffer *buffers;
+    uint32_t buffers_len;
+} Trace;
+
+static void Trace_init(Trace *t)
+{
+    t->start_ns = std_timeNs();
+    t->buffers = NULL;
+    t->buffers_len = 0;
+}
+
+// Buffers are only created by the main thread, before the thread that uses them starts.
+static TraceBuffer* Trace_newBuffer(Trace *t, const char *thread_name)
+{
+    TraceBuffer *b = std_malloc(sizeof(TraceBuffer));
+    if (!b) std_panic("oom");
+    *b = (TraceBuffer){
+        .trace = t,
+        .thread_name = thread_name,
+        .tid = ++t->buffers_len,
+    };
+    TraceBuffer **tail = &t->buffers;
+    while (*tail) tail = &(*tail)->next;
+    *tail = b;
+    return b;
+}
+
+static uint64_t Trace_begin(TraceBuffer *b)
+{
+    return b ? std_timeNs() : 0;
+}
+
+// Record a span that started at start, from Trace_begin.
+static void Trace_end(TraceBuffer *b, uint64_t start, const char *name, TraceArg arg, uint32_t value, uint32_t len)
+{
+    if (!b) return;
+    uint64_t end = std_timeNs();
+    if (!b->tail || b->tail->len == TRACE_CHUNK_EVENTS) {
+        TraceChunk *c = std_malloc(sizeof(TraceChunk));
+        if (!c) std_panic("oom");
+        c->next = NULL;
+        c->len = 0;
+        if (b->tail) b->tail->next = c;
+        else b->head = c;
+        b->tail = c;
+    }
+    b->tail->events[b->tail->len++] = (TraceEvent){
+        .start_ns = start,
+        .end_ns = end,
+        .name = name,
+        .value = value,
+        .len = len,
+        .arg = arg,
+    };
+}
+
+static void Trace_writeString(void *fh, Buffer s)
+{
+    std_fprintf(fh, "\"");
+    for (uint32_t i = 0; i < s.len; i++) {
+        unsigned char c = (unsigned char)s.data[i];
+        if (c == '"' || c == '\\') std_fprintf(fh, "\\%c", c);
+        else if (c < 0x20) std_fprintf(fh, "\\u%04x", c);
+        else std_fprintf(fh, "%c", c);
+    }
+    std_fprintf(fh, "\"");
+}
+
+static void Trace_write(Trace *t, const char *filename, Ctx *ctx, Buffer source)
+{
+    void *fh = std_createFile(filename);
+    if (!fh) std_panic("failed to open %s\n", filename);
+    std_fprintf(fh, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+    for (TraceBuffer *b = t->buffers; b; b = b->next) {
+        std_fprintf(fh, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+            first ? "" : ",\n", b->tid, b->thread_name);
+        first = false;
+        for (TraceChunk *c = b->head; c; c = c->next) {
+            for (uint32_t i = 0; i < c->len; i++) {
+                const TraceEvent *e = &c->events[i];
+                std_fprintf(fh, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f",
+                    e->name, b->tid, (e->start_ns - t->start_ns) / 1e3, (e->end_ns - e->start_ns) / 1e3);
+                if (e->arg != trace_arg_none) {
+                    Buffer s = e->arg == trace_arg_intern ? Ctx_getString(ctx, e->value)
+                                                          : Buffer_slice(source, e->value, e->value + e->len);
+                    std_fprintf(fh, ", \"args\": {\"name\": ");
+                    Trace_writeString(fh, s);
+                    std_fprintf(fh, "}");
+                }
+                std_fprintf(fh, "}");
+            }
+        }
+    }
+    std_fprintf(fh, "\n]}\n");
+    std_closeFile(fh);
+}
@@ -40,6 +40,148 @@ static void TypeName##Array_appendMany(TypeName##Array *a, Type *tags, size_t ta
     }                                                                         \
 }
 
+// Arena is a chunked bump allocator. Allocations are freed all at once, or back to a previous
+// mark with Arena_reset. Chunks start small and double up to ARENA_CHUNK_SIZE, so an arena per
+// small object is cheap.
+#define ARENA_FIRST_CHUNK_SIZE (1024)
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#define ARENA_ALIGN 8
+
+typedef struct ArenaChunk {
+    struct ArenaChunk *prev;
+    size_t used;
+    size_t cap;
+    char data[];
+} ArenaChunk;
+
+typedef struct Arena {
+    ArenaChunk *head;
+    ArenaChunk *spare;  // last chunk released by Arena_reset, avoids thrashing across a chunk boundary
+} Arena;
+
+typedef struct ArenaMark {
+    ArenaChunk *chunk;
+    size_t used;
+} ArenaMark;
+
+__attribute__((unused))
+static void Arena_init(Arena *a)
+{
+    a->head = NULL;
+    a->spare = NULL;
+}
+
+__attribute__((unused))
+static void* Arena_alloc(Arena *a, size_t size)
+{
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (!a->head || a->head->used + size > a->head->cap) {
+        ArenaChunk *c = a->spare;
+        if (c && c->cap >= size) {
+            a->spare = NULL;
+        } else {
+            size_t cap = a->head ? 2 * a->head->cap : ARENA_FIRST_CHUNK_SIZE;
+            if (cap > ARENA_CHUNK_SIZE) cap = ARENA_CHUNK_SIZE;
+            if (cap < size) cap = size;
+            c = std_malloc(sizeof(ArenaChunk) + cap);
+            if (!c) std_panic("oom");
+            c->cap = cap;
+        }
+        c->prev = a->head;
+        c->used = 0;
+        a->head = c;
+    }
+    void *ptr = a->head->data + a->head->used;
+    a->head->used += size;
+    return ptr;
+}
+
+// Resize an allocation, in place if it is the last one made from the arena.
+__attribute__((unused))
+static void* Arena_grow(Arena *a, void *ptr, size_t old_size, size_t new_size)
+{
+    old_size = (old_size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    new_size = (new_size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    bool is_last = ptr && a->head->used >= old_size && a->head->data + a->head->used - old_size == (char*)ptr;
+    if (is_last && a->head->used - old_size + new_size <= a->head->cap) {
+        a->head->used += new_size - old_size;
+        return ptr;
+    }
+    // the old space stays valid until the copy, as it is never in the chunk allocated from
+    if (is_last) a->head->used -= old_size;
+    void *n = Arena_alloc(a, new_size);
+    if (ptr) std_memcpy(n, ptr, old_size);
+    return n;
+}
+
+__attribute__((unused))
+static ArenaMark Arena_mark(Arena *a)
+{
+    return (ArenaMark){ .chunk = a->head, .used = a->head ? a->head->used : 0 };
+}
+
+// Free everything allocated since the mark was taken.
+__attribute__((unused))
+static void Arena_reset(Arena *a, ArenaMark m)
+{
+    while (a->head != m.chunk) {
+        ArenaChunk *prev = a->head->prev;
+        if (a->spare) std_free(a->spare);
+        a->spare = a->head;
+        a->head = prev;
+    }
+    if (a->head) a->head->used = m.used;
+}
+
+__attribute__((unused))
+static void Arena_deinit(Arena *a)
+{
+    Arena_reset(a, (ArenaMark){ .chunk = NULL, .used = 0 });
+    if (a->spare) std_free(a->spare);
+    a->spare = NULL;
+}
+
+// ArenaArray is an Array allocated from an arena, which frees it along with everything else there.
+#define DEFINE_ARENA_ARRAY(Type) DEFINE_ARENA_ARRAY_NAMED(Type, Type)
+#define DEFINE_ARENA_ARRAY_NAMED(Type, TypeName)                              \
+typedef struct TypeName##Array {                                              \
+    Type *data;                                                               \
+    uint32_t len;                                                             \
+    uint32_t cap;                                                             \
+    Arena *arena;                                                             \
+} TypeName##Array;                                                            \
+                                                                              \
+static void TypeName##Array_init(TypeName##Array *a, Arena *arena)            \
+{                                                                             \
+    a->len = 0;                                                               \
+    a->cap = 8;                                                               \
+    a->arena = arena;                                                         \
+    a->data = Arena_alloc(arena, sizeof(Type) * a->cap);                      \
+}                                                                             \
+static void TypeName##Array_reserve(TypeName##Array *a, size_t len)           \
+{                                                                             \
+    uint32_t cap = a->cap;                                                    \
+    while (len >= cap) cap *= 2;                                              \
+    if (cap == a->cap) return;                                                \
+    a->data = Arena_grow(a->arena, a->data, sizeof(Type) * a->cap, sizeof(Type) * cap); \
+    a->cap = cap;                                                             \
+}                                                                             \
+static uint32_t TypeName##Array_append(TypeName##Array *a, Type tag)          \
+{                                                                             \
+    TypeName##Array_reserve(a, a->len + 1);                                   \
+    uint32_t id = a->len++;                                                   \
+    a->data[id] = tag;                                                        \
+    return id;                                                                \
+}                                                                             \
+__attribute__((unused))                                                       \
+static void TypeName##Array_appendMany(TypeName##Array *a, Type *tags, size_t tags_len)   \
+{                                                                             \
+    TypeName##Array_reserve(a, a->len + tags_len);                            \
+    for (size_t i = 0; i < tags_len; i++) {                                   \
+        a->data[a->len++] = tags[i];                                          \
+    }                                                                         \
+}
+
 // Buffer contains a null-terminated string along with its length.
 typedef struct Buffer {
     char *data;
@@ -79,10 +221,15 @@ static bool Buffer_eqlBuffer(Buffer b, Buffer c)
     return true;
 }
 
+// The file is mapped rather than copied where possible. Either way the data is nul-terminated.
 static Buffer Buffer_fromFile(const char *filename)
 {
+    size_t mapped_size;
+    char *source = std_mapFile(filename, &mapped_size);
+    if (source) return (Buffer){ .data = source, .len = mapped_size };
+
     long fsize;
-    char *source = std_readFile(filename, &fsize);
+    source = std_readFile(filename, &fsize);
     if (!source) std_panic("failed to read file: %s", filename);
 
     return (Buffer){ .data = source, .len = fsize };
@@ -2,11 +2,19 @@
 #include "core.h"
 
 #include "Ctx.h"
+#include "Trace.h"
+#include "TokenizerKeywords.h"
 #include "Tokenizer.h"
+#include "ParserFirst.h"
 #include "Parser.h"
 #include "Sema.h"
 #include "Ir.h"
+#include "IrCfg.h"
+#include "IrSsa.h"
+#include "IrSccp.h"
+#include "IrSimplify.h"
 #include "CodeGen.h"
+#include "TimeReport.h"
 
 #include "DebugAst.h"
 #include "DebugIr.h"
@@ -17,18 +25,17 @@ bool strequal(const char *a, const char *b)
     return *a == 0 && *b == 0;
 }
 
-DEFINE_ARRAY(Token)
-
 int main(int argc, char **argv)
 {
-    if (sizeof(Node) != 64) std_panic("sizeof(Node) != 64: = %zu\n", sizeof(Node));
+    if (sizeof(Node) != 28) std_panic("sizeof(Node) != 28: = %zu\n", sizeof(Node));
+    if (sizeof(IrInst) != 16) std_panic("sizeof(IrInst) != 16: = %zu\n", sizeof(IrInst));
 
     if (argc < 2) {
-        std_printf("tzc [-no-emit-bin|-tokens|-ast] -o <file> -lib <zig_lib_dir> <input>\n");
+        std_printf("tzc [-no-emit-bin|-tokens|-ast] [-j <threads>] [-lazy] [-memo] [-parse-profile] [-time-report] [-time-report-json <file>] [-trace-file <file>] -o <file> -lib <zig_lib_dir> <input>\n");
         std_exit(1);
     }
 
-    Buffer source = Buffer_empty();
+    const char *input = NULL;
     const char *out_filename = NULL;
     const char *lib_dir = NULL;
     bool emit_tokens = false;
@@ -36,22 +43,47 @@ int main(int argc, char **argv)
     bool emit_ir = false;
     bool no_emit_bin = false;
     bool report = false;
+    bool lazy = false;
+    bool memo = false;
+    bool parse_profile = false;
+    bool time_report = false;
+    const char *time_report_json = NULL;
+    const char *trace_file = NULL;
+    uint32_t threads = 1;
     for (int i = 1; i < argc; i++) {
         if (argv[i][0] != '-') {
-            if (source.len != 0) std_panic("multiple files provided\n");
-            source = Buffer_fromFile(argv[i]);
+            if (input) std_panic("multiple files provided\n");
+            input = argv[i];
         } else if (strequal(argv[i], "-lib")) {
             if (++i >= argc) std_panic("missing parameter for -lib\n");
             lib_dir = argv[i];
         } else if (strequal(argv[i], "-o")) {
             if (++i >= argc) std_panic("missing parameter for -o\n");
             out_filename = argv[i];
+        } else if (strequal(argv[i], "-j")) {
+            if (++i >= argc) std_panic("missing parameter for -j\n");
+            threads = (uint32_t)Buffer_toInt((Buffer){ .data = argv[i], .len = std_strlen(argv[i]) }, 10);
+            if (threads == 0) threads = std_cpuCount();
         } else if (strequal(argv[i], "-tokens")) {
             emit_tokens = true;
         } else if (strequal(argv[i], "-ast")) {
             emit_ast = true;
         } else if (strequal(argv[i], "-ir")) {
             emit_ir = true;
+        } else if (strequal(argv[i], "-lazy")) {
+            lazy = true;
+        } else if (strequal(argv[i], "-memo")) {
+            memo = true;
+        } else if (strequal(argv[i], "-parse-profile")) {
+            parse_profile = true;
+        } else if (strequal(argv[i], "-time-report")) {
+            time_report = true;
+        } else if (strequal(argv[i], "-time-report-json")) {
+            if (++i >= argc) std_panic("missing parameter for -time-report-json\n");
+            time_report_json = argv[i];
+        } else if (strequal(argv[i], "-trace-file")) {
+            if (++i >= argc) std_panic("missing parameter for -trace-file\n");
+            trace_file = argv[i];
         } else if (strequal(argv[i], "-report")) {
             report = true;
         } else if (strequal(argv[i], "-no-emit-bin")) {
@@ -63,58 +95,120 @@ int main(int argc, char **argv)
     if (!no_emit_bin && !lib_dir) std_panic("-lib <zig_lib_dir> is required\n");
     if (!no_emit_bin && !out_filename) std_panic("-o <file> is required\n"); // just append .c to input file
 
+    Trace trace;
+    Trace_init(&trace);
+    TraceBuffer *main_trace = trace_file ? Trace_newBuffer(&trace, "main") : NULL;
+
+    TimeReport tr;
+    TimeReport_init(&tr, time_report, time_report_json, main_trace);
+    if (report) TimeReport_enableCounters(&tr);
+
+    TimeReport_begin(&tr, "read");
+    Buffer source = input ? Buffer_fromFile(input) : Buffer_empty();
+
+    TimeReport_begin(&tr, "tokenize");
     Ctx ctx;
     Ctx_init(&ctx);
 
-    TokenArray tokens;
-    TokenArray_init(&tokens);
+    TokenList tokens;
+    TokenList_init(&tokens);
+    if (lazy) TokenList_trackBraces(&tokens);
 
-    Tokenizer t;
-    Tokenizer_init(&t, &ctx, source);
-    while (true) {
-        Token token = Tokenizer_next(&t);
-        TokenArray_append(&tokens, token);
-        if (token.tag == token_eof || token.tag == token_invalid) break;
-    }
+    // Tokens are lexed as the parser asks for them, unless all are needed up front. Only then does
+    // lexing count towards the tokenize phase rather than the parse phase.
+    TokenStream stream;
+    TokenStream_init(&stream, &ctx, source, &tokens);
+    if (emit_tokens || threads > 1) TokenStream_finish(&stream, &ctx, threads);
     if (emit_tokens) {
+        TimeReport_end(&tr);
         for (uint32_t i = 0; i < tokens.len; i++) {
-            Token token = tokens.data[i];
-            std_printf("|%u: %s: "PRIb"\n", i, TokenTag_name(token.tag), Buffer(Buffer_slice(source, token.loc.start, token.loc.end)));
+            uint32_t start = tokens.starts[i];
+            Buffer slice = Buffer_slice(source, start, Tokenizer_tokenEnd(source, start));
+            std_printf("|%u: %s: "PRIb"\n", i, TokenTag_name(tokens.tags[i]), Buffer(slice));
         }
+        TimeReport_finish(&tr);
+        if (trace_file) Trace_write(&trace, trace_file, &ctx, source);
         return 0;
     }
 
+    TimeReport_begin(&tr, "parse");
     Parser p;
-    Parser_init(&p, &ctx, source, tokens.data, tokens.len);
-    Node *root = Parser_parse(&p);
+    Parser_init(&p, &ctx, source, &stream, threads);
+    if (memo) Parser_enableMemo(&p);
+    if (parse_profile) Parser_enableProfile(&p);
+    p.trace = main_trace;
+    Ast *ast = Parser_parse(&p);
+    TimeReport_end(&tr);
 
     if (emit_ast) {
         DebugAst r;
-        DebugAst_init(&r, &p);
-        DebugAst_render(&r, root);
+        DebugAst_init(&r, ast);
+        DebugAst_render(&r, ast->root);
+        if (parse_profile) ParserProfile_print(p.profile);
+        TimeReport_finish(&tr);
+        if (trace_file) Trace_write(&trace, trace_file, &ctx, source);
         return 0;
     }
 
+    // With -lazy this also parses the function bodies that were skipped.
+    TimeReport_begin(&tr, "lower");
     Ir ir;
     Ir_init(&ir, &ctx);
-    IrProgram *ir_p = Ir_lower(&ir, root);
+    ir.trace = main_trace;
+    IrProgram *ir_p = Ir_lower(&ir, &p);
+
+    TimeReport_begin(&tr, "opt");
+    IrSsa_construct(ir_p);
+    IrSccp_run(ir_p);
+    IrSimplify_run(ir_p);
+    TimeReport_end(&tr);
 
     if (emit_ir) {
         DebugIr r;
         DebugIr_init(&r, &ctx);
         DebugIr_render(&r, ir_p);
+        if (parse_profile) ParserProfile_print(p.profile);
+        TimeReport_finish(&tr);
+        if (trace_file) Trace_write(&trace, trace_file, &ctx, source);
         return 0;
     }
 
     if (report) {
-        std_printf("tokens: size=%2.fKiB, count=%zu\n", (float) tokens.len * sizeof(Token) / 1024, tokens.len);
-        std_printf(" nodes: size=%2.fKiB, count=%zu\n", (float) p.nodes_count * sizeof(Node) / 1024, p.nodes_count);
-        std_printf("    ir: size=%2.fKiB, count=%zu\n", (float) ir.ir_count * sizeof(IrInst) / 1024, ir.ir_count);
+        std_printf("tokens: size=%2.fKiB, count=%zu\n", (float) tokens.len * (sizeof(uint8_t) + sizeof(uint32_t)) / 1024, tokens.len);
+        std_printf(" nodes: size=%2.fKiB, count=%u, discarded=%u\n", (float) ast->nodes.len * sizeof(Node) / 1024, ast->nodes.len - 1, p.nodes_discarded);
+        std_printf(" extra: size=%2.fKiB, count=%u\n", (float) ast->extra.len * sizeof(uint32_t) / 1024, ast->extra.len);
+        if (lazy) {
+            uint32_t skipped = 0;
+            for (uint32_t i = 0; i < ast->nodes.len; i++) skipped += ast->nodes.data[i].tag == node_lazy_block;
+            std_printf("  lazy: parsed=%u, skipped=%u\n", p.lazy_parsed, skipped);
+        }
+        if (memo) {
+            std_printf("  memo: entries=%u, size=%2.fKiB\n", p.memo->len, (float) p.memo->cap * sizeof(ParserMemoEntry) / 1024);
+            for (uint32_t i = 0; i < parser_rule_count; i++) {
+                std_printf("        %s: hits=%u, misses=%u\n", parser_rule_names[i], p.memo->hits[i], p.memo->misses[i]);
+            }
+        }
+        size_t ir_bytes = ir.ir_count * sizeof(IrInst) + ir.extra_count * sizeof(uint32_t);
+        std_printf("    ir: size=%2.fKiB, count=%zu, extra=%zu, bytes/inst=%.1f\n", (float) ir_bytes / 1024, ir.ir_count,
+            ir.extra_count, ir.ir_count ? (double) ir_bytes / ir.ir_count : 0.0);
+        std_printf("  strs: count=%u, slots=%u, probe_avg=%.2f, probe_max=%u\n",
+            ctx.strings.entries.len, ctx.strings.slots_cap,
+            ctx.strings.lookups ? (double) ctx.strings.probes / ctx.strings.lookups : 0.0, ctx.strings.max_probe);
     }
 
     if (!no_emit_bin) {
+        TimeReport_begin(&tr, "codegen");
         CodeGen cg;
         CodeGen_init(&cg, &ctx, out_filename, lib_dir);
+        cg.trace = main_trace;
+        IrSsa_destruct(ir_p);
         CodeGen_gen(&cg, ir_p);
+        TimeReport_begin(&tr, "write");
+        CodeGen_finish(&cg);
     }
+
+    // after lowering, which parses the function bodies skipped with -lazy
+    if (parse_profile) ParserProfile_print(p.profile);
+    TimeReport_finish(&tr);
+    if (trace_file) Trace_write(&trace, trace_file, &ctx, source);
 }
@@ -49,4 +49,18 @@ size_t std_strlen(const char *s)
     size_t i = 0;
     while (*s++) i++;
     return i;
+}
+
+// Cycle counter for profiling, 0 where there is none.
+uint64_t std_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    uint64_t t;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(t));
+    return t;
+#else
+    return 0;
+#endif
 }
\ No newline at end of file
@@ -19,9 +19,33 @@ void _Noreturn std_exit(int);
 int std_vfprintf(void*, const char *fmt, va_list args);
 void* std_realloc(void*, size_t);
 void* std_malloc(size_t);
+void std_free(void*);
+void std_allocStats(uint64_t *count, uint64_t *bytes);
 char* std_readFile(const char *filename, long *fsize);
+char* std_mapFile(const char *filename, size_t *fsize);
+void std_unmapFile(char *data, size_t fsize);
 void* std_createFile(const char *filename);
 size_t std_writeFile(void *ptr, size_t size, size_t nitems, void *fh);
+void std_closeFile(void *fh);
+void* std_threadSpawn(void (*fn)(void*), void *arg);
+void std_threadJoin(void *thread);
+uint32_t std_cpuCount(void);
+uint64_t std_timeNs(void);
+uint64_t std_peakRss(void);
+
+// Hardware counters of this process and the threads it starts, see std_perfOpen.
+typedef enum StdPerfCounter {
+    std_perf_cycles,
+    std_perf_instructions,
+    std_perf_branch_misses,
+    std_perf_l1d_misses,
+    std_perf_llc_misses,
+    std_perf_count,
+} StdPerfCounter;
+
+void* std_perfOpen(const char **error);
+void std_perfRead(void *perf, uint64_t values[std_perf_count], bool available[std_perf_count]);
+void std_perfClose(void *perf);
 
 // generic implementations in os.c
 void* std_memcpy(void *to, const void *from, size_t bytes);
@@ -29,4 +53,5 @@ size_t std_strlen(const char *s);
 void _Noreturn std_panic(const char *fmt, ...);
 int std_printf(const char *fmt, ...);
 int std_fprintf(void *fd, const char *fmt, ...);
-int std_vprintf(const char *fmt, va_list args);
\ No newline at end of file
+int std_vprintf(const char *fmt, va_list args);
+uint64_t std_cycles(void);
\ No newline at end of file
@@ -1,3 +1,5 @@
+#define _DEFAULT_SOURCE   // fdopen sysconf MAP_ANONYMOUS madvise
+
 #include "os.h"
 
 #include <stdio.h>
@@ -5,6 +7,17 @@
 #include <stdlib.h>
 #include <sys/stat.h>   // open fdopen
 #include <fcntl.h>      // O_CREAT O_RDWR
+#include <unistd.h>     // sysconf close
+#include <sys/mman.h>   // mmap madvise
+#include <pthread.h>
+#include <time.h>           // clock_gettime
+#include <sys/resource.h>   // getrusage
+#include <string.h>         // strerror
+#include <errno.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
 
 void _Noreturn std_exit(int code)
 {
@@ -16,31 +29,107 @@ int std_vfprintf(void *fd, const char *fmt, va_list args)
     return vfprintf(fd, fmt, args);
 }
 
+// Allocations made through std_malloc and std_realloc, for -time-report. Parser workers allocate
+// concurrently so the counters are atomic.
+static uint64_t std_alloc_count;
+static uint64_t std_alloc_bytes;
+
 void* std_realloc(void *ptr, size_t size)
 {
+    __atomic_fetch_add(&std_alloc_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&std_alloc_bytes, size, __ATOMIC_RELAXED);
     return realloc(ptr, size);
 }
 
 void* std_malloc(size_t size)
 {
+    __atomic_fetch_add(&std_alloc_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&std_alloc_bytes, size, __ATOMIC_RELAXED);
     return malloc(size);
 }
 
+void std_allocStats(uint64_t *count, uint64_t *bytes)
+{
+    *count = __atomic_load_n(&std_alloc_count, __ATOMIC_RELAXED);
+    *bytes = __atomic_load_n(&std_alloc_bytes, __ATOMIC_RELAXED);
+}
+
+void std_free(void *ptr)
+{
+    free(ptr);
+}
+
+// Read a whole file into a nul-terminated malloc'd copy. Works on pipes, which cannot be mapped.
 char* std_readFile(const char *filename, long *fsize)
 {
     FILE *fd = fopen(filename, "rb");
     if (!fd) return NULL;
-    fseek(fd, 0, SEEK_END);
-    *fsize = ftell(fd);
-    rewind(fd);
-    char *source = malloc(*fsize + 1);
-    if (!source) return NULL;
-    fread(source, *fsize, 1, fd);
+    size_t len = 0;
+    size_t cap = 4096;
+    char *source = malloc(cap);
+    while (source) {
+        len += fread(source + len, 1, cap - len - 1, fd);
+        if (len + 1 < cap) break;
+        cap *= 2;
+        char *n = realloc(source, cap);
+        if (!n) free(source);
+        source = n;
+    }
     fclose(fd);
-    source[*fsize] = 0;
+    if (!source) return NULL;
+    source[len] = 0;
+    *fsize = len;
     return source;
 }
 
+// Mapping length for a file of fsize bytes. There is always at least one byte past the end of the
+// file, which reads as zero.
+static size_t std_mapLength(size_t fsize)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (fsize + 1 + page - 1) / page * page;
+}
+
+// Map a regular file read-only with a nul sentinel after its last byte. Returns NULL if the file
+// cannot be mapped, in which case std_readFile can be used instead.
+char* std_mapFile(const char *filename, size_t *fsize)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return NULL;
+    }
+
+    // Reserve zeroed pages covering the file and the sentinel, then map the file over the start.
+    // Bytes past the end of the file in its last page are zero-filled by the kernel, and the
+    // reserved page supplies the sentinel when the size is a multiple of the page size.
+    size_t len = std_mapLength(st.st_size);
+    char *data = mmap(NULL, len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    if (st.st_size != 0) {
+        if (mmap(data, st.st_size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(data, len);
+            close(fd);
+            return NULL;
+        }
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    *fsize = st.st_size;
+    return data;
+}
+
+void std_unmapFile(char *data, size_t fsize)
+{
+    munmap(data, std_mapLength(fsize));
+}
+
 void* std_createFile(const char *filename)
 {
     int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
@@ -52,4 +141,132 @@ void* std_createFile(const char *filename)
 size_t std_writeFile(void *ptr, size_t size, size_t nitems, void *fh)
 {
     return fwrite(ptr, size, nitems, fh);
-}
\ No newline at end of file
+}
+
+void std_closeFile(void *fh)
+{
+    if (fclose(fh) != 0) std_panic("failed to write output\n");
+}
+
+typedef struct StdThread {
+    pthread_t handle;
+    void (*fn)(void*);
+    void *arg;
+} StdThread;
+
+static void* std_threadEntry(void *ptr)
+{
+    StdThread *thread = ptr;
+    thread->fn(thread->arg);
+    return NULL;
+}
+
+void* std_threadSpawn(void (*fn)(void*), void *arg)
+{
+    StdThread *thread = malloc(sizeof(StdThread));
+    if (!thread) return NULL;
+    thread->fn = fn;
+    thread->arg = arg;
+    if (pthread_create(&thread->handle, NULL, std_threadEntry, thread) != 0) {
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void std_threadJoin(void *ptr)
+{
+    StdThread *thread = ptr;
+    pthread_join(thread->handle, NULL);
+    free(thread);
+}
+
+uint32_t std_cpuCount(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (uint32_t)n : 1;
+}
+
+uint64_t std_timeNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Peak resident set size of the process in bytes.
+uint64_t std_peakRss(void)
+{
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+    return (uint64_t)ru.ru_maxrss * 1024;   // KiB on Linux
+}
+
+// The counters are opened one by one so that those the cpu or kernel do not support are left out
+// individually. Only user space is counted, which perf_event_paranoid allows by default.
+// Returns NULL with the reason in *error if none could be opened.
+void* std_perfOpen(const char **error)
+{
+#ifdef __linux__
+    static const struct { uint32_t type; uint64_t config; } events[std_perf_count] = {
+        [std_perf_cycles] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        [std_perf_instructions] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        [std_perf_branch_misses] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        [std_perf_l1d_misses] = { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+            | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        [std_perf_llc_misses] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    };
+    int *fds = malloc(sizeof(int) * std_perf_count);
+    if (!fds) return NULL;
+    int opened = 0;
+    int err = 0;
+    for (int i = 0; i < std_perf_count; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[i].type;
+        attr.config = events[i].config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;   // include the parser worker threads
+        fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (fds[i] < 0) err = errno;
+        else opened++;
+    }
+    if (opened == 0) {
+        free(fds);
+        *error = strerror(err);
+        return NULL;
+    }
+    return fds;
+#else
+    *error = "not supported on this platform";
+    return NULL;
+#endif
+}
+
+void std_perfRead(void *perf, uint64_t values[std_perf_count], bool available[std_perf_count])
+{
+#ifdef __linux__
+    int *fds = perf;
+    for (int i = 0; i < std_perf_count; i++) {
+        values[i] = 0;
+        available[i] = fds[i] >= 0 && read(fds[i], &values[i], sizeof(values[i])) == sizeof(values[i]);
+    }
+#else
+    (void)perf;
+    for (int i = 0; i < std_perf_count; i++) {
+        values[i] = 0;
+        available[i] = false;
+    }
+#endif
+}
+
+void std_perfClose(void *perf)
+{
+#ifdef __linux__
+    int *fds = perf;
+    for (int i = 0; i < std_perf_count; i++) if (fds[i] >= 0) close(fds[i]);
+#endif
+    free(perf);
+}
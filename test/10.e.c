@@ -0,0 +1,42 @@
+/* Generated by tzc */
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+int printf(const char* , ...);
+int main(void);
+
+int main(void)
+{
+b0:;
+ int t0 = 2147483647;
+ int t4 = -2147483648;
+ int t5 = 0;
+ int t7 = -1;
+ const char* t9 = "%d\n";
+ int t11 = 1;
+ int t12 = t0 + t11;
+ int t8 = printf(t9,t12);
+ const char* t14 = "%d\n";
+ int t15 = 1;
+ int t16 = 31;
+ int t17 = t15 << t16;
+ int t13 = printf(t14,t17);
+ const char* t19 = "%d\n";
+ int t21 = -t4;
+ int t18 = printf(t19,t21);
+ const char* t23 = "%d\n";
+ int t26 = t0 / t5;
+ int t22 = printf(t23,t26);
+ const char* t28 = "%d\n";
+ int t31 = t4 / t7;
+ int t27 = printf(t28,t31);
+ uint8_t t51 = 0;
+ uint32_t t52 = 0;
+ uint32_t t42 = 1;
+ const char* t44 = "%d %u %u\n";
+ int t43 = printf(t44,t51,t52,t42);
+ int t48 = 0;
+ return t48;
+}
+
@@ -0,0 +1,24 @@
+extern fn printf([*c]const c_char, ...) c_int;
+
+pub fn main() c_int {
+    const max: c_int = 2147483647;
+    const min: c_int = -max - 1;
+    const zero: c_int = 0;
+    const minus_one: c_int = -1;
+
+    // undefined in C, left for the C compiler
+    _ = printf("%d\n", max + 1);
+    _ = printf("%d\n", 1 << 31);
+    _ = printf("%d\n", -min);
+    _ = printf("%d\n", max / zero);
+    _ = printf("%d\n", min / minus_one);
+
+    // unsigned types wrap, so these still fold
+    const a: u8 = 255;
+    const b: u32 = 4294967295;
+    const c: u8 = a + 1;
+    const d: u32 = b + 1;
+    const e: u32 = 0 - b;
+    _ = printf("%d %u %u\n", c, d, e);
+    return 0;
+}
@@ -0,0 +1,55 @@
+/* Generated by tzc */
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+int printf(const char* , ...);
+int main(void);
+
+int main(void)
+{
+ int v0; // i
+ int v1; // sum
+ int v2; // sum
+ int v3; // spill
+b0:;
+ int t0 = 0;
+ int t1 = 0;
+ v1 = t1;
+ v0 = t0;
+b1:;
+ int t21 = v0;
+ int t23 = v1;
+ int t3 = 10;
+ int t4 = t21 < t3;
+ if (t4) { goto b2; } else { goto b4; }
+b2:;
+ int t6 = 5;
+ int t7 = t21 < t6;
+ if (t7) { goto b5; } else { goto b6; }
+b3:;
+ int t24 = v3;
+ int t14 = 1;
+ int t16 = t21 + t14;
+ v1 = t24;
+ v0 = t16;
+ goto b1;
+b4:;
+ const char* t18 = "%d\n";
+ int t17 = printf(t18,t23);
+ int t20 = 0;
+ return t20;
+b5:;
+ int t10 = t23 + t21;
+ v2 = t10;
+ goto b7;
+b6:;
+ int t12 = 2;
+ int t13 = t23 + t12;
+ v2 = t13;
+b7:;
+ int t22 = v2;
+ v3 = t22;
+ goto b3;
+}
+
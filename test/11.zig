@@ -0,0 +1,15 @@
+extern fn printf([*c]const c_char, ...) c_int;
+
+pub fn main() c_int {
+    var i: c_int = 0;
+    var sum: c_int = 0;
+    while (i < 10) : (i += 1) {
+        if (i < 5) {
+            sum = sum + i;
+        } else {
+            sum = sum + 2;
+        }
+    }
+    _ = printf("%d\n", sum);
+    return 0;
+}
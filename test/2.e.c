@@ -13,6 +13,5 @@ b0:;
  int t0 = puts(t1);
  int t2 = 0;
  return t2;
-b1:;
- }
+}
 
@@ -14,6 +14,5 @@ b0:;
  int t0 = printf(t1,t2);
  int t3 = 0;
  return t3;
-b1:;
- }
+}
 
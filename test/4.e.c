@@ -12,26 +12,20 @@ int main(void)
 b0:;
  int t0 = 0;
  v0 = t0;
- b1:;
- int t1 = v0;
+b1:;
+ int t11 = v0;
  int t2 = 10;
- int t3 = t1 < t2;
- if (t3) { goto b2; } else { goto b4; }
+ int t3 = t11 < t2;
+ if (t3) { goto b2; } else { goto b3; }
 b2:;
  const char* t5 = "Hello %d!\n";
- int t6 = v0;
- int t4 = printf(t5,t6);
- goto b3;
-b3:;
+ int t4 = printf(t5,t11);
  int t7 = 1;
- int t8 = v0;
- int t9 = t8 + t7;
+ int t9 = t11 + t7;
  v0 = t9;
  goto b1;
-b4:;
- b5:;
+b3:;
  int t10 = 0;
  return t10;
-b6:;
- }
+}
 
@@ -12,24 +12,18 @@ int tryAdd(uint8_t a, uint8_t b)
  uint8_t v0 = a; // a
  uint8_t v1 = b; // b
 b0:;
- uint8_t t0 = v0;
+ uint8_t t7 = v0;
+ uint8_t t8 = v1;
  int t1 = 0;
- int t2 = t0 == t1;
+ int t2 = t7 == t1;
  if (t2) { goto b1; } else { goto b2; }
 b1:;
  int t3 = 0;
  return t3;
 b2:;
- goto b3;
-b3:;
- uint8_t t4 = v0;
- uint8_t t5 = v1;
- uint8_t t6 = t4 + t5;
+ uint8_t t6 = t7 + t8;
  return t6;
-b4:;
- goto b3;
-b5:;
- }
+}
 
 int main(void)
 {
@@ -41,6 +35,5 @@ b0:;
  int t0 = printf(t1,t2);
  int t5 = 0;
  return t5;
-b1:;
- }
+}
 
@@ -12,25 +12,22 @@ int tryAdd(uint8_t a, uint8_t b)
  uint8_t v0 = a; // a
  uint8_t v1 = b; // b
 b0:;
+ uint8_t t8 = v0;
+ uint8_t t9 = v1;
  int t0 = 0;
- uint8_t t1 = v0;
  int t2 = 0;
- int t3 = t1 == t2;
+ int t3 = t8 == t2;
  if (t3) { goto b1; } else { goto b2; }
 b1:;
  int t4 = 0;
  t0 = t4;
  goto b3;
 b2:;
- uint8_t t5 = v0;
- uint8_t t6 = v1;
- uint8_t t7 = t5 + t6;
+ uint8_t t7 = t8 + t9;
  t0 = t7;
- goto b3;
 b3:;
  return t0;
-b4:;
- }
+}
 
 int main(void)
 {
@@ -42,6 +39,5 @@ b0:;
  int t0 = printf(t1,t2);
  int t5 = 0;
  return t5;
-b1:;
- }
+}
 
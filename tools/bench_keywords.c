@@ -0,0 +1,112 @@
+// Measures the cost of keyword lookup per identifier, comparing Tokenizer_getKeyword against the
+// linear scan over keywords[] that it replaced.
+//
+// The input mixes keywords, common identifiers and near misses (keywords with a byte changed,
+// added or dropped), about one keyword for every three identifiers.
+//
+//   cc -std=c99 -O2 -o bench_keywords tools/bench_keywords.c src/os.c
+//   ./bench_keywords [lookups]
+
+#include "../src/os.h"
+#include "../src/core.h"
+
+#include "../src/Ctx.h"
+#include "../src/TokenizerKeywords.h"
+#include "../src/Tokenizer.h"
+
+#define KEYWORDS_LEN (sizeof(keywords) / sizeof(keywords[0]))
+#define WORDS_LEN 4096
+
+static const char *identifiers[] = {
+    "a", "b", "i", "n", "x", "ok", "it", "std", "len", "ptr", "buf", "err", "self", "node", "data",
+    "item", "list", "size", "index", "value", "token", "items", "count", "result", "buffer", "parser",
+    "allocator", "tokenizer", "ArrayList", "HashMap", "u8", "usize", "c_int", "printf", "init",
+    "deinit", "append", "iterator", "constant", "variable", "structure", "returned", "format",
+};
+
+static uint32_t bench_seed = 0x9e3779b9u;
+
+static uint32_t Bench_random(void)
+{
+    bench_seed ^= bench_seed << 13;
+    bench_seed ^= bench_seed >> 17;
+    bench_seed ^= bench_seed << 5;
+    return bench_seed;
+}
+
+// A keyword with one byte changed, added or dropped, which is not itself a keyword.
+static Buffer Bench_nearMiss(const char *kw, char *out)
+{
+    uint32_t len = (uint32_t)std_strlen(kw);
+    uint32_t at = Bench_random() % len;
+    std_memcpy(out, kw, len);
+    switch (Bench_random() % 3) {
+        case 0:
+            out[at] = out[at] == 'z' ? 'a' : out[at] + 1;
+            break;
+        case 1:
+            out[len++] = 's';
+            break;
+        case 2:
+            if (len > 2) std_memcpy(out + at, kw + at + 1, --len - at);
+            else out[len++] = '_';
+            break;
+    }
+    return (Buffer){ .data = out, .len = len };
+}
+
+static int Bench_linear(Buffer b)
+{
+    for (size_t i = 0; i < KEYWORDS_LEN; i++) {
+        if (Buffer_eql(b, keywords[i].literal)) return keywords[i].tag;
+    }
+    return -1;
+}
+
+static double Bench_run(int (*lookup)(Buffer), const Buffer *words, uint64_t lookups, int64_t *sum)
+{
+    uint64_t start = std_timeNs();
+    int64_t s = 0;
+    for (uint64_t i = 0; i < lookups; i++) s += lookup(words[i % WORDS_LEN]);
+    *sum = s;
+    return (double)(std_timeNs() - start) / lookups;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t lookups = argc > 1 ? (uint64_t)Buffer_toInt((Buffer){ .data = argv[1], .len = std_strlen(argv[1]) }, 10) : 50000000;
+    if (lookups == 0) std_panic("bench_keywords [lookups]\n");
+
+    static char storage[WORDS_LEN][16];
+    static Buffer words[WORDS_LEN];
+    uint32_t counts[3] = { 0 };
+    for (uint32_t i = 0; i < WORDS_LEN; i++) {
+        uint32_t kind = Bench_random() % 4;
+        if (kind == 0) {
+            const char *kw = keywords[Bench_random() % KEYWORDS_LEN].literal;
+            words[i] = (Buffer){ .data = (char *)kw, .len = (uint32_t)std_strlen(kw) };
+        } else if (kind == 1) {
+            words[i] = Bench_nearMiss(keywords[Bench_random() % KEYWORDS_LEN].literal, storage[i]);
+            if (Bench_linear(words[i]) >= 0) kind = 0;
+        } else {
+            const char *id = identifiers[Bench_random() % (sizeof(identifiers) / sizeof(identifiers[0]))];
+            words[i] = (Buffer){ .data = (char *)id, .len = (uint32_t)std_strlen(id) };
+            kind = 2;
+        }
+        counts[kind]++;
+        if (Tokenizer_getKeyword(words[i]) != Bench_linear(words[i])) {
+            std_panic("lookup mismatch for '"PRIb"'\n", Buffer(words[i]));
+        }
+    }
+
+    int64_t linear_sum, hash_sum;
+    double linear_ns = Bench_run(Bench_linear, words, lookups, &linear_sum);
+    double hash_ns = Bench_run(Tokenizer_getKeyword, words, lookups, &hash_sum);
+    if (linear_sum != hash_sum) std_panic("lookup mismatch\n");
+
+    std_printf("%u keywords, %u near misses, %u identifiers, %llu lookups\n",
+        counts[0], counts[1], counts[2], (unsigned long long)lookups);
+    std_printf("linear scan   %8.2f ns/identifier\n", linear_ns);
+    std_printf("perfect hash  %8.2f ns/identifier\n", hash_ns);
+    return 0;
+}
@@ -0,0 +1,358 @@
+// Generates src/ParserFirst.h from src/grammar.peg.
+//
+// For every rule of the syntactic part of the grammar (everything before the "*** Tokens ***"
+// section) the FIRST set is computed: the token tags a match of the rule can start with, and
+// whether the rule can match without consuming a token at all. The parser uses these to pick an
+// alternative from the current token instead of trying each in turn.
+//
+//   cc -std=c99 -o gen_first tools/gen_first.c src/os.c
+//   ./gen_first src/grammar.peg > src/ParserFirst.h
+
+#include "../src/os.h"
+#include "../src/core.h"
+
+#include "../src/Ctx.h"
+#include "../src/TokenizerKeywords.h"
+#include "../src/Tokenizer.h"
+
+#define RULES_MAX 512
+
+typedef enum PegTag {
+    peg_ident,
+    peg_arrow,      // <-
+    peg_slash,
+    peg_l_paren,
+    peg_r_paren,
+    peg_question,
+    peg_star,
+    peg_plus,
+    peg_bang,
+    peg_amp,
+    peg_dot,
+    peg_literal,    // 'abc' or "abc"
+    peg_class,      // [a-z]
+    peg_end,
+} PegTag;
+
+typedef struct PegToken {
+    PegTag tag;
+    Buffer text;    // for literals, the text between the quotes
+} PegToken;
+DEFINE_ARRAY(PegToken)
+
+typedef struct Rule {
+    Buffer name;
+    uint32_t body;          // first token of the body
+    uint32_t body_end;
+    bool lexical;           // defined in the tokens section
+    bool terminal;          // a lexical rule the tokenizer emits as a token
+    TokenSet first;
+    bool nullable;
+} Rule;
+
+typedef struct Gen {
+    PegTokenArray tokens;
+    Rule rules[RULES_MAX];
+    uint32_t rules_len;
+    uint32_t index;
+    uint32_t end;       // end of the rule body being evaluated
+    bool changed;
+} Gen;
+
+typedef struct First {
+    TokenSet set;
+    bool nullable;
+} First;
+
+static bool Gen_isIdent(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static uint32_t Gen_skipQuoted(Buffer src, uint32_t i, char close)
+{
+    while (i < src.len && src.data[i] != close) i += src.data[i] == '\\' ? 2 : 1;
+    if (i >= src.len) std_panic("unterminated literal in grammar\n");
+    return i;
+}
+
+static void Gen_lex(Gen *g, Buffer src)
+{
+    PegTokenArray_init(&g->tokens);
+    uint32_t i = 0;
+    while (i < src.len) {
+        char c = src.data[i];
+        uint32_t start = i;
+        PegTag tag;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            i++;
+            continue;
+        } else if (c == '#') {
+            // the section comment splits syntax rules from token rules
+            while (i < src.len && src.data[i] != '\n') i++;
+            Buffer comment = Buffer_slice(src, start, i);
+            if (Buffer_eql(comment, "# *** Tokens ***")) {
+                PegTokenArray_append(&g->tokens, (PegToken){ .tag = peg_end, .text = comment });
+            }
+            continue;
+        } else if (Gen_isIdent(c)) {
+            while (i < src.len && Gen_isIdent(src.data[i])) i++;
+            tag = peg_ident;
+        } else if (c == '<' && src.data[i + 1] == '-') {
+            i += 2;
+            tag = peg_arrow;
+        } else if (c == '\'' || c == '"') {
+            i = Gen_skipQuoted(src, i + 1, c) + 1;
+            PegTokenArray_append(&g->tokens, (PegToken){
+                .tag = peg_literal,
+                .text = Buffer_slice(src, start + 1, i - 1),
+            });
+            continue;
+        } else if (c == '[') {
+            i = Gen_skipQuoted(src, i + 1, ']') + 1;
+            tag = peg_class;
+        } else {
+            i++;
+            switch (c) {
+                case '/': tag = peg_slash; break;
+                case '(': tag = peg_l_paren; break;
+                case ')': tag = peg_r_paren; break;
+                case '?': tag = peg_question; break;
+                case '*': tag = peg_star; break;
+                case '+': tag = peg_plus; break;
+                case '!': tag = peg_bang; break;
+                case '&': tag = peg_amp; break;
+                case '.': tag = peg_dot; break;
+                default: std_panic("unexpected character '%c' in grammar\n", c);
+            }
+        }
+        PegTokenArray_append(&g->tokens, (PegToken){ .tag = tag, .text = Buffer_slice(src, start, i) });
+    }
+}
+
+// A rule starts at an identifier followed by '<-' and runs up to the next rule.
+static void Gen_splitRules(Gen *g)
+{
+    bool lexical = false;
+    PegToken *t = g->tokens.data;
+    for (uint32_t i = 0; i < g->tokens.len; i++) {
+        if (t[i].tag == peg_end) {
+            if (g->rules_len > 0) g->rules[g->rules_len - 1].body_end = i;
+            lexical = true;
+            continue;
+        }
+        if (t[i].tag != peg_ident || i + 1 >= g->tokens.len || t[i + 1].tag != peg_arrow) continue;
+
+        if (g->rules_len > 0 && !g->rules[g->rules_len - 1].body_end) g->rules[g->rules_len - 1].body_end = i;
+        if (g->rules_len == RULES_MAX) std_panic("too many rules\n");
+        g->rules[g->rules_len++] = (Rule){ .name = t[i].text, .body = i + 2, .lexical = lexical };
+        i++;
+    }
+    if (g->rules_len > 0) g->rules[g->rules_len - 1].body_end = g->tokens.len;
+}
+
+static Rule* Gen_findRule(Gen *g, Buffer name)
+{
+    for (uint32_t i = 0; i < g->rules_len; i++) {
+        if (Buffer_eqlBuffer(g->rules[i].name, name)) return &g->rules[i];
+    }
+    std_panic("undefined rule '"PRIb"'\n", Buffer(name));
+}
+
+static void TokenSet_add(TokenSet *s, TokenTag tag)
+{
+    s->bits[tag >> 6] |= (uint64_t)1 << (tag & 63);
+}
+
+static void TokenSet_merge(TokenSet *s, TokenSet o)
+{
+    s->bits[0] |= o.bits[0];
+    s->bits[1] |= o.bits[1];
+}
+
+// Token rules that are not spelled as a single literal. skip is whitespace and comments, which
+// the tokenizer drops, so it matches nothing at the token level.
+static const struct { const char *name; TokenTag tags[2]; uint32_t tags_len; } gen_token_classes[] = {
+    { "skip", { 0 }, 0 },
+    { "eof", { token_eof }, 1 },
+    { "container_doc_comment", { token_container_doc_comment }, 1 },
+    { "doc_comment", { token_doc_comment }, 1 },
+    { "CHAR_LITERAL", { token_char_literal }, 1 },
+    { "FLOAT", { token_number_literal }, 1 },
+    { "INTEGER", { token_number_literal }, 1 },
+    { "STRINGLITERALSINGLE", { token_string_literal }, 1 },
+    { "STRINGLITERAL", { token_string_literal, token_multiline_string_literal_line }, 2 },
+    { "IDENTIFIER", { token_identifier }, 1 },
+    { "BUILTINIDENTIFIER", { token_builtin }, 1 },
+};
+
+// Resolve a token rule referenced from the syntax rules. Rules spelled as a literal, such as
+// LBRACE <- '{' skip, are run through the tokenizer to find their tag. Some literals are more
+// than one token to the tokenizer ('.?' is a period then a question mark), only the first counts.
+static void Gen_resolveToken(Gen *g, Rule *r)
+{
+    if (r->terminal) return;
+    r->terminal = true;
+
+    for (size_t i = 0; i < sizeof(gen_token_classes) / sizeof(gen_token_classes[0]); i++) {
+        if (!Buffer_eql(r->name, gen_token_classes[i].name)) continue;
+        for (uint32_t j = 0; j < gen_token_classes[i].tags_len; j++) {
+            TokenSet_add(&r->first, gen_token_classes[i].tags[j]);
+        }
+        r->nullable = gen_token_classes[i].tags_len == 0;
+        return;
+    }
+
+    PegToken lit = g->tokens.data[r->body];
+    if (lit.tag != peg_literal) std_panic("token rule '"PRIb"' is not a literal\n", Buffer(r->name));
+
+    char text[32] = { 0 };
+    if (lit.text.len + 1 > sizeof(text)) std_panic("token literal too long\n");
+    std_memcpy(text, lit.text.data, lit.text.len);
+    text[lit.text.len] = 0;
+
+    Tokenizer t;
+    Tokenizer_init(&t, NULL, (Buffer){ .data = text, .len = lit.text.len });
+    Token token = Tokenizer_next(&t);
+    if (token.tag == token_invalid) std_panic("token rule '"PRIb"' does not lex\n", Buffer(r->name));
+    TokenSet_add(&r->first, token.tag);
+    r->nullable = false;
+}
+
+static First Gen_alt(Gen *g);
+
+// Primary <- IDENT / '(' Alt ')' / literal / class / '.'
+static First Gen_primary(Gen *g)
+{
+    PegToken t = g->tokens.data[g->index++];
+    switch (t.tag) {
+        case peg_ident: {
+            Rule *r = Gen_findRule(g, t.text);
+            if (r->lexical) Gen_resolveToken(g, r);
+            return (First){ .set = r->first, .nullable = r->nullable };
+        }
+        case peg_l_paren: {
+            First f = Gen_alt(g);
+            if (g->tokens.data[g->index++].tag != peg_r_paren) std_panic("expected ')' in grammar\n");
+            return f;
+        }
+        default:
+            std_panic("unexpected '"PRIb"' in syntax rule\n", Buffer(t.text));
+    }
+}
+
+// Suffixed <- ('!' / '&')? Primary ('?' / '*' / '+')?
+static First Gen_suffixed(Gen *g)
+{
+    PegTag prefix = g->tokens.data[g->index].tag;
+    if (prefix == peg_bang || prefix == peg_amp) g->index++;
+
+    First f = Gen_primary(g);
+    PegTag suffix = g->tokens.data[g->index].tag;
+    if (suffix == peg_question || suffix == peg_star || suffix == peg_plus) g->index++;
+
+    // predicates consume nothing
+    if (prefix == peg_bang || prefix == peg_amp) return (First){ .nullable = true };
+    if (suffix == peg_question || suffix == peg_star) f.nullable = true;
+    return f;
+}
+
+static bool Gen_atSeqEnd(Gen *g)
+{
+    if (g->index >= g->end) return true;
+    PegTag tag = g->tokens.data[g->index].tag;
+    return tag == peg_slash || tag == peg_r_paren;
+}
+
+// Seq <- Suffixed*
+static First Gen_seq(Gen *g)
+{
+    First f = { .nullable = true };
+    while (!Gen_atSeqEnd(g)) {
+        First e = Gen_suffixed(g);
+        if (f.nullable) TokenSet_merge(&f.set, e.set);
+        f.nullable = f.nullable && e.nullable;
+    }
+    return f;
+}
+
+// Alt <- Seq ('/' Seq)*
+static First Gen_alt(Gen *g)
+{
+    First f = Gen_seq(g);
+    while (g->index < g->end && g->tokens.data[g->index].tag == peg_slash) {
+        g->index++;
+        First e = Gen_seq(g);
+        TokenSet_merge(&f.set, e.set);
+        f.nullable = f.nullable || e.nullable;
+    }
+    return f;
+}
+
+static void Gen_rule(Gen *g, Rule *r)
+{
+    g->index = r->body;
+    g->end = r->body_end;
+    First f = Gen_alt(g);
+    if (g->index != r->body_end) std_panic("trailing tokens in rule '"PRIb"'\n", Buffer(r->name));
+
+    TokenSet_merge(&f.set, r->first);
+    f.nullable = f.nullable || r->nullable;
+    if (f.nullable != r->nullable || f.set.bits[0] != r->first.bits[0] || f.set.bits[1] != r->first.bits[1]) {
+        g->changed = true;
+    }
+    r->first = f.set;
+    r->nullable = f.nullable;
+}
+
+static void Gen_emit(Gen *g)
+{
+    std_printf("// Generated by tools/gen_first.c from src/grammar.peg, do not edit.\n");
+    std_printf("//\n");
+    std_printf("// FIRST set of each syntax rule: the tokens a match can start with. A nullable rule can also\n");
+    std_printf("// match nothing, so a token outside its set does not rule it out.\n");
+
+    for (uint32_t i = 0; i < g->rules_len; i++) {
+        Rule *r = &g->rules[i];
+        if (r->lexical) continue;
+
+        std_printf("\n// "PRIb"%s:", Buffer(r->name), r->nullable ? " (nullable)" : "");
+        uint32_t column = 4 + r->name.len + (r->nullable ? 11 : 0);
+        for (uint32_t tag = 0; tag <= token_keyword_while; tag++) {
+            if (!TokenSet_has(r->first, tag)) continue;
+            const char *name = TokenTag_name(tag);
+            uint32_t len = (uint32_t)std_strlen(name);
+            if (column + len + 1 > 96) {
+                std_printf("\n//    ");
+                column = 6;
+            }
+            std_printf(" %s", name);
+            column += len + 1;
+        }
+        std_printf("\n__attribute__((unused))\nstatic const TokenSet first_"PRIb" = {{ 0x%016llxull, 0x%016llxull }};\n",
+            Buffer(r->name), (unsigned long long)r->first.bits[0], (unsigned long long)r->first.bits[1]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        std_printf("gen_first <grammar.peg>\n");
+        std_exit(1);
+    }
+
+    static Gen g;
+    Gen_lex(&g, Buffer_fromFile(argv[1]));
+    Gen_splitRules(&g);
+
+    // FIRST sets of recursive rules depend on each other, iterate until nothing grows.
+    do {
+        g.changed = false;
+        for (uint32_t i = 0; i < g.rules_len; i++) {
+            if (!g.rules[i].lexical) Gen_rule(&g, &g.rules[i]);
+        }
+    } while (g.changed);
+
+    Gen_emit(&g);
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Generates src/TokenizerKeywords.h from keywords[] in src/Tokenizer.h.
+//
+// Tokenizer_keywordKey gives each keyword a distinct 32-bit key. This searches for a multiplier
+// such that the top bits of key * multiplier differ for every keyword, using the fewest bits
+// that a multiplier can be found for, and emits the multiplier along with the slot table that
+// Tokenizer_getKeyword indexes with it. Rerun it whenever keywords[] changes.
+//
+//   cc -std=c99 -o gen_keywords tools/gen_keywords.c src/os.c
+//   ./gen_keywords > src/TokenizerKeywords.h
+
+#include "../src/os.h"
+#include "../src/core.h"
+
+#include "../src/Ctx.h"
+#include "../src/TokenizerKeywords.h"
+#include "../src/Tokenizer.h"
+
+#define KEYWORDS_LEN (sizeof(keywords) / sizeof(keywords[0]))
+#define SEARCH_TRIES (1u << 20)
+
+static Buffer Gen_keyword(uint32_t i)
+{
+    return (Buffer){ .data = (char *)keywords[i].literal, .len = (uint32_t)std_strlen(keywords[i].literal) };
+}
+
+// Fill slots with the keywords[] index + 1 of each hash, or return false on a collision.
+static bool Gen_try(const uint32_t *keys, uint32_t mul, uint32_t bits, uint8_t *slots)
+{
+    for (uint32_t i = 0; i < (1u << bits); i++) slots[i] = 0;
+    for (uint32_t i = 0; i < KEYWORDS_LEN; i++) {
+        uint32_t h = keys[i] * mul >> (32 - bits);
+        if (slots[h]) return false;
+        slots[h] = (uint8_t)(i + 1);
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    (void)argv;
+    if (argc != 1) {
+        std_printf("gen_keywords\n");
+        std_exit(1);
+    }
+    if (KEYWORDS_LEN > 255) std_panic("too many keywords for uint8_t slots\n");
+
+    uint32_t keys[KEYWORDS_LEN];
+    uint32_t min_len = UINT32_MAX, max_len = 0;
+    for (uint32_t i = 0; i < KEYWORDS_LEN; i++) {
+        Buffer kw = Gen_keyword(i);
+        if (kw.len < 2) std_panic("keyword '%s' is too short to hash\n", keywords[i].literal);
+        keys[i] = Tokenizer_keywordKey(kw);
+        for (uint32_t j = 0; j < i; j++) {
+            if (keys[j] == keys[i]) {
+                std_panic("'%s' and '%s' have the same key, change Tokenizer_keywordKey\n",
+                    keywords[j].literal, keywords[i].literal);
+            }
+        }
+        if (kw.len < min_len) min_len = kw.len;
+        if (kw.len > max_len) max_len = kw.len;
+    }
+
+    uint32_t bits = 1;
+    while ((1u << bits) < KEYWORDS_LEN) bits++;
+
+    // xorshift32 with a fixed seed, so the output only changes with the keywords
+    static uint8_t slots[1 << 16];
+    uint32_t mul = 0;
+    for (; bits <= 16; bits++) {
+        uint32_t x = 0x9e3779b9u;
+        uint32_t tries = 0;
+        for (; tries < SEARCH_TRIES; tries++) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            if (Gen_try(keys, x | 1, bits, slots)) break;
+        }
+        if (tries < SEARCH_TRIES) {
+            mul = x | 1;
+            break;
+        }
+    }
+    if (mul == 0) std_panic("no multiplier found\n");
+
+    std_printf("// Generated by tools/gen_keywords.c from keywords[] in src/Tokenizer.h, do not edit.\n");
+    std_printf("//\n");
+    std_printf("// The top %u bits of Tokenizer_keywordKey * KEYWORD_HASH_MUL differ for every keyword.\n", bits);
+    std_printf("// keyword_slots holds the keywords[] index + 1 of each hash, 0 if no keyword has it.\n");
+    std_printf("#define KEYWORD_MIN_LEN %u\n", min_len);
+    std_printf("#define KEYWORD_MAX_LEN %u\n", max_len);
+    std_printf("#define KEYWORD_HASH_MUL 0x%08xu\n", mul);
+    std_printf("#define KEYWORD_HASH_BITS %u\n", bits);
+    std_printf("\nstatic const uint8_t keyword_slots[1 << KEYWORD_HASH_BITS] = {");
+    for (uint32_t i = 0; i < (1u << bits); i++) {
+        std_printf(i % 16 == 0 ? "\n    %2u," : " %2u,", slots[i]);
+    }
+    std_printf("\n};\n");
+    return 0;
+}